@@ -0,0 +1,138 @@
+#include "AiTask.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMetaObject>
+#include <QPointer>
+#include <QThread>
+#include <QThreadPool>
+#include <QDebug>
+
+#include "GameEngine.h"
+#include "NPCPlayer.h"
+#include "RngStream.h"
+#include "SettingsManager.h"
+#include "Team.h"
+#include "Zobrist.h"
+
+namespace {
+    const int kSleepSliceMs = 10; // 等待最短思考时间时每次休眠的时长，便于及时响应取消
+
+    // 把一个整数混入键中(splitmix64的混合步骤)
+    quint64 mixKey(quint64 key, quint64 value)
+    {
+        quint64 z = key ^ (value + 0x9E3779B97F4A7C15ULL + (key << 6) + (key >> 2));
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+}
+
+AiTask::Handle AiTask::start(const Snapshot& snapshot, QObject* receiver, Callback onFinished)
+{
+    Handle handle = Handle::create(false);
+    QPointer<QObject> guard(receiver);
+
+    // 选牌任务放在Qt全局线程池，搜索的模拟放在Rollout::threadPool()：
+    // 选牌任务会阻塞等待模拟完成，两者共用一个线程池可能互相占满而死锁
+    QThreadPool::globalInstance()->start([snapshot, handle, guard, onFinished]() {
+        QElapsedTimer timer;
+        timer.start();
+        Rollout::SearchStats stats;
+        const QVector<Card> cards = decide(snapshot, handle.data(), &stats);
+        const bool searched = stats.searched;
+        while (!handle->load() && timer.elapsed() < snapshot.minDurationMs) {
+            QThread::msleep(kSleepSliceMs);
+        }
+        if (handle->load()) return;
+
+        // 取消标志和接收者都在主线程中再检查一次，取消与交回同时发生时以取消为准
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [handle, guard, onFinished, cards, searched]() {
+            if (handle->load() || !guard) return;
+            onFinished(handle, cards, searched);
+        }, Qt::QueuedConnection);
+    });
+    return handle;
+}
+
+void AiTask::cancel(const Handle& handle)
+{
+    if (handle) handle->store(true);
+}
+
+bool AiTask::isCancelled(const Handle& handle)
+{
+    return !handle || handle->load();
+}
+
+quint64 AiTask::snapshotKey(const Snapshot& snapshot)
+{
+    const Rollout::Situation& info = snapshot.publicInfo;
+    const int seat = qBound(0, snapshot.playerId, Rollout::SEAT_COUNT - 1);
+    const LevelContext ctx(snapshot.levelRank);
+
+    // 手牌和一圈的状态沿用搜索的Zobrist键；领出时没有圈首
+    const bool leading = snapshot.tableCombo.type == CardComboType::Invalid;
+    quint64 key = Zobrist::handKey(seat, ComboCatalog::HandCounts::fromHand(CardSet(snapshot.hand), ctx))
+        ^ Zobrist::circleKey(snapshot.tableCombo.type, snapshot.tableCombo.level, leading ? -1 : info.tableOwner, 0, seat);
+
+    // 公开信息只在两次快照之间有人出牌时改变，出过的牌数、各家剩余张数和名次足以区分
+    key = mixKey(key, static_cast<quint64>(info.playedCards.size()));
+    for (int i = 0; i < Rollout::SEAT_COUNT; ++i) key = mixKey(key, static_cast<quint64>(info.handCounts[i]));
+    for (int finished : info.finishOrder) key = mixKey(key, static_cast<quint64>(finished) + 1);
+    key = mixKey(key, static_cast<quint64>(snapshot.levelRank));
+    key = mixKey(key, static_cast<quint64>(snapshot.difficulty));
+    key = mixKey(key, static_cast<quint64>(snapshot.budgetMs));
+    key = mixKey(key, static_cast<quint64>(snapshot.threadCount));
+    return key;
+}
+
+AiTask::Snapshot AiTask::makeSnapshot(const GameEngine& engine, int playerId, int difficulty,
+    const CardCombo::ComboInfo& table, int tableOwner)
+{
+    Snapshot snapshot;
+    Player* player = engine.player(playerId);
+    if (!player) return snapshot;
+    snapshot.playerId = playerId;
+    snapshot.hand = player->getHandCards();
+    snapshot.levelRank = player->getLevelContext().levelRank();
+    snapshot.tableCombo = table;
+    snapshot.difficulty = difficulty;
+    snapshot.seed = engine.seed();
+
+    // 公开信息也参与快照的键，普通难度同样填写
+    Rollout::Situation& info = snapshot.publicInfo;
+    info.playedCards = engine.playedCards();
+    for (int seat = 0; seat < Rollout::SEAT_COUNT; ++seat) {
+        info.handCounts[seat] = engine.handCardCount(seat);
+    }
+    info.finishOrder = engine.roundFinishOrder();
+    info.tableOwner = table.type == CardComboType::Invalid ? -1 : tableOwner;
+    return snapshot;
+}
+
+QVector<Card> AiTask::decide(const Snapshot& snapshot, const std::atomic<bool>* cancel, Rollout::SearchStats* stats)
+{
+    if (stats) *stats = Rollout::SearchStats();
+    // 在本线程中建立只属于本任务的队伍和玩家，不与界面线程共享对象
+    Team team(-1);
+    team.setCurrentLevelRank(snapshot.levelRank);
+    NPCPlayer ai(QStringLiteral("AiTask"), snapshot.playerId);
+    ai.setTeam(&team);
+
+    QVector<Card> hand = snapshot.hand;
+    for (Card& card : hand) {
+        card.setOwner(&ai);
+    }
+    ai.setHandCards(hand);
+    if (hand.isEmpty()) return {};
+
+    if (snapshot.difficulty >= SettingsManager::AiHard) {
+        // 搜索的随机数只取决于比赛种子和局面：同一场比赛重放时，同一局面得到同样的随机数
+        const bool treeSearch = snapshot.difficulty == SettingsManager::AiExpert;
+        const quint64 seed = RngStream(snapshot.seed).split(snapshotKey(snapshot)).next();
+        return ai.getSearchPlay(snapshot.tableCombo, snapshot.publicInfo, treeSearch,
+            snapshot.budgetMs, snapshot.threadCount, seed, cancel, stats);
+    }
+    return ai.getBestPlay(snapshot.tableCombo);
+}
@@ -0,0 +1,65 @@
+#ifndef AITASK_H
+#define AITASK_H
+
+// AiTask: 在工作线程中完成一次AI选牌，搜索和枚举出牌不再阻塞界面线程
+// 任务只读取提交时拍下的局面快照，不访问控制器和玩家对象；结果以排队调用交回主线程
+// 任务可以取消：搜索在下一次检查时间预算时提前结束，已取消任务的结果直接丢弃
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QVector>
+#include <atomic>
+#include <functional>
+
+#include "Card.h"
+#include "Cardcombo.h"
+#include "Rollout.h"
+
+class GameEngine;
+
+class AiTask
+{
+public:
+    // 选牌所需的局面快照，提交后不再改变
+    struct Snapshot {
+        int playerId = -1;
+        QVector<Card> hand;                       // 决策者手牌
+        Card::CardPoint levelRank = Card::Card_2; // 决策者队伍的级牌
+        CardCombo::ComboInfo tableCombo;          // 需要压过的桌面牌型，领出时为Invalid
+        Rollout::Situation publicInfo;            // 对局的公开信息，只有搜索难度使用
+        int difficulty = 0;                       // SettingsManager::AiDifficulty
+        int budgetMs = 0;                         // 搜索的时间预算(毫秒)
+        int threadCount = 0;                      // 搜索线程数，<=0时按CPU核数
+        int minDurationMs = 0;                    // 结果最早在提交多久后交回(模拟思考)
+        quint64 seed = 0;                         // 比赛的随机数种子，搜索由它和局面派生自己的随机数流
+    };
+
+    // 任务句柄：保存取消标志，控制器用它取消任务并识别过期的结果
+    using Handle = QSharedPointer<std::atomic<bool>>;
+    // 结果回调：cards为空表示过牌(或没有可出的牌)；searched为false表示搜索在预算内没有完成任何模拟，
+    // cards是退回的启发式选牌(见decide)
+    using Callback = std::function<void(const Handle&, const QVector<Card>& cards, bool searched)>;
+
+    // 提交任务到全局线程池；完成且未被取消时，在主线程中调用onFinished
+    // receiver在结果交回前被销毁时，结果丢弃
+    static Handle start(const Snapshot& snapshot, QObject* receiver, Callback onFinished);
+
+    // 取消任务，可重复调用；空句柄无操作
+    static void cancel(const Handle& handle);
+    static bool isCancelled(const Handle& handle);
+
+    // 快照的键：决策者、手牌、桌面牌型、公开信息和搜索设置都相同的快照得到相同的键，
+    // 控制器用它把预先思考的结果对应到实际轮到的局面
+    static quint64 snapshotKey(const Snapshot& snapshot);
+
+    // 从引擎中为playerId拍下快照：手牌、级牌和公开信息；table、tableOwner为其面对的桌面牌型和出牌者
+    // 搜索的时间预算和线程数由调用者填写
+    static Snapshot makeSnapshot(const GameEngine& engine, int playerId, int difficulty,
+        const CardCombo::ComboInfo& table, int tableOwner);
+
+    // 在调用线程中执行一次选牌，cancel置位后搜索尽快返回
+    // stats不为空时写入搜索的统计(见NPCPlayer::getSearchPlay)，不搜索的难度kind为None、searched为true
+    static QVector<Card> decide(const Snapshot& snapshot, const std::atomic<bool>* cancel = nullptr, Rollout::SearchStats* stats = nullptr);
+};
+
+#endif // AITASK_H
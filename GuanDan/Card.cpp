@@ -1,45 +1,25 @@
 #include "Card.h"
 #include "Player.h"
 #include "Team.h"
+#include "LevelContext.h"
 
 #include <QDebug>
 
 // 用于返回绝对点数大小
+// 大王16 > 小王15 > 级牌14 > A13 > K12 > ... > 2为1，具体数值见 LevelContext 中的比较表
 int Card::getComparisonValue() const
 {
-    CardPoint currentLevel = getCurrentOwnerLevelRank(); // 使用内部辅助函数
-    // 1. Big Joker (Card_BJ)
-    if (m_point == CardPoint::Card_BJ) {
-        return 16; // Highest
-    }
-    // 2. Little Joker (Card_LJ)
-    if (m_point == CardPoint::Card_LJ) {
-        return 15;
-    }
+    return getComparisonValue(LevelContext(getCurrentOwnerLevelRank())); // 使用内部辅助函数得到级牌
+}
 
-    // 3. CurrentLevel (级牌)
-    if (m_point == currentLevel) {
-        return 14;
-    }
+int Card::getComparisonValue(const LevelContext& ctx) const
+{
+    return ctx.comparisonValue(m_point);
+}
 
-    // 4. Regular cards (其他牌)
-    // The order is A, K, Q, J, 10, 9, 8, 7, 6, 5, 4, 3, 2
-    switch (m_point) {
-    case CardPoint::Card_A:  return 13;
-    case CardPoint::Card_K:  return 12;
-    case CardPoint::Card_Q:  return 11;
-    case CardPoint::Card_J:  return 10;
-    case CardPoint::Card_10: return 9;
-    case CardPoint::Card_9:  return 8;
-    case CardPoint::Card_8:  return 7;
-    case CardPoint::Card_7:  return 6;
-    case CardPoint::Card_6:  return 5;
-    case CardPoint::Card_5:  return 4;
-    case CardPoint::Card_4:  return 3;
-    case CardPoint::Card_3:  return 2;
-    case CardPoint::Card_2:  return 1;
-    default: return -1;
-    }
+bool Card::isWildCard(const LevelContext& ctx) const
+{
+    return ctx.isWildCard(*this);
 }
 
 // 判断是否为癞子牌
@@ -5,6 +5,7 @@
 
 class Player; // 前向定义，使用Player和Team的指针
 class Team;
+class LevelContext;
 
 class Card
 {
@@ -43,6 +44,9 @@ public:
 
     int getComparisonValue() const; // 辅助函数，通过级牌得到比较值大小
     bool isWildCard() const; // 判断是否为癞子牌
+    // 显式传入级牌上下文的版本，查表实现，不经过所有者指针(热路径使用)
+    int getComparisonValue(const LevelContext& ctx) const;
+    bool isWildCard(const LevelContext& ctx) const;
 
     Card();
     Card(CardPoint point, CardSuit suit, Player* owner = nullptr);
@@ -64,8 +68,8 @@ public:
 
     //Card类数据成员为点数、花色、卡牌所有者
 private:
-    CardPoint m_point;
-    CardSuit m_suit;
+    CardPoint m_point = Card_2;
+    CardSuit m_suit = Diamond;
     Player* m_owner = nullptr; // 指向拥有这张牌的玩家
 
     CardPoint getCurrentOwnerLevelRank() const; // 内部调用辅助函数
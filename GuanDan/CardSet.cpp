@@ -0,0 +1,195 @@
+#include "CardSet.h"
+#include "LevelContext.h"
+
+#include <cstring>
+
+CardSet::CardSet()
+{
+    clear();
+}
+
+CardSet::CardSet(const QVector<Card>& cards)
+{
+    clear();
+    add(cards);
+}
+
+void CardSet::clear()
+{
+    std::memset(m_counts, 0, sizeof(m_counts));
+    std::memset(m_rankCounts, 0, sizeof(m_rankCounts));
+    std::memset(m_suitMasks, 0, sizeof(m_suitMasks));
+    m_rankMask = 0;
+    m_size = 0;
+}
+
+void CardSet::add(const Card& card)
+{
+    const int r = rankIndex(card.point());
+    const int s = card.suit();
+    const quint16 bit = static_cast<quint16>(1u << r);
+
+    m_counts[r][s]++;
+    m_rankCounts[r]++;
+    m_suitMasks[s] |= bit;
+    m_rankMask |= bit;
+    m_size++;
+}
+
+void CardSet::add(const QVector<Card>& cards)
+{
+    for (const Card& card : cards) {
+        add(card);
+    }
+}
+
+bool CardSet::remove(const Card& card)
+{
+    const int r = rankIndex(card.point());
+    const int s = card.suit();
+    if (m_counts[r][s] == 0) {
+        return false;
+    }
+
+    const quint16 bit = static_cast<quint16>(1u << r);
+    // 最后一张时清除对应的掩码位
+    if (--m_counts[r][s] == 0) {
+        m_suitMasks[s] &= static_cast<quint16>(~bit);
+    }
+    if (--m_rankCounts[r] == 0) {
+        m_rankMask &= static_cast<quint16>(~bit);
+    }
+    m_size--;
+    return true;
+}
+
+bool CardSet::remove(const CardSet& other)
+{
+    if (!containsAll(other)) {
+        return false;
+    }
+    for (int r = 0; r < RANK_COUNT; ++r) {
+        if (!(other.m_rankMask & (1u << r))) continue;
+        for (int s = 0; s < SUIT_COUNT; ++s) {
+            for (int n = 0; n < other.m_counts[r][s]; ++n) {
+                remove(Card(rankAt(r), static_cast<Card::CardSuit>(s)));
+            }
+        }
+    }
+    return true;
+}
+
+bool CardSet::containsAll(const CardSet& other) const
+{
+    if (other.m_size > m_size || (other.m_rankMask & ~m_rankMask)) {
+        return false;
+    }
+    for (int r = 0; r < RANK_COUNT; ++r) {
+        if (other.m_rankCounts[r] > m_rankCounts[r]) return false;
+        if (!(other.m_rankMask & (1u << r))) continue;
+        for (int s = 0; s < SUIT_COUNT; ++s) {
+            if (other.m_counts[r][s] > m_counts[r][s]) return false;
+        }
+    }
+    return true;
+}
+
+quint16 CardSet::rankMaskAtLeast(int n) const
+{
+    if (n <= 1) return m_rankMask;
+    quint16 mask = 0;
+    for (int r = 0; r < RANK_COUNT; ++r) {
+        if (m_rankCounts[r] >= n) {
+            mask |= static_cast<quint16>(1u << r);
+        }
+    }
+    return mask;
+}
+
+QVector<Card> CardSet::toCards(Player* owner) const
+{
+    QVector<Card> cards;
+    cards.reserve(m_size);
+    for (int r = 0; r < RANK_COUNT; ++r) {
+        if (!(m_rankMask & (1u << r))) continue;
+        for (int s = 0; s < SUIT_COUNT; ++s) {
+            for (int n = 0; n < m_counts[r][s]; ++n) {
+                cards.append(Card(rankAt(r), static_cast<Card::CardSuit>(s), owner));
+            }
+        }
+    }
+    return cards;
+}
+
+QVector<Card> CardSet::cardsOfRank(Card::CardPoint point, Player* owner, const LevelContext* excludeWilds) const
+{
+    QVector<Card> cards;
+    const int r = rankIndex(point);
+    cards.reserve(m_rankCounts[r]);
+    for (int s = 0; s < SUIT_COUNT; ++s) {
+        int n = m_counts[r][s];
+        if (excludeWilds && excludeWilds->isWildCard(Card(point, static_cast<Card::CardSuit>(s)))) n = 0;
+        for (int i = 0; i < n; ++i) {
+            cards.append(Card(point, static_cast<Card::CardSuit>(s), owner));
+        }
+    }
+    return cards;
+}
+
+int CardSet::wildCount(const LevelContext& ctx) const
+{
+    return count(ctx.levelRank(), Card::Heart);
+}
+
+// 比较值的顺序为: 普通点数(2~A，除级牌) < 级牌 < 小王 < 大王，同点数按花色排序
+bool CardSet::highestCard(const LevelContext& ctx, Card& out, Player* owner) const
+{
+    if (m_size == 0) return false;
+
+    Card::CardPoint point;
+    const quint16 levelBit = rankBit(ctx.levelRank());
+    if (m_rankMask & rankBit(Card::Card_BJ)) point = Card::Card_BJ;
+    else if (m_rankMask & rankBit(Card::Card_LJ)) point = Card::Card_LJ;
+    else if (m_rankMask & levelBit) point = ctx.levelRank();
+    else {
+        quint16 normal = m_rankMask & static_cast<quint16>(~levelBit);
+        int top = 0;
+        while (normal >>= 1) ++top;
+        point = rankAt(top);
+    }
+
+    int r = rankIndex(point);
+    int suit = SUIT_COUNT - 1;
+    while (m_counts[r][suit] == 0) --suit;
+    out = Card(point, static_cast<Card::CardSuit>(suit), owner);
+    return true;
+}
+
+bool CardSet::lowestCard(const LevelContext& ctx, Card& out, Player* owner) const
+{
+    if (m_size == 0) return false;
+
+    Card::CardPoint point;
+    const quint16 levelBit = rankBit(ctx.levelRank());
+    const quint16 normal = m_rankMask & static_cast<quint16>(~levelBit)
+        & static_cast<quint16>(~(rankBit(Card::Card_LJ) | rankBit(Card::Card_BJ)));
+    if (normal) {
+        int low = 0;
+        while (!(normal & (1u << low))) ++low;
+        point = rankAt(low);
+    }
+    else if (m_rankMask & levelBit) point = ctx.levelRank();
+    else if (m_rankMask & rankBit(Card::Card_LJ)) point = Card::Card_LJ;
+    else point = Card::Card_BJ;
+
+    int r = rankIndex(point);
+    int suit = 0;
+    while (m_counts[r][suit] == 0) ++suit;
+    out = Card(point, static_cast<Card::CardSuit>(suit), owner);
+    return true;
+}
+
+bool operator==(const CardSet& a, const CardSet& b)
+{
+    return a.m_size == b.m_size && std::memcmp(a.m_counts, b.m_counts, sizeof(a.m_counts)) == 0;
+}
@@ -0,0 +1,71 @@
+#ifndef CARDSET_H
+#define CARDSET_H
+
+// CardSet: 手牌的紧凑表示，供规则引擎和AI使用
+// 内部为 15种点数 x 5种花色 的计数矩阵，并维护每种花色的点数位掩码
+// 成员查询、增删与点数直方图均为O(1)且不分配内存
+
+#include <QVector>
+#include <QtGlobal>
+
+#include "Card.h"
+
+class Player;
+class LevelContext;
+
+class CardSet
+{
+public:
+    static const int RANK_COUNT = 15; // Card_2 ~ Card_BJ
+    static const int SUIT_COUNT = 5;  // Diamond ~ Joker
+
+    CardSet();
+    explicit CardSet(const QVector<Card>& cards);
+
+    // 点数 <-> 下标(位)的转换，Card_2 对应第0位
+    static int rankIndex(Card::CardPoint point) { return static_cast<int>(point) - static_cast<int>(Card::Card_2); }
+    static Card::CardPoint rankAt(int index) { return static_cast<Card::CardPoint>(index + static_cast<int>(Card::Card_2)); }
+    static quint16 rankBit(Card::CardPoint point) { return static_cast<quint16>(1u << rankIndex(point)); }
+    static int bitCount(quint16 mask) { int n = 0; while (mask) { mask &= mask - 1; ++n; } return n; }
+
+    // 增删
+    void add(const Card& card);
+    void add(const QVector<Card>& cards);
+    bool remove(const Card& card); // 集合中没有该牌时返回false
+    bool remove(const CardSet& other); // 只有other完全包含于本集合时才删除
+    void clear();
+
+    // 查询
+    bool contains(const Card& card) const { return count(card.point(), card.suit()) > 0; }
+    bool containsAll(const CardSet& other) const;
+    int count(Card::CardPoint point, Card::CardSuit suit) const { return m_counts[rankIndex(point)][suit]; }
+    int rankCount(Card::CardPoint point) const { return m_rankCounts[rankIndex(point)]; }
+    quint16 suitMask(Card::CardSuit suit) const { return m_suitMasks[suit]; } // 该花色拥有的点数
+    quint16 rankMask() const { return m_rankMask; } // 所有拥有的点数
+    quint16 rankMaskAtLeast(int n) const; // 张数不少于n的点数
+    int distinctRankCount() const { return bitCount(m_rankMask); }
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+    // 与级牌相关的查询，均只用到位掩码和计数，O(1)
+    int wildCount(const LevelContext& ctx) const; // 癞子(红桃级牌)张数
+    bool highestCard(const LevelContext& ctx, Card& out, Player* owner = nullptr) const; // 按级牌顺序最大的牌，空集合返回false
+    bool lowestCard(const LevelContext& ctx, Card& out, Player* owner = nullptr) const;  // 按级牌顺序最小的牌，空集合返回false
+
+    // 按 点数-花色 顺序还原为卡牌数组(不排序，调用者自行按级牌排序)
+    QVector<Card> toCards(Player* owner = nullptr) const;
+    // 还原某一点数的所有牌(花色从小到大)，excludeWilds不为空时跳过该级牌下的癞子
+    QVector<Card> cardsOfRank(Card::CardPoint point, Player* owner = nullptr, const LevelContext* excludeWilds = nullptr) const;
+
+    friend bool operator==(const CardSet& a, const CardSet& b);
+    friend bool operator!=(const CardSet& a, const CardSet& b) { return !(a == b); }
+
+private:
+    quint8 m_counts[RANK_COUNT][SUIT_COUNT]; // 每种点数、花色的张数(两副牌最多为2)
+    quint8 m_rankCounts[RANK_COUNT];         // 每种点数的总张数
+    quint16 m_suitMasks[SUIT_COUNT];         // 每种花色拥有的点数位掩码
+    quint16 m_rankMask;                      // 拥有的点数位掩码
+    int m_size;                              // 总张数
+};
+
+#endif // CARDSET_H
@@ -5,6 +5,10 @@
 #include <functional>
 
 #include "Cardcombo.h"
+#include "CardSet.h"
+#include "ComboTable.h"
+#include "LevelContext.h"
+#include "Player.h"
 
 
 // CardCombo::ComboInfo中的getDescription方法实现(调试函数)
@@ -55,20 +59,6 @@ QString CardCombo::ComboInfo::getDescription() const {
     return desc.trimmed(); // 移除多余空白字符
 }
 
-// 生成牌组的指纹，用于唯一标识牌组
-QString CardCombo::generateComboFingerprint(const QVector<Card>& cards) { // 返回 QString, 参数 QVector
-    QString fingerprint; // 指纹字符串
-    QVector<Card> sorted_cards = cards;
-    std::sort(sorted_cards.begin(), sorted_cards.end());
-
-    // 取点数和花色生成指纹
-    for (const auto& card : sorted_cards) {
-        fingerprint += QString::number(static_cast<int>(card.point())) + "-" +
-            QString::number(static_cast<int>(card.suit())) + ";";
-    }
-    return fingerprint;
-}
-
 int CardCombo::getSequentialOrder(Card::CardPoint p, bool ace_as_high_in_straight)
 {
     switch (p) {
@@ -168,33 +158,22 @@ bool CardCombo::checkConsecutive(const QVector<Card::CardPoint>& distinct_points
 // 匿名命名空间，给evaluateConcreteCombo提供辅助函数
 namespace {
 
-    // 获取点数的比较值
-    int get_point_comparison_value(Card::CardPoint p, Player* ctx, Card::CardSuit suit_for_card_obj = Card::CardSuit::Spade)
-    { // 只获得点数的比较值，取花色相同即可
-        if (!ctx) {
-            qWarning() << "get_point_comparison_value: Null player context!";
-            return -1;
-        }
-        // 通过构造临时卡牌对象来得到比较值
-        return Card(p, suit_for_card_obj, ctx).getComparisonValue();
-    }
-
-    int get_point_comparison_value(Card& card)
+    // 获取点数的比较值(查级牌比较表，与花色无关)
+    int get_point_comparison_value(Card::CardPoint p, const LevelContext& level_ctx)
     {
-        // 通过卡片本身得到比较值
-        return card.getComparisonValue();
+        return level_ctx.comparisonValue(p);
     }
 
     // 评估同点数牌型组合
     CardCombo::ComboInfo tryEvaluateSamePointCombos(const QVector<Card>& cards_with_context,
-        const QMap<Card::CardPoint, int>& point_counts, // 记录每种点数的牌的数量
-        Player* player_context,
+        const CardSet& point_counts, // 记录每种点数的牌的数量
+        const LevelContext& level_ctx,
         // 计算炸弹等级
         const std::function<int(int, Card::CardPoint, Card::CardSuit, bool, bool)>& get_bomb_level_func)
     {
         // 如果点数计数的大小不为1，说明不是同点数牌型
         CardCombo::ComboInfo info;
-        if (point_counts.size() != 1) return info; // info默认为非法
+        if (point_counts.distinctRankCount() != 1) return info; // info默认为非法
 
         // 初始化牌型信息
         info.cards_in_combo = cards_with_context; // 记录当前牌组
@@ -206,17 +185,17 @@ namespace {
         // 单牌
         if (num_total_cards == 1) {
             info.type = CardComboType::Single;
-            info.level = get_point_comparison_value(combo_point, player_context, representative_suit);
+            info.level = get_point_comparison_value(combo_point, level_ctx);
         }
         // 对子
         else if (num_total_cards == 2) {
             info.type = CardComboType::Pair;
-            info.level = get_point_comparison_value(combo_point, player_context, representative_suit);
+            info.level = get_point_comparison_value(combo_point, level_ctx);
         }
         // 三条
         else if (num_total_cards == 3) {
             info.type = CardComboType::Triple;
-            info.level = get_point_comparison_value(combo_point, player_context, representative_suit);
+            info.level = get_point_comparison_value(combo_point, level_ctx);
         }
         // 炸弹
         else if (num_total_cards >= 4) {
@@ -228,9 +207,9 @@ namespace {
 
     // 判断输入的牌组是否可以组成顺子或类似的连续结构
     CardCombo::ComboInfo tryEvaluateSequenceCombos(const QVector<Card>& cards_with_context,
-        const QMap<Card::CardPoint, int>& point_counts,
+        const CardSet& point_counts,
         const QVector<Card::CardPoint>& distinct_points_vec,
-        Player* player_context,
+        const LevelContext& level_ctx,
         const std::function<int(int, Card::CardPoint, Card::CardSuit, bool, bool)>& get_bomb_level_func) {
         // 1. 初始化牌型信息
         CardCombo::ComboInfo info;
@@ -284,8 +263,8 @@ namespace {
         else if (num_total_cards == 6 && distinct_points_vec.size() == 3) {
             bool all_pairs = true;
             // 检查每种点数是否都是2张
-            for (auto it = point_counts.constBegin(); it != point_counts.constEnd(); ++it) {
-                if (it.value() != 2) { all_pairs = false; break; }
+            for (Card::CardPoint p : distinct_points_vec) {
+                if (point_counts.rankCount(p) != 2) { all_pairs = false; break; }
             }
             if (all_pairs) {
                 info.type = CardComboType::DoubleSequence;
@@ -296,8 +275,8 @@ namespace {
         else if (num_total_cards == 6 && distinct_points_vec.size() == 2) {
             bool all_triples = true;
             // 检查每种点数是否都是3张
-            for (auto it = point_counts.constBegin(); it != point_counts.constEnd(); ++it) {
-                if (it.value() != 3) { all_triples = false; break; }
+            for (Card::CardPoint p : distinct_points_vec) {
+                if (point_counts.rankCount(p) != 3) { all_triples = false; break; }
             }
             if (all_triples) {
                 info.type = CardComboType::TripleSequence;
@@ -309,12 +288,12 @@ namespace {
 
     // 判断三带二牌型
     CardCombo::ComboInfo tryEvaluateWithKickerCombos(const QVector<Card>& cards_with_context,
-        const QMap<Card::CardPoint, int>& point_counts, Player* player_context) { // QMap
+        const CardSet& point_counts, const LevelContext& level_ctx) {
         // 1. 初始化牌型
         CardCombo::ComboInfo info;
         info.cards_in_combo = cards_with_context;
         int num_total_cards = cards_with_context.size();
-        int num_distinct_points = point_counts.size();
+        int num_distinct_points = point_counts.distinctRankCount();
 
         // 2. 判断三带二条件
         // 总牌数为5，且有2种不同点数
@@ -325,21 +304,22 @@ namespace {
 
             // 寻找三条
             for (const auto& card : cards_with_context) {
-                if (point_counts.value(card.point()) == 3) {
+                if (point_counts.rankCount(card.point()) == 3) {
                     triple_suit = card.suit();
                     break;
                 }
             }
 
             // 寻找对子
-            for (auto it = point_counts.constBegin(); it != point_counts.constEnd(); ++it) {
-                if (it.value() == 3) { triple_pt = it.key(); found_triple = true; }
-                else if (it.value() == 2) { found_pair = true; }
+            for (int r = 0; r < CardSet::RANK_COUNT; ++r) {
+                int count = point_counts.rankCount(CardSet::rankAt(r));
+                if (count == 3) { triple_pt = CardSet::rankAt(r); found_triple = true; }
+                else if (count == 2) { found_pair = true; }
             }
             if (found_triple && found_pair) {
                 info.type = CardComboType::TripleWithPair;
                 // 用三条来计算三带二的等级
-                info.level = get_point_comparison_value(triple_pt, player_context, triple_suit);
+                info.level = get_point_comparison_value(triple_pt, level_ctx);
             }
         }
         return info;
@@ -347,7 +327,7 @@ namespace {
 
     // 判断天王炸
     CardCombo::ComboInfo tryEvaluateSpecialBombs(const QVector<Card>& cards_with_context,
-        const QMap<Card::CardPoint, int>& point_counts, Player* player_context,
+        const CardSet& point_counts, const LevelContext& level_ctx,
         const std::function<int(int, Card::CardPoint, Card::CardSuit, bool, bool)>& get_bomb_level_func) {
         // 初始化牌型信息
         CardCombo::ComboInfo info;
@@ -355,9 +335,9 @@ namespace {
         int num_total_cards = cards_with_context.size();
 
         // 判断是否为天王炸
-        if (num_total_cards == 4 && point_counts.size() == 2 &&
-            point_counts.contains(Card::CardPoint::Card_LJ) && point_counts.value(Card::CardPoint::Card_LJ) == 2 &&
-            point_counts.contains(Card::CardPoint::Card_BJ) && point_counts.value(Card::CardPoint::Card_BJ) == 2) {
+        if (num_total_cards == 4 && point_counts.distinctRankCount() == 2 &&
+            point_counts.rankCount(Card::CardPoint::Card_LJ) == 2 &&
+            point_counts.rankCount(Card::CardPoint::Card_BJ) == 2) {
             info.type = CardComboType::Bomb;
             info.level = get_bomb_level_func(4, Card::CardPoint::Card_BJ, Card::CardSuit::Joker, false, true);
         }
@@ -366,31 +346,33 @@ namespace {
 
 } // end namespace
 
-// 评估确定的牌组能否组成有效牌型
-CardCombo::ComboInfo CardCombo::evaluateConcreteCombo(const QVector<Card>& concrete_cards, Player* current_player_context) {
-    if (concrete_cards.empty() || !current_player_context) {
+// 评估确定的牌组能否组成有效牌型(参考实现)
+CardCombo::ComboInfo CardCombo::evaluateConcreteComboReference(const QVector<Card>& concrete_cards, Player* current_player_context) {
+    if (concrete_cards.empty() || concrete_cards.size() > ComboCards::Capacity || !current_player_context) {
         return ComboInfo();
     } // 空牌组返回非法
 
+    // 级牌上下文只取一次，之后所有比较都查表
+    const LevelContext level_ctx = current_player_context->getLevelContext();
+
     QVector<Card> cards_with_context = concrete_cards;
-    // 确保每张牌都有玩家上下文(
+    // 确保每张牌都有玩家上下文(供UI显示使用，牌型判断本身不再依赖所有者)
     for (auto& card : cards_with_context) {
         if (!card.getOwner() || card.getOwner() != current_player_context) {
             card.setOwner(current_player_context);
         }
     }
 
-    // 利用QMap统计点数分布
-    QMap<Card::CardPoint, int> point_counts;
-    for (const auto& card : cards_with_context) {
-        point_counts[card.point()]++;
-    }
+    // 利用CardSet统计点数分布(计数矩阵，无需QMap)
+    CardSet point_counts(cards_with_context);
 
-    // 获得所有不同的点数
+    // 获得所有不同的点数(按点数从小到大)
     QVector<Card::CardPoint> distinct_points_vec;
-    distinct_points_vec.reserve(point_counts.size());  // 预先分配内存
-    for (auto it = point_counts.constBegin(); it != point_counts.constEnd(); ++it) {
-        distinct_points_vec.push_back(it.key()); // 添加键
+    distinct_points_vec.reserve(point_counts.distinctRankCount());  // 预先分配内存
+    for (int r = 0; r < CardSet::RANK_COUNT; ++r) {
+        if (point_counts.rankMask() & (1u << r)) {
+            distinct_points_vec.push_back(CardSet::rankAt(r));
+        }
     }
 
     // 定义炸弹等级计算函数
@@ -406,7 +388,7 @@ CardCombo::ComboInfo CardCombo::evaluateConcreteCombo(const QVector<Card>& concr
 
         int count_factor = num_cards_in_bomb * 1000; // 计算炸弹的牌数点数
         // 基础牌等级
-        int base_card_level = get_point_comparison_value(representative_point, current_player_context, representative_suit);
+        int base_card_level = get_point_comparison_value(representative_point, level_ctx);
         if (base_card_level < 0) base_card_level = 0;
         return type_priority + count_factor + base_card_level; // 利用不同数位来实现优先级判断
         };
@@ -415,78 +397,255 @@ CardCombo::ComboInfo CardCombo::evaluateConcreteCombo(const QVector<Card>& concr
     ComboInfo result_info;
 
     // 评估天王炸
-    result_info = tryEvaluateSpecialBombs(cards_with_context, point_counts, current_player_context, get_bomb_level_lambda);
+    result_info = tryEvaluateSpecialBombs(cards_with_context, point_counts, level_ctx, get_bomb_level_lambda);
     if (result_info.isValid()) return result_info;
 
     // 评估同点数牌型
-    result_info = tryEvaluateSamePointCombos(cards_with_context, point_counts, current_player_context, get_bomb_level_lambda);
+    result_info = tryEvaluateSamePointCombos(cards_with_context, point_counts, level_ctx, get_bomb_level_lambda);
     if (result_info.isValid()) return result_info;
 
     // 评估顺子或类似的连续结构
-    result_info = tryEvaluateSequenceCombos(cards_with_context, point_counts, distinct_points_vec, current_player_context, get_bomb_level_lambda);
+    result_info = tryEvaluateSequenceCombos(cards_with_context, point_counts, distinct_points_vec, level_ctx, get_bomb_level_lambda);
     if (result_info.isValid()) return result_info;
 
     // 评估三带二
-    result_info = tryEvaluateWithKickerCombos(cards_with_context, point_counts, current_player_context);
+    result_info = tryEvaluateWithKickerCombos(cards_with_context, point_counts, level_ctx);
     if (result_info.isValid()) return result_info;
 
     return ComboInfo(); // 返回评估结果
 }
 
-// 递归地处理癞子牌的各种替换方式，生成所有可能的具体合法牌组
-void CardCombo::findCombinationsWithWildsRecursive(
-    const QVector<Card>& current_concrete_cards, //确定的牌组
-    const QVector<Card>& original_wild_cards_remaining, // 当前的癞子牌数组
+// 评估确定的牌组能否组成有效牌型
+CardCombo::ComboInfo CardCombo::evaluateConcreteCombo(const QVector<Card>& concrete_cards, Player* current_player_context) {
+#ifdef CARDCOMBO_REFERENCE_EVALUATOR
+    return evaluateConcreteComboReference(concrete_cards, current_player_context);
+#else
+    if (concrete_cards.empty() || concrete_cards.size() > ComboCards::Capacity || !current_player_context) {
+        return ComboInfo();
+    } // 空牌组或超过一手牌最大张数时返回非法
+
+    const LevelContext level_ctx = current_player_context->getLevelContext();
+    const CardSet point_counts(concrete_cards);
+
+    // 天王炸不符合直方图签名的规律，单独判断
+    bool is_king_bomb = (point_counts.size() == 4 &&
+        point_counts.rankCount(Card::CardPoint::Card_LJ) == 2 &&
+        point_counts.rankCount(Card::CardPoint::Card_BJ) == 2);
+
+    ComboInfo info;
+    if (is_king_bomb) {
+        info.type = CardComboType::Bomb;
+        info.level = 300000 + 4 * 1000 + get_point_comparison_value(Card::CardPoint::Card_BJ, level_ctx);
+    }
+    else {
+        // 统计签名：各张数的点数个数，同时记录张数最多的点数(用于计算等级)
+        int count_of_counts[4] = { 0, 0, 0, 0 };
+        Card::CardPoint main_point = Card::CardPoint::Card_2;
+        int main_count = 0;
+        quint16 mask = point_counts.rankMask();
+        while (mask) {
+            int r = 0;
+            while (!(mask & (1u << r))) ++r;
+            mask &= mask - 1;
+            Card::CardPoint p = CardSet::rankAt(r);
+            int count = point_counts.rankCount(p);
+            ++count_of_counts[qMin(count, 4) - 1];
+            if (count > main_count) { main_count = count; main_point = p; }
+        }
+
+        Card::CardPoint lead_point = Card::CardPoint::Card_2;
+        bool consecutive = ComboTables::checkConsecutiveMask(point_counts.rankMask(), lead_point);
+        int signature = ComboTables::signatureIndex(count_of_counts[0], count_of_counts[1],
+            count_of_counts[2], count_of_counts[3], consecutive);
+        if (signature < 0) return ComboInfo();
+
+        const ComboTables::Entry& entry = ComboTables::kTable.entries[signature];
+        switch (entry.rule) {
+        case ComboTables::RankValue:
+            info.type = entry.type;
+            info.level = get_point_comparison_value(main_point, level_ctx);
+            break;
+        case ComboTables::RankBomb:
+            info.type = entry.type;
+            info.level = 100000 + point_counts.size() * 1000 + qMax(0, get_point_comparison_value(main_point, level_ctx));
+            break;
+        case ComboTables::SequenceLead:
+            // 顺子的5张牌花色相同时为同花顺炸弹
+            if (entry.type == CardComboType::Straight &&
+                point_counts.suitMask(concrete_cards[0].suit()) == point_counts.rankMask()) {
+                info.type = CardComboType::Bomb;
+                info.is_flush_straight_bomb = true;
+                info.level = 200000 + 5 * 1000 + qMax(0, get_point_comparison_value(lead_point, level_ctx));
+            }
+            else {
+                info.type = entry.type;
+                info.level = getSequentialOrder(lead_point, lead_point == Card::CardPoint::Card_A);
+            }
+            break;
+        default:
+            return ComboInfo();
+        }
+    }
+
+    // 确保每张牌都有玩家上下文(供UI显示使用)
+    info.cards_in_combo = concrete_cards;
+    for (auto& card : info.cards_in_combo) {
+        if (card.getOwner() != current_player_context) {
+            card.setOwner(current_player_context);
+        }
+    }
+    return info;
+#endif
+}
+
+// 匿名命名空间，给resolveWildCombinations提供辅助函数
+namespace {
+
+    // 顺序值(A最小为1，A最大为14)转换为点数
+    Card::CardPoint pointFromSequentialOrder(int order)
+    {
+        if (order == 1 || order == 14) return Card::CardPoint::Card_A;
+        return static_cast<Card::CardPoint>(order);
+    }
+
+    // 目标点数分布减去普通牌的点数分布，即为癞子需要替换成的点数
+    // 普通牌不能全部放入目标分布、需要替换成大小王、或所需张数与癞子数不符时返回false
+    bool fillWildsToTarget(const CardSet& normal_counts, const int (&target)[CardSet::RANK_COUNT],
+        int wild_count, QVector<Card::CardPoint>& wild_points)
+    {
+        wild_points.clear();
+        for (int r = 0; r < CardSet::RANK_COUNT; ++r) {
+            Card::CardPoint p = CardSet::rankAt(r);
+            int need = target[r] - normal_counts.rankCount(p);
+            if (need < 0) return false;
+            if (need == 0) continue;
+            if (p == Card::CardPoint::Card_LJ || p == Card::CardPoint::Card_BJ) return false; // 癞子不能当大小王
+            if (wild_points.size() + need > wild_count) return false;
+            for (int i = 0; i < need; ++i) wild_points.push_back(p);
+        }
+        return wild_points.size() == wild_count;
+    }
+
+    // 为一组(按点数升序的)癞子点数枚举所有花色组合
+    // 相同点数的癞子花色单调不减，保证每种具体牌组只生成一次
+    void expandWildSuits(const QVector<Card::CardPoint>& wild_points, int index,
+        QVector<Card>& current, Player* player_context, QVector<QVector<Card>>& substitutions)
+    {
+        if (index == wild_points.size()) {
+            substitutions.push_back(current);
+            return;
+        }
+        int first_suit = static_cast<int>(Card::CardSuit::Diamond);
+        if (index > 0 && wild_points[index - 1] == wild_points[index]) {
+            first_suit = static_cast<int>(current[index - 1].suit());
+        }
+        for (int s = first_suit; s <= static_cast<int>(Card::CardSuit::Spade); ++s) {
+            current.push_back(Card(wild_points[index], static_cast<Card::CardSuit>(s), player_context));
+            expandWildSuits(wild_points, index + 1, current, player_context, substitutions);
+            current.pop_back();
+        }
+    }
+
+    // 合法牌型组合的展示顺序：炸弹优先，等级高的优先，癞子少的优先
+    bool comboDisplayOrder(const CardCombo::ComboInfo& a, const CardCombo::ComboInfo& b)
+    {
+        bool a_is_bomb = (a.type == CardComboType::Bomb);
+        bool b_is_bomb = (b.type == CardComboType::Bomb);
+        if (a_is_bomb != b_is_bomb) return a_is_bomb;
+        if (a.level != b.level) return a.level > b.level;
+        if (a.wild_cards_used != b.wild_cards_used) return a.wild_cards_used < b.wild_cards_used;
+        return false;
+    }
+
+} // end namespace
+
+// 根据普通牌的点数分布推导癞子的所有合法替换，生成所有可能的具体合法牌组
+// 只考虑能构成牌型的目标点数分布，而不是对每张癞子尝试全部52种牌
+void CardCombo::resolveWildCombinations(
+    const QVector<Card>& concrete_cards, // 普通牌
+    int wild_count, // 癞子牌数量
     const QVector<Card>& original_selection, // 原始选择的牌
     Player* player_context, // 当前玩家
     QVector<ComboInfo>& valid_combos_found, // 存储找到的合法牌组
-    QMap<QString, bool>& visited_combo_fingerprints, // 已经生成过的牌组指纹
     int current_table_combo_type, // 当前桌面牌型
-    int current_table_combo_level, // 当前桌面牌型等级
-    int total_original_wild_cards_in_selection) // 原始癞子牌的总数
+    int current_table_combo_level) // 当前桌面牌型等级
 {
-    // 1. 基例： 如果没有剩余的癞子牌，那么就完成了全部替换
-    if (original_wild_cards_remaining.empty()) {
-        QVector<Card> final_cards = current_concrete_cards;
-        // 评估确定的牌组
-        ComboInfo combo = evaluateConcreteCombo(final_cards, player_context);
+    const CardSet normal_counts(concrete_cards);
+    const int total_cards = concrete_cards.size() + wild_count;
+
+    // 1. 列出所有目标点数分布，得到癞子需要替换成的点数
+    // 各目标分布互不相同，因此得到的癞子点数组合也不会重复
+    QVector<QVector<Card::CardPoint>> wild_point_sets;
+    QVector<Card::CardPoint> wild_points;
+    auto try_target = [&](const int (&target)[CardSet::RANK_COUNT]) {
+        if (fillWildsToTarget(normal_counts, target, wild_count, wild_points)) {
+            wild_point_sets.push_back(wild_points);
+        }
+        };
 
-        // 如果生成的牌组是合法的且没有指纹
-        if (combo.isValid()) {
-            combo.wild_cards_used = total_original_wild_cards_in_selection;
-            combo.original_cards = original_selection;  // 设置原始手牌
-            // 如果能大过上家
-            if (canBeat(combo, current_table_combo_type, current_table_combo_level)) {
-                QString fingerprint = generateComboFingerprint(combo.cards_in_combo);
-                if (!visited_combo_fingerprints.contains(fingerprint)) {
-                    valid_combos_found.push_back(combo); // 加入到合法牌组数组
-                    // 将指纹添加到已访问的集合中
-                    visited_combo_fingerprints.insert(fingerprint, true);
-                }
+    // 同点数(单张、对子、三条、炸弹)
+    for (int p = Card::CardPoint::Card_2; p <= Card::CardPoint::Card_A; ++p) {
+        int target[CardSet::RANK_COUNT] = {};
+        target[CardSet::rankIndex(static_cast<Card::CardPoint>(p))] = total_cards;
+        try_target(target);
+    }
+
+    // 顺序结构: 顺子(含同花顺)5种点数各1张，连对3种点数各2张，钢板2种点数各3张
+    auto try_sequence_windows = [&](int length, int copies) {
+        for (int low = 1; low + length - 1 <= 14; ++low) {
+            int target[CardSet::RANK_COUNT] = {};
+            for (int order = low; order < low + length; ++order) {
+                target[CardSet::rankIndex(pointFromSequentialOrder(order))] = copies;
             }
+            try_target(target);
         }
-        return; // 结束递归
+        };
+    if (total_cards == 5) try_sequence_windows(5, 1);
+    if (total_cards == 6) {
+        try_sequence_windows(3, 2);
+        try_sequence_windows(2, 3);
     }
 
-    // 2. 递归部分
-    QVector<Card> next_wild_cards_remaining = original_wild_cards_remaining;
-    next_wild_cards_remaining.removeFirst(); // 移除第一个癞子牌
+    // 三带二(对子可以是普通牌中已有的大小王)
+    if (total_cards == 5) {
+        for (int t = 0; t < CardSet::RANK_COUNT; ++t) {
+            for (int u = 0; u < CardSet::RANK_COUNT; ++u) {
+                if (t == u) continue;
+                int target[CardSet::RANK_COUNT] = {};
+                target[t] = 3;
+                target[u] = 2;
+                try_target(target);
+            }
+        }
+    }
 
-    // 试将癞子牌替换为每种可能的具体牌 (点数和花色)
-    for (int p_val_int = static_cast<int>(Card::CardPoint::Card_2); p_val_int <= static_cast<int>(Card::CardPoint::Card_A); ++p_val_int) {
-        Card::CardPoint point_to_try = static_cast<Card::CardPoint>(p_val_int);
-        if (point_to_try == Card::CardPoint::Card_LJ || point_to_try == Card::CardPoint::Card_BJ) {
-            continue;
+    // 2. 为每组癞子点数枚举花色，癞子牌按(点数, 花色)升序排列
+    QVector<QVector<Card>> substitutions;
+    QVector<Card> current;
+    for (const auto& point_set : wild_point_sets) {
+        expandWildSuits(point_set, 0, current, player_context, substitutions);
+    }
+    // 按替换牌的字典序处理，使结果顺序与逐张枚举时一致
+    std::sort(substitutions.begin(), substitutions.end(), [](const QVector<Card>& a, const QVector<Card>& b) {
+        for (qsizetype i = 0; i < a.size() && i < b.size(); ++i) {
+            if (a[i].point() != b[i].point()) return a[i].point() < b[i].point();
+            if (a[i].suit() != b[i].suit()) return a[i].suit() < b[i].suit();
         }
-        for (int s_val_int = static_cast<int>(Card::CardSuit::Diamond); s_val_int <= static_cast<int>(Card::CardSuit::Spade); ++s_val_int) {
-            Card::CardSuit suit_to_try = static_cast<Card::CardSuit>(s_val_int);
-            QVector<Card> next_concrete_cards = current_concrete_cards;
-            next_concrete_cards.push_back(Card(point_to_try, suit_to_try, player_context));
-            findCombinationsWithWildsRecursive(next_concrete_cards, next_wild_cards_remaining,
-                original_selection,
-                player_context, valid_combos_found, visited_combo_fingerprints,
-                current_table_combo_type, current_table_combo_level,
-                total_original_wild_cards_in_selection);
+        return a.size() < b.size();
+        });
+
+    // 3. 评估每一种具体牌组
+    for (const auto& wild_substitution : substitutions) {
+        QVector<Card> final_cards = concrete_cards;
+        final_cards += wild_substitution;
+        ComboInfo combo = evaluateConcreteCombo(final_cards, player_context);
+        if (combo.isValid()) {
+            combo.wild_cards_used = wild_count;
+            combo.original_cards = original_selection;  // 设置原始手牌
+            // 如果能大过上家
+            if (canBeat(combo, current_table_combo_type, current_table_combo_level)) {
+                valid_combos_found.push_back(combo);
+            }
         }
     }
 }
@@ -499,7 +658,7 @@ QVector<CardCombo::ComboInfo> CardCombo::getAllPossibleValidPlays( // Return QVe
     int current_table_combo_level) // 当前桌面牌型等级
 {
     QVector<ComboInfo> all_valid_plays; // 存储所有合法牌型组合的数组
-    if (selected_cards.empty() || !current_player_context) {
+    if (selected_cards.empty() || selected_cards.size() > ComboCards::Capacity || !current_player_context) {
         return all_valid_plays;
     }
 
@@ -507,11 +666,12 @@ QVector<CardCombo::ComboInfo> CardCombo::getAllPossibleValidPlays( // Return QVe
     QVector<Card> initial_concrete_cards; // 初始普通牌
     QVector<Card> initial_wild_cards_to_substitute; // 初始癞子牌
 
+    const LevelContext level_ctx = current_player_context->getLevelContext();
     for (const auto& orig_card : selected_cards) {
         Card card = orig_card;
         // 确保每张牌都有玩家上下文,增加安全性(若测试时性能过低可考虑移除类似代码)
         if (!card.getOwner()) card.setOwner(current_player_context);
-        if (card.isWildCard()) {
+        if (level_ctx.isWildCard(card)) {
             initial_wild_cards_to_substitute.push_back(card);
         }
         else {
@@ -519,7 +679,6 @@ QVector<CardCombo::ComboInfo> CardCombo::getAllPossibleValidPlays( // Return QVe
         }
     }
 
-    QMap<QString, bool> visited_fingerprints; // 用于存储已经生成过的牌组指纹
     int total_wilds_in_selection = initial_wild_cards_to_substitute.size();
 
     // 2. 如果没有癞子牌，直接评估当前的具体牌组
@@ -531,47 +690,152 @@ QVector<CardCombo::ComboInfo> CardCombo::getAllPossibleValidPlays( // Return QVe
             all_valid_plays.push_back(combo);
         }
     }
-    // 3. 如果有癞子牌，调用findCombinationsWithWildsRecursive函数
+    // 3. 如果有癞子牌，调用resolveWildCombinations函数
     else {
-        findCombinationsWithWildsRecursive(initial_concrete_cards,
-            initial_wild_cards_to_substitute,
+        resolveWildCombinations(initial_concrete_cards,
+            total_wilds_in_selection,
             selected_cards,  // 传递原始选择的牌
             current_player_context,
             all_valid_plays,
-            visited_fingerprints,
             current_table_combo_type,
-            current_table_combo_level,
-            total_wilds_in_selection);
+            current_table_combo_level);
     }
     // 返回all_valid_plays
 
     // 对所有合法牌型组合进行排序 (方便展示)
-    std::sort(all_valid_plays.begin(), all_valid_plays.end(), [](const ComboInfo& a, const ComboInfo& b) {
-        bool a_is_bomb = (a.type == CardComboType::Bomb);
-        bool b_is_bomb = (b.type == CardComboType::Bomb);
-        if (a_is_bomb != b_is_bomb) return a_is_bomb;
-        if (a.level != b.level) return a.level > b.level;
-        if (a.wild_cards_used != b.wild_cards_used) return a.wild_cards_used < b.wild_cards_used;
-        return false;
-        });
+    std::sort(all_valid_plays.begin(), all_valid_plays.end(), comboDisplayOrder);
 
     return all_valid_plays; // 返回所有合法牌型组合
 }
 
+void CardCombo::BatchResult::resize(int count)
+{
+    types.fill(CardComboType::Invalid, count);
+    levels.fill(-1, count);
+    wild_counts.fill(0, count);
+    flush_straight.fill(0, count);
+    can_beat.fill(0, count);
+    cards_in_combo.resize(count);
+}
+
+CardCombo::ComboInfo CardCombo::BatchResult::comboAt(int i, const QVector<Card>& original_cards) const
+{
+    ComboInfo info;
+    info.type = types[i];
+    info.level = levels[i];
+    info.wild_cards_used = wild_counts[i];
+    info.is_flush_straight_bomb = flush_straight[i] != 0;
+    info.cards_in_combo = cards_in_combo[i];
+    info.original_cards = original_cards;
+    return info;
+}
+
+// 批量评估候选牌组
+CardCombo::BatchResult CardCombo::evaluateBatch(
+    const QVector<QVector<Card>>& candidates, // 候选牌组
+    Player* current_player_context, // 玩家上下文
+    int current_table_combo_type, // 当前桌面牌型类型
+    int current_table_combo_level) // 当前桌面牌型等级
+{
+    BatchResult result;
+    const int count = candidates.size();
+    result.resize(count);
+    if (!current_player_context) return result;
+
+    const LevelContext level_ctx = current_player_context->getLevelContext();
+    QVector<Card> concrete_cards;
+    concrete_cards.reserve(ComboCards::Capacity);
+    QVector<ComboInfo> interpretations;
+    QVector<ComboInfo> beating;
+
+    // 1. 确定每个候选牌组的牌型
+    for (int i = 0; i < count; ++i) {
+        const QVector<Card>& candidate = candidates[i];
+        if (candidate.empty() || candidate.size() > ComboCards::Capacity) continue;
+
+        // 分离普通牌和癞子牌
+        concrete_cards.clear();
+        int wild_count = 0;
+        for (const auto& orig_card : candidate) {
+            if (level_ctx.isWildCard(orig_card)) {
+                ++wild_count;
+                continue;
+            }
+            Card card = orig_card;
+            if (!card.getOwner()) card.setOwner(current_player_context);
+            concrete_cards.push_back(card);
+        }
+
+        ComboInfo chosen;
+        if (wild_count == 0) {
+            chosen = evaluateConcreteCombo(concrete_cards, current_player_context);
+        }
+        else {
+            // 先列出全部解释，优先在能压过上家的解释中选择
+            interpretations.clear();
+            resolveWildCombinations(concrete_cards, wild_count, candidate, current_player_context,
+                interpretations, CardComboType::Invalid, -1);
+            beating.clear();
+            for (const auto& combo : interpretations) {
+                if (canBeat(combo, current_table_combo_type, current_table_combo_level)) {
+                    beating.push_back(combo);
+                }
+            }
+            QVector<ComboInfo>& pool = beating.isEmpty() ? interpretations : beating;
+            if (!pool.isEmpty()) {
+                std::sort(pool.begin(), pool.end(), comboDisplayOrder);
+                chosen = pool.first();
+            }
+        }
+        if (!chosen.isValid()) continue;
+
+        result.types[i] = chosen.type;
+        result.levels[i] = chosen.level;
+        result.wild_counts[i] = wild_count;
+        result.flush_straight[i] = chosen.is_flush_straight_bomb ? 1 : 0;
+        result.cards_in_combo[i] = chosen.cards_in_combo;
+    }
+
+    // 2. 计算canBeat标志(与canBeat规则一致，无分支依赖，便于编译器向量化)
+    const int* types = result.types.constData();
+    const int* levels = result.levels.constData();
+    quint8* can_beat = result.can_beat.data();
+    const bool table_is_empty = (current_table_combo_type == CardComboType::Invalid);
+    const bool table_is_bomb = (current_table_combo_type == CardComboType::Bomb);
+    for (int i = 0; i < count; ++i) {
+        const bool valid = types[i] != CardComboType::Invalid;
+        const bool is_bomb = types[i] == CardComboType::Bomb;
+        const bool higher = levels[i] > current_table_combo_level;
+        const bool beats_as_bomb = is_bomb & (!table_is_bomb | higher);
+        const bool beats_same_type = (types[i] == current_table_combo_type) & higher;
+        can_beat[i] = static_cast<quint8>(valid & (table_is_empty | beats_as_bomb | beats_same_type));
+    }
+
+    return result;
+}
+
 // 辅助函数，判断传入的ComboInfo是否可以大过上家
 bool CardCombo::canBeat(const CardCombo::ComboInfo& play_combo,
     int current_table_combo_type,
     int current_table_combo_level)
+{
+    return canBeat(play_combo.type, play_combo.level, current_table_combo_type, current_table_combo_level);
+}
+
+// 按牌型和等级判断是否可以大过上家
+bool CardCombo::canBeat(int play_type, int play_level,
+    int current_table_combo_type,
+    int current_table_combo_level)
 {
     // 检查特殊情况
-    if (!play_combo.isValid()) return false;
+    if (play_type == CardComboType::Invalid) return false;
     if (current_table_combo_type == CardComboType::Invalid) return true;
 
     // 炸弹逻辑
-    if (play_combo.type == CardComboType::Bomb) {
+    if (play_type == CardComboType::Bomb) {
         // 如果场上是炸弹，拼点
         if (current_table_combo_type == CardComboType::Bomb) {
-            return play_combo.level > current_table_combo_level;
+            return play_level > current_table_combo_level;
         }
         // 不是炸弹，炸弹就可以出
         else {
@@ -580,6 +844,6 @@ bool CardCombo::canBeat(const CardCombo::ComboInfo& play_combo,
     }
 
     // 常规牌型逻辑
-    return (play_combo.type == current_table_combo_type &&
-        play_combo.level > current_table_combo_level);
+    return (play_type == current_table_combo_type &&
+        play_level > current_table_combo_level);
 }
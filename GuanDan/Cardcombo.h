@@ -5,6 +5,7 @@
 #include <QString>
 
 #include "Card.h"     // 包含 Card 类定义
+#include "ComboCards.h"
 
 // 前向声明 Player 和 Team
 class Player;
@@ -29,8 +30,8 @@ public:
     struct ComboInfo {
         int type = CardComboType::Invalid;
         int level = -1;
-        QVector<Card> cards_in_combo;
-        QVector<Card> original_cards;  // 存储构成该牌型的原始手牌（包括癞子牌）
+        ComboCards cards_in_combo;     // 内联存储，复制时不分配内存
+        ComboCards original_cards;     // 存储构成该牌型的原始手牌（包括癞子牌）
         int wild_cards_used = 0;
         bool is_flush_straight_bomb = false;
 
@@ -38,14 +39,36 @@ public:
         QString getDescription() const; // 返回牌型描述
     };
 
+    // 批量评估的结果：按候选牌组的下标存放在并行数组中
+    // 候选牌组有多种解释(含癞子)时，取能压过上家的解释中排序最靠前的一个；都压不过时取排序最靠前的解释
+    struct BatchResult {
+        QVector<int> types;                  // 牌型，不能组成牌型时为Invalid
+        QVector<int> levels;                 // 牌型等级
+        QVector<int> wild_counts;            // 使用的癞子数
+        QVector<quint8> flush_straight;      // 是否为同花顺炸弹
+        QVector<quint8> can_beat;            // 能否压过当前桌面牌型
+        QVector<ComboCards> cards_in_combo;  // 癞子替换后的具体牌组
+
+        int size() const { return types.size(); }
+        void resize(int count);
+        // 将第i个结果还原为ComboInfo，original_cards为对应的候选牌组
+        ComboInfo comboAt(int i, const QVector<Card>& original_cards) const;
+    };
+
     CardCombo() = delete; // 静态类，只使用方法而不实例化
     ~CardCombo() = delete; // 禁止析构
 
     // 评估一组确定的牌的牌型
     // 在getAllPossibleValidPlays函数中用于处理所有可能的组合
+    // 通过点数直方图签名查表判断牌型(见ComboTable.h)
+    // 定义 CARDCOMBO_REFERENCE_EVALUATOR 时改用逐个尝试各类牌型的参考实现
     static ComboInfo evaluateConcreteCombo(const QVector<Card>& concrete_cards,
         Player* current_player_context);
 
+    // 参考实现：依次尝试天王炸、同点数、连续结构、三带二
+    static ComboInfo evaluateConcreteComboReference(const QVector<Card>& concrete_cards,
+        Player* current_player_context);
+
     // 枚举函数，获取所有可能的合法出牌组合QVector<ComboInfo>
     static QVector<ComboInfo> getAllPossibleValidPlays(
         const QVector<Card>& selected_cards,
@@ -53,6 +76,19 @@ public:
         int current_table_combo_type,
         int current_table_combo_level);
 
+    // 批量评估一组候选牌组，AI搜索和出牌提示统一通过这里给候选出牌打分
+    // 级牌上下文只取一次，canBeat标志在单独的紧凑循环中计算
+    static BatchResult evaluateBatch(
+        const QVector<QVector<Card>>& candidates,
+        Player* current_player_context,
+        int current_table_combo_type,
+        int current_table_combo_level);
+
+    // 只按牌型和等级判断能否压过桌面牌型，供直接生成出牌的AI在构造牌组前过滤
+    static bool canBeat(int play_type, int play_level,
+        int current_table_combo_type,
+        int current_table_combo_level);
+
     // 处理在顺子中的顺序值，对A特殊处理
     static int getSequentialOrder(Card::CardPoint p, bool ace_as_high_in_straight);
 
@@ -61,9 +97,6 @@ public:
     static bool checkConsecutive(const QVector<Card::CardPoint>& distinct_points_input,
         Card::CardPoint& leading_point_for_level);
 
-    // 生成牌组的指纹Qstring，用于唯一标识牌组
-    static QString generateComboFingerprint(const QVector<Card>& cards);
-
 
 private:
     // 判断玩家现在的牌型是否可以打败当前桌面上的牌型
@@ -71,17 +104,16 @@ private:
         int current_table_combo_type,
         int current_table_combo_level);
 
-    // 递归地处理癞子牌的各种替换方式，生成所有可能的具体合法牌组
-    static void findCombinationsWithWildsRecursive(
-        const QVector<Card>& current_concrete_cards,
-        const QVector<Card>& original_wild_cards_remaining,
+    // 根据普通牌的点数分布，直接推导癞子能补成的牌型(同点数、顺子、连对、钢板、三带二、同花顺)
+    // 生成所有可能的具体合法牌组，结果与逐张枚举52种替换完全一致
+    static void resolveWildCombinations(
+        const QVector<Card>& concrete_cards,
+        int wild_count,
         const QVector<Card>& original_selection,
         Player* player_context,
         QVector<ComboInfo>& valid_combos_found,
-        QMap<QString, bool>& visited_combo_fingerprints,
         int current_table_combo_type,
-        int current_table_combo_level,
-        int total_original_wild_cards_in_selection);
+        int current_table_combo_level);
 };
 
 #endif // CARDCOMBO_H
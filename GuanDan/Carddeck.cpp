@@ -1,8 +1,9 @@
 #include "Carddeck.h"
 
 #include <QDebug>
-#include <algorithm> // for std::shuffle
-#include <random>    // for std::mt19937
+#include <QRandomGenerator>
+
+#include "RngStream.h"
 
 CardDeck::CardDeck()
 {
@@ -10,6 +11,12 @@ CardDeck::CardDeck()
     shuffle(); // 构造时默认洗牌
 }
 
+CardDeck::CardDeck(RngStream& rng)
+{
+    initializeDecks();
+    shuffle(rng);
+}
+
 void CardDeck::initializeDecks()
 {
     m_cards.clear(); // 清空牌库中现有的牌
@@ -53,6 +60,13 @@ void CardDeck::initializeDecks()
 
 // 洗牌逻辑
 void CardDeck::shuffle()
+{
+    // 没有指定随机数流时取一个随机种子(不使用可能阻塞的std::random_device)
+    RngStream rng(QRandomGenerator::global()->generate64());
+    shuffle(rng);
+}
+
+void CardDeck::shuffle(RngStream& rng)
 {
     // 检查牌库是否为空
     if (m_cards.isEmpty()) {
@@ -61,10 +75,8 @@ void CardDeck::shuffle()
         if (m_cards.isEmpty()) return; // 如果初始化后仍然为空，直接返回(错误)
     }
 
-    // 使用随机数生成器打乱牌库
-    std::random_device rd;    // 获取随机数种子
-    std::mt19937 g(rd()); // 利用rd的随机数生成器
-    std::shuffle(m_cards.begin(), m_cards.end(), g);
+    // 使用随机数流打乱牌库
+    rng.shuffle(m_cards.begin(), m_cards.end());
     qDebug() << "CardDeck shuffled.";
 }
 
@@ -5,12 +5,16 @@
 
 #include <QVector>
 
+class RngStream;
+
 class CardDeck
 {
 public:
     CardDeck(); // 构造函数，内部固定创建两副牌
+    explicit CardDeck(RngStream& rng); // 用给定的随机数流洗牌，同一条流得到同样的牌序
 
-    void shuffle();                     // 洗牌
+    void shuffle();                     // 洗牌(随机种子)
+    void shuffle(RngStream& rng);       // 用给定的随机数流洗牌
     bool isEmpty() const;               // 检查牌堆是否为空
     void resetDeck();                   // 重置牌库并洗牌
     QVector<Card> getDeckCards() const; // 获取当前牌库中的所有牌
@@ -0,0 +1,67 @@
+#ifndef COMBOCARDS_H
+#define COMBOCARDS_H
+
+// ComboCards: ComboInfo 使用的定长内联卡牌数组
+// 合法牌型最多10张牌(8张同点数 + 2张癞子)，因此直接内联存储，复制、排序和信号传递都不分配堆内存
+// 提供与QVector<Card>相近的接口，需要QVector<Card>时可隐式转换
+
+#include <QVector>
+#include <QtGlobal>
+
+#include "Card.h"
+
+class ComboCards
+{
+public:
+    static const int Capacity = 10; // 一手牌的最大张数
+
+    ComboCards() : m_size(0) {}
+    ComboCards(const QVector<Card>& cards) : m_size(0) { assign(cards); }
+
+    ComboCards& operator=(const QVector<Card>& cards) { assign(cards); return *this; }
+
+    // 超过容量的部分会被丢弃(调用者应先保证张数不超过Capacity)
+    void assign(const QVector<Card>& cards)
+    {
+        Q_ASSERT(cards.size() <= Capacity);
+        m_size = qMin(static_cast<int>(cards.size()), static_cast<int>(Capacity));
+        for (int i = 0; i < m_size; ++i) m_cards[i] = cards[i];
+    }
+
+    void append(const Card& card)
+    {
+        Q_ASSERT(m_size < Capacity);
+        if (m_size < Capacity) m_cards[m_size++] = card;
+    }
+    void push_back(const Card& card) { append(card); }
+    void clear() { m_size = 0; }
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    bool empty() const { return m_size == 0; }
+
+    Card& operator[](int i) { return m_cards[i]; }
+    const Card& operator[](int i) const { return m_cards[i]; }
+    const Card& first() const { return m_cards[0]; }
+    const Card& last() const { return m_cards[m_size - 1]; }
+
+    Card* begin() { return m_cards; }
+    Card* end() { return m_cards + m_size; }
+    const Card* begin() const { return m_cards; }
+    const Card* end() const { return m_cards + m_size; }
+
+    QVector<Card> toVector() const
+    {
+        QVector<Card> cards;
+        cards.reserve(m_size);
+        for (int i = 0; i < m_size; ++i) cards.append(m_cards[i]);
+        return cards;
+    }
+    operator QVector<Card>() const { return toVector(); }
+
+private:
+    Card m_cards[Capacity];
+    int m_size;
+};
+
+#endif // COMBOCARDS_H
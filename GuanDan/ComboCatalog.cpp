@@ -0,0 +1,365 @@
+#include "ComboCatalog.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COMBOCATALOG_USE_SSE2
+#endif
+
+namespace {
+
+    const int kLJIndex = CardSet::RANK_COUNT - 2; // 小王的下标
+    const int kBJIndex = CardSet::RANK_COUNT - 1; // 大王的下标
+    const int kJokerBits = (1 << kLJIndex) | (1 << kBJIndex);
+
+    // 顺序值(A最小为1，A最大为14)转换为点数下标
+    int rankIndexFromOrder(int order)
+    {
+        if (order == 1 || order == 14) return CardSet::rankIndex(Card::CardPoint::Card_A);
+        return CardSet::rankIndex(static_cast<Card::CardPoint>(order));
+    }
+
+    // 顶张顺序值为top、长度为length、每个点数width张的连续牌型所需的张数
+    void fillSequence(int (&need)[CardSet::RANK_COUNT], int top, int length, int width)
+    {
+        std::memset(need, 0, sizeof(need));
+        for (int order = top - length + 1; order <= top; ++order) {
+            need[rankIndexFromOrder(order)] = width;
+        }
+    }
+
+    int bitCount4(int mask)
+    {
+        return (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+    }
+
+} // namespace
+
+ComboCatalog::HandCounts ComboCatalog::HandCounts::fromHand(const CardSet& hand, const LevelContext& ctx)
+{
+    HandCounts counts;
+    std::memset(&counts.natural, 0, sizeof(counts.natural));
+    std::memset(counts.bySuit, 0, sizeof(counts.bySuit));
+
+    quint16 mask = hand.rankMask();
+    while (mask) {
+        int r = 0;
+        while (!(mask & (1u << r))) ++r;
+        mask &= mask - 1;
+        const Card::CardPoint point = CardSet::rankAt(r);
+        for (int s = 0; s < CardSet::SUIT_COUNT; ++s) {
+            const int n = hand.count(point, static_cast<Card::CardSuit>(s));
+            if (n == 0) continue;
+            if (point == ctx.levelRank() && s == Card::Heart) { // 癞子单独计数
+                counts.wildCount += n;
+                continue;
+            }
+            counts.natural.counts[r] = static_cast<quint8>(counts.natural.counts[r] + n);
+            if (s < 4) counts.bySuit[s].counts[r] = static_cast<quint8>(n);
+        }
+    }
+    return counts;
+}
+
+const ComboCatalog& ComboCatalog::forLevel(Card::CardPoint levelRank)
+{
+    // 13种级牌的目录在第一次使用时一并生成，之后只读
+    static const std::vector<ComboCatalog> catalogs = [] {
+        std::vector<ComboCatalog> list;
+        list.reserve(LevelTables::LEVEL_COUNT);
+        for (int level = 0; level < LevelTables::LEVEL_COUNT; ++level) {
+            list.push_back(ComboCatalog(CardSet::rankAt(level)));
+        }
+        return list;
+    }();
+
+    int index = CardSet::rankIndex(levelRank);
+    if (index < 0 || index >= LevelTables::LEVEL_COUNT) index = 0;
+    return catalogs[index];
+}
+
+ComboCatalog::ComboCatalog(Card::CardPoint levelRank)
+    : m_levelRank(levelRank)
+    , m_ctx(levelRank)
+{
+    build();
+}
+
+void ComboCatalog::addEntry(int type, int level, const int (&need)[CardSet::RANK_COUNT], int suit)
+{
+    Entry entry;
+    std::memset(&entry.need, 0, sizeof(entry.need));
+    int total = 0;
+    for (int r = 0; r < CardSet::RANK_COUNT; ++r) {
+        entry.need.counts[r] = static_cast<quint8>(need[r]);
+        total += need[r];
+    }
+    entry.type = type;
+    entry.level = level;
+    entry.suit = static_cast<qint8>(suit);
+    entry.cardCount = static_cast<quint8>(total);
+    m_entries.append(entry);
+}
+
+void ComboCatalog::build()
+{
+    int need[CardSet::RANK_COUNT];
+    const int aceIndex = CardSet::rankIndex(Card::CardPoint::Card_A);
+
+    // 单张、对子、三条(大小王各只有两张，不能组成三条)
+    for (int r = 0; r < CardSet::RANK_COUNT; ++r) {
+        const int value = m_ctx.comparisonValue(CardSet::rankAt(r));
+        for (int width = 1; width <= 3; ++width) {
+            if (width == 3 && r > aceIndex) continue;
+            std::memset(need, 0, sizeof(need));
+            need[r] = width;
+            const int type = width == 1 ? CardComboType::Single : (width == 2 ? CardComboType::Pair : CardComboType::Triple);
+            addEntry(type, value, need);
+        }
+    }
+
+    // 三带二：三条为2~A，对子可以是任意其他点数(包括一对王)
+    for (int t = 0; t <= aceIndex; ++t) {
+        for (int p = 0; p < CardSet::RANK_COUNT; ++p) {
+            if (p == t) continue;
+            std::memset(need, 0, sizeof(need));
+            need[t] = 3;
+            need[p] = 2;
+            addEntry(CardComboType::TripleWithPair, m_ctx.comparisonValue(CardSet::rankAt(t)), need);
+        }
+    }
+
+    // 顺子(A2345 ~ 10JQKA)及其同花顺炸弹，等级与 evaluateConcreteCombo 一致
+    for (int top = 5; top <= 14; ++top) {
+        fillSequence(need, top, 5, 1);
+        addEntry(CardComboType::Straight, top, need);
+
+        const Card::CardPoint lead = CardSet::rankAt(rankIndexFromOrder(top));
+        const int flushLevel = 200000 + 5 * 1000 + qMax(0, m_ctx.comparisonValue(lead));
+        for (int s = 0; s < 4; ++s) {
+            addEntry(CardComboType::Bomb, flushLevel, need, s);
+        }
+    }
+
+    // 连对(三连对，A23 ~ QKA)与钢板(两连三条，A2 ~ KA)
+    for (int top = 3; top <= 14; ++top) {
+        fillSequence(need, top, 3, 2);
+        addEntry(CardComboType::DoubleSequence, top, need);
+    }
+    for (int top = 2; top <= 14; ++top) {
+        fillSequence(need, top, 2, 3);
+        addEntry(CardComboType::TripleSequence, top, need);
+    }
+
+    // 4~10张的同点数炸弹(两副牌最多8张，加上2张癞子)
+    for (int r = 0; r <= aceIndex; ++r) {
+        const int value = qMax(0, m_ctx.comparisonValue(CardSet::rankAt(r)));
+        for (int n = 4; n <= ComboCards::Capacity; ++n) {
+            std::memset(need, 0, sizeof(need));
+            need[r] = n;
+            addEntry(CardComboType::Bomb, 100000 + n * 1000 + value, need);
+        }
+    }
+
+    // 天王炸
+    std::memset(need, 0, sizeof(need));
+    need[kLJIndex] = 2;
+    need[kBJIndex] = 2;
+    addEntry(CardComboType::Bomb, 300000 + 4 * 1000 + m_ctx.comparisonValue(Card::CardPoint::Card_BJ), need);
+
+    std::sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) {
+        if (a.type != b.type) return a.type < b.type;
+        if (a.level != b.level) return a.level < b.level;
+        if (a.cardCount != b.cardCount) return a.cardCount < b.cardCount;
+        return a.suit < b.suit;
+        });
+
+    // 记录每种牌型的起止下标
+    int index = 0;
+    for (int type = 0; type <= CardComboType::Bomb + 1; ++type) {
+        while (index < m_entries.size() && m_entries[index].type < type) ++index;
+        m_typeBegin[type] = index;
+    }
+}
+
+int ComboCatalog::wildsNeeded(const Entry& entry, const HandCounts& hand) const
+{
+    const RankVector& have = entry.suit >= 0 ? hand.bySuit[entry.suit] : hand.natural;
+
+    // 缺口 = max(需要 - 拥有, 0)，缺口总数即所需癞子数；癞子不能当大小王
+    int deficit = 0;
+    int satisfied = 0; // 缺口为0的点数位掩码
+#ifdef COMBOCATALOG_USE_SSE2
+    const __m128i needVec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(entry.need.counts));
+    const __m128i haveVec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(have.counts));
+    const __m128i shortVec = _mm_subs_epu8(needVec, haveVec);
+    const __m128i sums = _mm_sad_epu8(shortVec, _mm_setzero_si128());
+    deficit = _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+    satisfied = _mm_movemask_epi8(_mm_cmpeq_epi8(shortVec, _mm_setzero_si128()));
+#else
+    for (int r = 0; r < CardSet::RANK_COUNT; ++r) {
+        const int missing = entry.need.counts[r] > have.counts[r] ? entry.need.counts[r] - have.counts[r] : 0;
+        deficit += missing;
+        if (missing == 0) satisfied |= 1 << r;
+    }
+#endif
+    if ((satisfied & kJokerBits) != kJokerBits || deficit > hand.wildCount) return -1;
+
+    // 全部由癞子组成的单张/对子只会被当作级牌打出，不能充当其他点数
+    if (deficit == entry.cardCount && entry.need.counts[CardSet::rankIndex(m_levelRank)] != entry.cardCount) return -1;
+
+    // 普通顺子的普通牌只能取同一花色时，打出后会被判为同花顺炸弹，不作为顺子提供
+    if (entry.type == CardComboType::Straight) {
+        int covered = 0;
+        int suits = 0;
+        for (int r = 0; r < CardSet::RANK_COUNT; ++r) {
+            if (!entry.need.counts[r] || !hand.natural.counts[r]) continue;
+            ++covered;
+            for (int s = 0; s < 4; ++s) {
+                if (hand.bySuit[s].counts[r]) suits |= 1 << s;
+            }
+        }
+        if (covered < 2 || bitCount4(suits) < 2) return -1;
+    }
+    return deficit;
+}
+
+const ComboCatalog::Entry* ComboCatalog::cheapestOfType(int type, int minLevel, const HandCounts& hand, int& wildsOut) const
+{
+    if (type < CardComboType::Single || type > CardComboType::Bomb) return nullptr;
+
+    // 同一牌型内按等级升序，二分跳过等级不够的项
+    const Entry* first = m_entries.constData() + m_typeBegin[type];
+    const Entry* last = m_entries.constData() + m_typeBegin[type + 1];
+    first = std::upper_bound(first, last, minLevel, [](int level, const Entry& e) { return level < e.level; });
+
+    const Entry* best = nullptr;
+    int bestWilds = 0;
+    for (const Entry* e = first; e != last; ++e) {
+        if (best && e->level != best->level) break; // 只在最低的可组成等级内比较
+        const int wilds = wildsNeeded(*e, hand);
+        if (wilds < 0) continue;
+        if (!best || wilds < bestWilds || (wilds == bestWilds && e->cardCount < best->cardCount)) {
+            best = e;
+            bestWilds = wilds;
+        }
+    }
+    wildsOut = bestWilds;
+    return best;
+}
+
+const ComboCatalog::Entry* ComboCatalog::cheapestBeat(const HandCounts& hand, int tableType, int tableLevel) const
+{
+    int wilds = 0;
+
+    // 桌面为炸弹：只能用更大的炸弹
+    if (tableType == CardComboType::Bomb) {
+        return cheapestOfType(CardComboType::Bomb, tableLevel, hand, wilds);
+    }
+
+    // 跟牌：同牌型中等级更高的最便宜项，没有时用最小的炸弹
+    if (tableType != CardComboType::Invalid) {
+        const Entry* entry = cheapestOfType(tableType, tableLevel, hand, wilds);
+        return entry ? entry : cheapestOfType(CardComboType::Bomb, -1, hand, wilds);
+    }
+
+    // 领出：在所有非炸弹牌型中按 (等级, 癞子数, 张数) 取最小
+    const Entry* best = nullptr;
+    int bestWilds = 0;
+    for (int type = CardComboType::Single; type < CardComboType::Bomb; ++type) {
+        const Entry* entry = cheapestOfType(type, -1, hand, wilds);
+        if (!entry) continue;
+        if (!best || entry->level < best->level ||
+            (entry->level == best->level && (wilds < bestWilds ||
+                (wilds == bestWilds && entry->cardCount < best->cardCount)))) {
+            best = entry;
+            bestWilds = wilds;
+        }
+    }
+    return best ? best : cheapestOfType(CardComboType::Bomb, -1, hand, wilds);
+}
+
+QVector<Card> ComboCatalog::materialize(const Entry& entry, const CardSet& hand, Player* owner) const
+{
+    QVector<Card> cards;
+    int missing = 0;
+    int chosenSuits = 0;        // 已选普通牌的花色位掩码(用于避免顺子成为同花顺)
+    int straightSwapRank = -1;  // 可以换成其他花色的点数
+
+    for (int r = 0; r < CardSet::RANK_COUNT; ++r) {
+        const int n = entry.need.counts[r];
+        if (n == 0) continue;
+        const Card::CardPoint point = CardSet::rankAt(r);
+
+        QVector<Card> available = hand.cardsOfRank(point, owner, &m_ctx); // 花色从小到大，不含癞子
+        if (entry.suit >= 0) {
+            available.erase(std::remove_if(available.begin(), available.end(),
+                [&](const Card& c) { return c.suit() != entry.suit; }), available.end());
+        }
+
+        const int take = qMin(n, static_cast<int>(available.size()));
+        for (int i = 0; i < take; ++i) {
+            cards.append(available[i]);
+            if (available[i].suit() < 4) chosenSuits |= 1 << available[i].suit();
+        }
+        missing += n - take;
+
+        if (entry.type == CardComboType::Straight && take == 1 && straightSwapRank < 0) {
+            for (const Card& c : available) {
+                if (c.suit() != available[0].suit()) { straightSwapRank = r; break; }
+            }
+        }
+    }
+
+    // 顺子的普通牌都取成了同一花色时，把一个点数换成其他花色
+    if (entry.type == CardComboType::Straight && bitCount4(chosenSuits) == 1) {
+        if (straightSwapRank < 0) return {};
+        const Card::CardPoint point = CardSet::rankAt(straightSwapRank);
+        for (Card& c : cards) {
+            if (c.point() != point) continue;
+            for (const Card& alt : hand.cardsOfRank(point, owner, &m_ctx)) {
+                if (alt.suit() != c.suit()) { c = alt; break; }
+            }
+            break;
+        }
+    }
+
+    // 缺口用癞子补齐
+    if (missing > hand.count(m_levelRank, Card::Heart)) return {};
+    for (int i = 0; i < missing; ++i) {
+        cards.append(Card(m_levelRank, Card::Heart, owner));
+    }
+
+    std::sort(cards.begin(), cards.end(), m_ctx.less());
+    return cards;
+}
+
+void ComboCatalog::consume(const Entry& entry, HandCounts& hand) const
+{
+    int missing = 0;
+    for (int r = 0; r < CardSet::RANK_COUNT; ++r) {
+        int n = entry.need.counts[r];
+        if (n == 0) continue;
+
+        if (entry.suit >= 0) {
+            const int take = qMin(n, static_cast<int>(hand.bySuit[entry.suit].counts[r]));
+            hand.bySuit[entry.suit].counts[r] = static_cast<quint8>(hand.bySuit[entry.suit].counts[r] - take);
+            hand.natural.counts[r] = static_cast<quint8>(hand.natural.counts[r] - take);
+            missing += n - take;
+            continue;
+        }
+
+        const int take = qMin(n, static_cast<int>(hand.natural.counts[r]));
+        hand.natural.counts[r] = static_cast<quint8>(hand.natural.counts[r] - take);
+        missing += n - take;
+        for (int s = 0, left = take; s < 4 && left > 0; ++s) {
+            const int k = qMin(left, static_cast<int>(hand.bySuit[s].counts[r]));
+            hand.bySuit[s].counts[r] = static_cast<quint8>(hand.bySuit[s].counts[r] - k);
+            left -= k;
+        }
+    }
+    hand.wildCount = qMax(0, hand.wildCount - missing);
+}
@@ -0,0 +1,84 @@
+#ifndef COMBOCATALOG_H
+#define COMBOCATALOG_H
+
+// ComboCatalog: 某一级牌下所有抽象牌型的目录
+// 级牌确定后，掼蛋的抽象牌型是有限的：各点数的单张/对子/三条、各顶张的顺子、三带二、钢板、连对、
+// 各张数各点数的炸弹、同花顺和天王炸，共约四百项
+// 目录按 (牌型, 等级) 排序，查询"最便宜的压牌"时从桌面牌型向上逐项检查手牌能否组成，
+// 检查只需对点数计数向量做一次饱和减法(SSE2)即可得到所需癞子数，不必先枚举再过滤
+
+#include <QVector>
+#include <QtGlobal>
+
+#include "Card.h"
+#include "CardSet.h"
+#include "Cardcombo.h"
+#include "LevelContext.h"
+
+class Player;
+
+class ComboCatalog
+{
+public:
+    // 按点数下标(Card_2为0)存放的计数向量，凑满16字节便于SIMD运算
+    struct alignas(16) RankVector {
+        quint8 counts[16];
+    };
+
+    struct Entry {
+        RankVector need;      // 每种点数需要的张数
+        int type;             // CardComboType
+        int level;            // 与 CardCombo::evaluateConcreteCombo 相同的等级
+        qint8 suit;           // 同花顺所需的花色，其他牌型为-1
+        quint8 cardCount;     // 总张数
+    };
+
+    // 手牌的计数视图：普通牌(不含癞子)按点数、按花色的计数，以及癞子数
+    struct HandCounts {
+        RankVector natural;
+        RankVector bySuit[4];
+        int wildCount = 0;
+
+        static HandCounts fromHand(const CardSet& hand, const LevelContext& ctx);
+    };
+
+    // 取得某一级牌的目录(首次使用时生成)
+    static const ComboCatalog& forLevel(Card::CardPoint levelRank);
+
+    Card::CardPoint levelRank() const { return m_levelRank; }
+    const QVector<Entry>& entries() const { return m_entries; }
+
+    // 某一牌型(Single~Bomb)的目录项范围[typeBegin, typeEnd)，按等级升序
+    const Entry* typeBegin(int type) const { return m_entries.constData() + m_typeBegin[type]; }
+    const Entry* typeEnd(int type) const { return m_entries.constData() + m_typeBegin[type + 1]; }
+
+    // 手牌组成该目录项需要的癞子数，不能组成时返回-1
+    int wildsNeeded(const Entry& entry, const HandCounts& hand) const;
+
+    // 找出能压过桌面牌型的最便宜目录项(非炸弹优先，等级低优先，癞子少优先)，找不到时返回nullptr
+    // 桌面为空(Invalid)时返回最便宜的领出牌型
+    const Entry* cheapestBeat(const HandCounts& hand, int tableType, int tableLevel) const;
+
+    // 在某一牌型内找出等级高于minLevel的最便宜可组成项，找不到时返回nullptr
+    const Entry* cheapestOfType(int type, int minLevel, const HandCounts& hand, int& wildsOut) const;
+
+    // 用手牌中的具体牌(含癞子)组成目录项，不能组成时返回空数组
+    QVector<Card> materialize(const Entry& entry, const CardSet& hand, Player* owner) const;
+
+    // 在计数视图上打出目录项(供模拟对局使用)：先扣普通牌，缺口扣癞子；调用前须确认能够组成
+    // 非同花顺牌型不区分花色，按花色从小到大扣除
+    void consume(const Entry& entry, HandCounts& hand) const;
+
+private:
+    explicit ComboCatalog(Card::CardPoint levelRank);
+
+    void build();
+    void addEntry(int type, int level, const int (&need)[CardSet::RANK_COUNT], int suit = -1);
+
+    Card::CardPoint m_levelRank;
+    LevelContext m_ctx;
+    QVector<Entry> m_entries;
+    int m_typeBegin[CardComboType::Bomb + 2]; // 每种牌型在目录中的起止下标
+};
+
+#endif // COMBOCATALOG_H
@@ -0,0 +1,69 @@
+#include "ComboKey.h"
+
+ComboKeySet::ComboKeySet(int expectedSize)
+    : m_size(0)
+    , m_hasEmptyKey(false)
+{
+    // 容量取2的幂，负载因子不超过1/2
+    int capacity = 16;
+    while (capacity < expectedSize * 2) capacity <<= 1;
+    m_slots.resize(capacity);
+}
+
+int ComboKeySet::findSlot(const ComboKey& key) const
+{
+    const int mask = m_slots.size() - 1;
+    int slot = static_cast<int>(key.hash() & static_cast<quint64>(mask));
+    // 线性探测
+    while (!m_slots[slot].isEmpty() && m_slots[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+bool ComboKeySet::insert(const ComboKey& key)
+{
+    if (key.isEmpty()) {
+        if (m_hasEmptyKey) return false;
+        m_hasEmptyKey = true;
+        ++m_size;
+        return true;
+    }
+
+    int slot = findSlot(key);
+    if (!m_slots[slot].isEmpty()) return false; // 已存在
+
+    // 超过负载因子时扩容后重新定位
+    if ((m_size + 1) * 2 > m_slots.size()) {
+        rehash(m_slots.size() * 2);
+        slot = findSlot(key);
+    }
+    m_slots[slot] = key;
+    ++m_size;
+    return true;
+}
+
+bool ComboKeySet::contains(const ComboKey& key) const
+{
+    if (key.isEmpty()) return m_hasEmptyKey;
+    return !m_slots[findSlot(key)].isEmpty();
+}
+
+void ComboKeySet::clear()
+{
+    m_slots.fill(ComboKey());
+    m_size = 0;
+    m_hasEmptyKey = false;
+}
+
+void ComboKeySet::rehash(int newCapacity)
+{
+    QVector<ComboKey> oldSlots = m_slots;
+    m_slots.clear();
+    m_slots.resize(newCapacity);
+    for (const ComboKey& key : oldSlots) {
+        if (!key.isEmpty()) {
+            m_slots[findSlot(key)] = key;
+        }
+    }
+}
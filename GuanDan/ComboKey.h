@@ -0,0 +1,81 @@
+#ifndef COMBOKEY_H
+#define COMBOKEY_H
+
+// ComboKey: 牌组的规范整数键，用于唯一标识牌组
+// 54种牌(52张普通牌 + 小王 + 大王)各占2位计数，共108位，存放在两个64位整数中
+// 两副牌中同一张牌最多2张，计数不会溢出；键与牌的顺序无关
+// ComboKeySet: 开放寻址的扁平哈希集合，插入和查询不为每个候选分配内存
+
+#include <QVector>
+#include <QtGlobal>
+
+#include "Card.h"
+
+struct ComboKey
+{
+    quint64 lo = 0; // 牌编号 0 ~ 31
+    quint64 hi = 0; // 牌编号 32 ~ 53
+
+    // 牌编号：普通牌为 (点数-2)*4+花色，小王52，大王53
+    static int cardId(const Card& card)
+    {
+        if (card.point() == Card::Card_LJ) return 52;
+        if (card.point() == Card::Card_BJ) return 53;
+        return (static_cast<int>(card.point()) - static_cast<int>(Card::Card_2)) * 4 + static_cast<int>(card.suit());
+    }
+
+    void add(const Card& card)
+    {
+        const int bit = cardId(card) * 2;
+        if (bit < 64) lo += quint64(1) << bit;
+        else hi += quint64(1) << (bit - 64);
+    }
+
+    // 可用于 QVector<Card> 或 ComboCards
+    template <typename Cards>
+    static ComboKey fromCards(const Cards& cards)
+    {
+        ComboKey key;
+        for (const Card& card : cards) key.add(card);
+        return key;
+    }
+
+    bool isEmpty() const { return lo == 0 && hi == 0; }
+
+    // 64位混合哈希(splitmix64的终结步骤)
+    quint64 hash() const
+    {
+        quint64 h = lo ^ (hi * 0x9E3779B97F4A7C15ULL);
+        h ^= h >> 30; h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 27; h *= 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+        return h;
+    }
+
+    friend bool operator==(const ComboKey& a, const ComboKey& b) { return a.lo == b.lo && a.hi == b.hi; }
+    friend bool operator!=(const ComboKey& a, const ComboKey& b) { return !(a == b); }
+};
+
+class ComboKeySet
+{
+public:
+    explicit ComboKeySet(int expectedSize = 64);
+
+    // 插入成功(之前不存在)时返回true
+    bool insert(const ComboKey& key);
+    bool contains(const ComboKey& key) const;
+    void clear();
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+private:
+    int findSlot(const ComboKey& key) const; // 返回key所在的槽位或应插入的空槽位
+    void rehash(int newCapacity);
+
+    QVector<ComboKey> m_slots; // 空槽位用全0键表示(合法牌组至少有一张牌)
+    int m_size;
+    bool m_hasEmptyKey;        // 空牌组单独记录
+};
+
+#endif // COMBOKEY_H
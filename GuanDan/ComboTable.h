@@ -0,0 +1,129 @@
+#ifndef COMBOTABLE_H
+#define COMBOTABLE_H
+
+// ComboTable: 按点数直方图签名查表判断牌型
+// 合法牌型最多10张牌，牌型只取决于 "各点数张数的多重集合 + 点数是否连续"
+// 签名 = 单张点数个数、对子点数个数、三张点数个数、四张及以上点数个数、是否连续
+// 表在编译期生成，evaluateConcreteCombo 只需统计直方图后查一次表
+
+#include <QtGlobal>
+
+#include "Card.h"
+#include "Cardcombo.h"
+
+namespace ComboTables {
+
+    // 牌型等级的计算方式
+    enum LevelRule : signed char {
+        NoLevel = 0,      // 非法牌型
+        RankValue,        // 主点数(张数最多的点数)的比较值：单张、对子、三条、三带二
+        SequenceLead,     // 连续结构最大点的顺序值：顺子、连对、钢板(顺子可能升级为同花顺)
+        RankBomb          // 普通炸弹：张数 + 主点数比较值
+    };
+
+    struct Entry {
+        signed char type = CardComboType::Invalid;
+        signed char rule = NoLevel;
+    };
+
+    // 签名各字段的上限，超过上限必然不是合法牌型
+    const int MAX_SINGLES = 7;
+    const int MAX_PAIRS = 3;
+    const int MAX_TRIPLES = 3;
+    const int MAX_QUADS = 1;
+    const int TABLE_SIZE = (MAX_SINGLES + 1) * (MAX_PAIRS + 1) * (MAX_TRIPLES + 1) * (MAX_QUADS + 1) * 2;
+
+    // 打包签名，超出范围时返回-1
+    constexpr int signatureIndex(int singles, int pairs, int triples, int quads, bool consecutive)
+    {
+        if (singles > MAX_SINGLES || pairs > MAX_PAIRS || triples > MAX_TRIPLES || quads > MAX_QUADS) return -1;
+        return ((((singles * (MAX_PAIRS + 1) + pairs) * (MAX_TRIPLES + 1) + triples) * (MAX_QUADS + 1) + quads) * 2)
+            + (consecutive ? 1 : 0);
+    }
+
+    // 与 evaluateConcreteCombo 原有的判断顺序一致：同点数 > 连续结构 > 三带二
+    constexpr Entry classify(int singles, int pairs, int triples, int quads, bool consecutive)
+    {
+        Entry e;
+        const int distinct = singles + pairs + triples + quads;
+        if (distinct == 1) {
+            if (singles) e.type = CardComboType::Single;
+            else if (pairs) e.type = CardComboType::Pair;
+            else if (triples) e.type = CardComboType::Triple;
+            else e.type = CardComboType::Bomb;
+            e.rule = quads ? RankBomb : RankValue;
+        }
+        else if (consecutive && singles == 5 && distinct == 5) {
+            e.type = CardComboType::Straight;
+            e.rule = SequenceLead;
+        }
+        else if (consecutive && pairs == 3 && distinct == 3) {
+            e.type = CardComboType::DoubleSequence;
+            e.rule = SequenceLead;
+        }
+        else if (consecutive && triples == 2 && distinct == 2) {
+            e.type = CardComboType::TripleSequence;
+            e.rule = SequenceLead;
+        }
+        else if (triples == 1 && pairs == 1 && distinct == 2) {
+            e.type = CardComboType::TripleWithPair;
+            e.rule = RankValue;
+        }
+        return e;
+    }
+
+    struct Table {
+        Entry entries[TABLE_SIZE];
+    };
+
+    constexpr Table makeTable()
+    {
+        Table table{};
+        for (int s = 0; s <= MAX_SINGLES; ++s)
+            for (int p = 0; p <= MAX_PAIRS; ++p)
+                for (int t = 0; t <= MAX_TRIPLES; ++t)
+                    for (int q = 0; q <= MAX_QUADS; ++q)
+                        for (int c = 0; c < 2; ++c)
+                            table.entries[signatureIndex(s, p, t, q, c != 0)] = classify(s, p, t, q, c != 0);
+        return table;
+    }
+
+    inline constexpr Table kTable = makeTable();
+
+    // 判断是否为由1开始的连续低位，如 0b0111
+    constexpr bool isContiguousBits(quint16 bits)
+    {
+        if (bits == 0) return false;
+        while ((bits & 1u) == 0) bits >>= 1;
+        return (bits & (bits + 1u)) == 0;
+    }
+
+    // 与 CardCombo::checkConsecutive 规则一致，输入为 CardSet::rankMask() (第0位为Card_2)
+    // 含大小王时不连续；先按A最小判断，再按A最大判断；通过lead_point返回连续结构的最大点
+    constexpr bool checkConsecutiveMask(quint16 rank_mask, Card::CardPoint& lead_point)
+    {
+        const quint16 joker_bits = static_cast<quint16>((1u << (Card::Card_LJ - Card::Card_2)) | (1u << (Card::Card_BJ - Card::Card_2)));
+        if (rank_mask == 0 || (rank_mask & joker_bits)) return false;
+
+        const quint16 ace_bit = static_cast<quint16>(1u << (Card::Card_A - Card::Card_2));
+        // A最小：第0位为A，第1位为2 ... 第12位为K
+        const quint16 low_mask = static_cast<quint16>(((rank_mask & (ace_bit - 1u)) << 1) | ((rank_mask & ace_bit) ? 1u : 0u));
+        if (isContiguousBits(low_mask)) {
+            int top = 0;
+            for (int b = 0; b < 13; ++b) {
+                if (low_mask & (1u << b)) top = b;
+            }
+            lead_point = (top == 0) ? Card::Card_A : static_cast<Card::CardPoint>(top + 1);
+            return true;
+        }
+        // A最大：第0位为2 ... 第12位为A
+        if ((rank_mask & ace_bit) && isContiguousBits(rank_mask)) {
+            lead_point = Card::Card_A;
+            return true;
+        }
+        return false;
+    }
+
+} // namespace ComboTables
+
+#endif // COMBOTABLE_H
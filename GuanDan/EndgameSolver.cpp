@@ -0,0 +1,305 @@
+#include "EndgameSolver.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QVarLengthArray>
+#include <QDebug>
+#include <algorithm>
+
+#include "RngStream.h"
+#include "Zobrist.h"
+
+namespace {
+
+    const int kPassMove = -1;          // 过牌的走法编号
+    const int kNoMove = -2;            // 置换表中没有记录最好的走法
+    const int kScoreBound = 4;         // 得分在[-3, 3]之间，初始窗口取[-4, 4]
+    const int kTimeCheckInterval = 1024; // 每搜索这么多节点检查一次时间和取消标志
+
+    bool sameTeam(int a, int b)
+    {
+        return a == b || a == Rollout::partnerOf(b);
+    }
+
+    // 当前局面的所有走法(目录项下标或kPassMove)：领出时为手牌能组成的所有目录项；
+    // 跟牌时为过牌、同牌型中更大的项和更大的炸弹。能一手出完的走法排在最前，其次非炸弹、张数多的优先
+    void generateMoves(const ComboCatalog& catalog, const Rollout::SimState& st, QVarLengthArray<int, 64>& moves)
+    {
+        const ComboCatalog::HandCounts& hand = st.hands[st.toMove];
+        const int left = st.left[st.toMove];
+        const ComboCatalog::Entry* first = catalog.entries().constData();
+
+        auto collect = [&](int type, int minLevel) {
+            for (const ComboCatalog::Entry* e = catalog.typeBegin(type); e != catalog.typeEnd(type); ++e) {
+                if (e->level <= minLevel || e->cardCount > left) continue;
+                if (catalog.wildsNeeded(*e, hand) >= 0) moves.append(int(e - first));
+            }
+        };
+
+        if (st.tableType == CardComboType::Invalid) {
+            for (int type = CardComboType::Single; type <= CardComboType::Bomb; ++type) collect(type, -1);
+        } else {
+            if (st.tableType != CardComboType::Bomb) collect(st.tableType, st.tableLevel);
+            collect(CardComboType::Bomb, st.tableType == CardComboType::Bomb ? st.tableLevel : -1);
+        }
+
+        auto orderKey = [&](int move) {
+            const ComboCatalog::Entry& e = catalog.entries()[move];
+            int key = e.cardCount == left ? 0 : 1000;
+            if (e.type == CardComboType::Bomb) key += 100;
+            return key - e.cardCount;
+        };
+        std::stable_sort(moves.begin(), moves.end(), [&](int a, int b) { return orderKey(a) < orderKey(b); });
+
+        if (st.tableType != CardComboType::Invalid) moves.append(kPassMove);
+    }
+
+    // 所有工作线程共享的搜索数据
+    struct SearchShared {
+        SearchShared(Card::CardPoint levelRank, int budgetMs) : ctx(levelRank), budget(budgetMs) {}
+
+        const Rollout::Situation* situation;
+        const QVector<Rollout::Candidate>* candidates;
+        const ComboCatalog* catalog;
+        TranspositionTable* table;
+        LevelContext ctx;
+        Rollout::SimState base;
+        QVector<Card> unseen;
+        QVector<ComboCatalog::HandCounts> handsAfter;  // 每个候选出牌后决策者的手牌
+        Rollout::SearchBudget budget;
+        const std::atomic<bool>* cancel;
+        bool exact;
+
+        QMutex mutex;
+        QVector<double> totals;
+        int samples = 0;
+        qint64 nodes = 0;
+        qint64 probes = 0;
+        qint64 hits = 0;
+        qint64 solveNs = 0;                            // 完成的求解累计耗时
+    };
+
+    // 工作线程：反复确定化，每次精确求解所有候选；超时或取消时未完成的那次不计入
+    void runWorker(SearchShared& shared, RngStream rng)
+    {
+        const Rollout::Situation& sit = *shared.situation;
+        const QVector<Rollout::Candidate>& candidates = *shared.candidates;
+        EndgameSolver solver(*shared.catalog, *shared.table);
+        solver.setBudget(&shared.budget, shared.cancel);
+        QVector<Card> deck = shared.unseen;
+        Rollout::SimState dealt = shared.base;
+        QVector<double> totals(candidates.size(), 0.0);
+        QVector<int> scores(candidates.size(), 0);
+        int samples = 0;
+        qint64 solveNs = 0;
+
+        bool complete = true;
+        shared.budget.begin();
+        do {
+            const qint64 startNs = shared.budget.elapsedNs();
+            Rollout::deal(dealt, deck, sit, shared.ctx, rng);
+            for (int i = 0; i < candidates.size() && complete; ++i) {
+                const Rollout::Candidate& cand = candidates[i];
+                Rollout::SimState st = dealt;
+                st.hands[sit.seat] = shared.handsAfter[i];
+                if (cand.cards.isEmpty()) {
+                    Rollout::pass(st);
+                } else {
+                    Rollout::play(st, cand.type, cand.level, cand.cards.size());
+                }
+                complete = solver.solve(st, sit.seat, scores[i]);
+            }
+            if (!complete) break;
+            for (int i = 0; i < candidates.size(); ++i) totals[i] += scores[i];
+            ++samples;
+            solveNs += shared.budget.elapsedNs() - startNs;
+        } while (!shared.exact && !shared.budget.expired()
+            && !(shared.cancel && shared.cancel->load(std::memory_order_relaxed)));
+
+        QMutexLocker locker(&shared.mutex);
+        for (int i = 0; i < totals.size(); ++i) shared.totals[i] += totals[i];
+        shared.samples += samples;
+        shared.nodes += solver.nodes();
+        shared.probes += solver.tableProbes();
+        shared.hits += solver.tableHits();
+        shared.solveNs += solveNs;
+    }
+
+} // namespace
+
+EndgameSolver::EndgameSolver(const ComboCatalog& catalog, TranspositionTable& table)
+    : m_catalog(catalog)
+    , m_table(table)
+{
+}
+
+void EndgameSolver::setBudget(const Rollout::SearchBudget* budget, const std::atomic<bool>* cancel)
+{
+    m_budget = budget;
+    m_cancel = cancel;
+}
+
+bool EndgameSolver::timeUp()
+{
+    if (m_cancel && m_cancel->load(std::memory_order_relaxed)) return true;
+    return m_budget && m_budget->expired();
+}
+
+bool EndgameSolver::solve(const Rollout::SimState& st, int seat, int& score)
+{
+    m_rootSeat = seat;
+    m_aborted = false;
+    const qint64 probesBefore = m_probes;
+    const qint64 hitsBefore = m_hits;
+
+    quint64 handKeys = Zobrist::perspectiveKey(seat, m_catalog.levelRank());
+    for (int s = 0; s < Rollout::SEAT_COUNT; ++s) handKeys ^= Zobrist::handKey(s, st.hands[s]);
+    score = alphaBeta(st, handKeys, -kScoreBound, kScoreBound);
+
+    m_table.recordProbes(m_probes - probesBefore, m_hits - hitsBefore);
+    return !m_aborted;
+}
+
+int EndgameSolver::alphaBeta(const Rollout::SimState& st, quint64 handKeys, int alpha, int beta)
+{
+    if (++m_nodes % kTimeCheckInterval == 0 && timeUp()) m_aborted = true;
+    if (m_aborted) return 0;
+    if (Rollout::isSettled(st)) return static_cast<int>(Rollout::outcomeScore(st, m_rootSeat));
+
+    const quint64 key = Zobrist::positionKey(st, handKeys);
+    int hashMove = kNoMove;
+    TranspositionTable::Entry found;
+    ++m_probes;
+    if (m_table.probe(key, found)) {
+        ++m_hits;
+        if (found.bound == TranspositionTable::Exact) return found.value;
+        if (found.bound == TranspositionTable::Lower) alpha = qMax(alpha, found.value);
+        else beta = qMin(beta, found.value);
+        if (alpha >= beta) return found.value;
+        hashMove = found.bestMove;
+    }
+
+    QVarLengthArray<int, 64> moves;
+    generateMoves(m_catalog, st, moves);
+    if (moves.isEmpty()) {
+        // 领出却无牌可出，只在手牌计数异常时出现，按当前名次计分
+        return static_cast<int>(Rollout::outcomeScore(st, m_rootSeat));
+    }
+    if (hashMove != kNoMove) {
+        const auto it = std::find(moves.begin(), moves.end(), hashMove);
+        if (it != moves.end()) std::rotate(moves.begin(), it, it + 1);
+    }
+
+    const int alphaOrig = alpha;
+    const int betaOrig = beta;
+    const bool maximizing = sameTeam(st.toMove, m_rootSeat);
+    int best = maximizing ? -kScoreBound : kScoreBound;
+    int bestMove = moves[0];
+    for (int move : moves) {
+        Rollout::SimState child = st;
+        quint64 childKeys = handKeys;
+        if (move == kPassMove) {
+            Rollout::pass(child);
+        } else {
+            const ComboCatalog::Entry& entry = m_catalog.entries()[move];
+            const int seat = child.toMove;
+            m_catalog.consume(entry, child.hands[seat]);
+            childKeys ^= Zobrist::handDelta(seat, st.hands[seat], child.hands[seat], entry);
+            Rollout::play(child, entry.type, entry.level, entry.cardCount);
+        }
+        const int value = alphaBeta(child, childKeys, alpha, beta);
+        if (m_aborted) return 0;
+
+        if (maximizing ? value > best : value < best) {
+            best = value;
+            bestMove = move;
+        }
+        if (maximizing) alpha = qMax(alpha, best);
+        else beta = qMin(beta, best);
+        if (alpha >= beta) break;
+    }
+
+    TranspositionTable::Entry entry;
+    entry.value = best;
+    entry.bound = best <= alphaOrig ? TranspositionTable::Upper : (best >= betaOrig ? TranspositionTable::Lower : TranspositionTable::Exact);
+    entry.bestMove = bestMove;
+    m_table.store(key, entry);
+    return best;
+}
+
+bool EndgameSolver::applies(const Rollout::Situation& situation)
+{
+    int total = 0;
+    for (int s = 0; s < Rollout::SEAT_COUNT; ++s) {
+        total += s == situation.seat ? situation.hand.size() : situation.handCounts[s];
+    }
+    return total > 0 && total <= kCardThreshold;
+}
+
+EndgameSolver::Result EndgameSolver::search(const Rollout::Situation& situation, const QVector<Rollout::Candidate>& candidates,
+    int budgetMs, int threadCount, quint64 seed, const std::atomic<bool>* cancel)
+{
+    Result result;
+    if (candidates.isEmpty()) return result;
+    result.meanScores.fill(0.0, candidates.size());
+
+    SearchShared shared(situation.levelRank, budgetMs);
+    shared.situation = &situation;
+    shared.candidates = &candidates;
+    shared.catalog = &ComboCatalog::forLevel(situation.levelRank);
+    shared.table = &TranspositionTable::shared();
+    shared.base = Rollout::fromSituation(situation, shared.ctx);
+    shared.unseen = Rollout::unseenCards(situation);
+    shared.cancel = cancel;
+    shared.totals.fill(0.0, candidates.size());
+    for (const Rollout::Candidate& cand : candidates) {
+        CardSet after = situation.hand;
+        for (const Card& card : cand.cards) after.remove(card);
+        shared.handsAfter.append(ComboCatalog::HandCounts::fromHand(after, shared.ctx));
+    }
+
+    // 只剩一家对手还有牌时，未出现的牌都在他手中，补全是唯一的，只需一个线程求解一次
+    int hiddenHands = 0;
+    for (int s = 0; s < Rollout::SEAT_COUNT; ++s) {
+        if (s != situation.seat && situation.handCounts[s] > 0) ++hiddenHands;
+    }
+    result.exact = hiddenHands <= 1;
+    shared.exact = result.exact;
+
+    const int threads = result.exact ? 1 : (threadCount > 0 ? threadCount : qMax(1, QThread::idealThreadCount()));
+    QThreadPool& pool = Rollout::threadPool();
+    if (pool.maxThreadCount() < threads) pool.setMaxThreadCount(threads);
+
+    const RngStream rng(seed); // 每个线程取一条子流
+    QSemaphore done;
+    for (int t = 0; t < threads; ++t) {
+        pool.start([&shared, &done, &rng, t]() {
+            runWorker(shared, rng.split(static_cast<quint64>(t)));
+            done.release();
+        });
+    }
+    done.acquire(threads);
+
+    const qint64 elapsedNs = qMax<qint64>(1, shared.budget.elapsedNs());
+    result.samples = shared.samples;
+    result.nodes = shared.nodes;
+    result.nodesPerSecond = result.nodes * 1e9 / elapsedNs;
+    result.tableHitRate = shared.probes > 0 ? double(shared.hits) / shared.probes : 0.0;
+    result.threads = threads;
+    if (result.samples > 0) {
+        result.solveMs = shared.solveNs / 1e6 / result.samples;
+        result.bestIndex = 0;
+        for (int i = 0; i < candidates.size(); ++i) {
+            result.meanScores[i] = shared.totals[i] / result.samples;
+            if (result.meanScores[i] > result.meanScores[result.bestIndex]) result.bestIndex = i;
+        }
+    }
+
+    qDebug() << "EndgameSolver::search:" << candidates.size() << "candidates," << result.samples << "solves"
+        << (result.exact ? "(exact)" : "") << result.nodes << "nodes in" << elapsedNs / 1000000 << "ms on" << threads << "threads ("
+        << qRound(result.nodesPerSecond) << "nodes/s," << result.solveMs << "ms per solve, table hit rate" << result.tableHitRate << ").";
+    return result;
+}
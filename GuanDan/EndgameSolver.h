@@ -0,0 +1,74 @@
+#ifndef ENDGAMESOLVER_H
+#define ENDGAMESOLVER_H
+
+// EndgameSolver: 残局精确搜索
+// 仍在打牌的玩家剩余张数之和不超过kCardThreshold时，在点数计数局面(Rollout::SimState)上搜索完整的博弈树：
+// 走法为手牌能组成的所有目录项和过牌，用alpha-beta剪枝和共用的置换表(Zobrist键增量维护，见TranspositionTable)，
+// 得分为最终名次的升级数(见Rollout::outcomeScore)
+// 抢头游、给对家送牌等收官打法由搜索自然得出，不需要单独的规则
+// 求解需要完全信息：AI使用时像PimcSearch一样随机补全其他玩家的手牌，每次确定化精确求解后按平均得分选择；
+// 各确定化在线程池中并行求解；只剩一家对手未知时补全是唯一的，一次求解即为精确结果
+
+#include <QVector>
+#include <atomic>
+
+#include "ComboCatalog.h"
+#include "Rollout.h"
+#include "TranspositionTable.h"
+
+class EndgameSolver
+{
+public:
+    static const int kCardThreshold = 20; // 剩余总张数不超过该值时使用残局搜索
+
+    struct Result {
+        int bestIndex = -1;          // 平均得分最高的候选；预算内未能完成一次求解时为-1(调用者应退回启发式选牌)
+        QVector<double> meanScores;  // 各候选的平均得分(升级数，对方得分为负)
+        int samples = 0;             // 完整求解的确定化次数
+        bool exact = false;          // 补全唯一(只剩一家对手)，结果即为精确值
+        qint64 nodes = 0;            // 搜索的节点总数
+        double nodesPerSecond = 0;
+        double solveMs = 0;          // 平均每次确定化的求解耗时(毫秒，单个线程)
+        double tableHitRate = 0;     // 本次搜索置换表查询的命中率
+        int threads = 0;
+    };
+
+    // 局面是否适合残局搜索：剩余总张数不超过kCardThreshold
+    static bool applies(const Rollout::Situation& situation);
+
+    // 在时间预算内反复确定化并精确求解每个候选；cancel置位或超出预算时停止，未完成的那次求解不计入
+    // threadCount: 并行求解的线程数，<=0时按CPU核数；置换表用TranspositionTable::shared()
+    // seed: 补全手牌的随机数种子，各线程由它分出子流
+    static Result search(const Rollout::Situation& situation, const QVector<Rollout::Candidate>& candidates,
+        int budgetMs, int threadCount, quint64 seed, const std::atomic<bool>* cancel = nullptr);
+
+    EndgameSolver(const ComboCatalog& catalog, TranspositionTable& table);
+
+    // 设置求解的时间预算和取消标志
+    void setBudget(const Rollout::SearchBudget* budget, const std::atomic<bool>* cancel);
+
+    // 精确求解完全信息局面，得分从seat所在队伍看；超时或取消时返回false
+    bool solve(const Rollout::SimState& st, int seat, int& score);
+
+    qint64 nodes() const { return m_nodes; }
+    qint64 tableProbes() const { return m_probes; }
+    qint64 tableHits() const { return m_hits; }
+
+private:
+    // handKeys为各家手牌键和得分视角键的异或，随出牌增量更新
+    int alphaBeta(const Rollout::SimState& st, quint64 handKeys, int alpha, int beta);
+    bool timeUp();
+
+    const ComboCatalog& m_catalog;
+    TranspositionTable& m_table;
+    int m_rootSeat = 0;
+    qint64 m_nodes = 0;
+    qint64 m_probes = 0;
+    qint64 m_hits = 0;
+    bool m_aborted = false;
+
+    const Rollout::SearchBudget* m_budget = nullptr;
+    const std::atomic<bool>* m_cancel = nullptr;
+};
+
+#endif // ENDGAMESOLVER_H
@@ -1,33 +1,35 @@
 #include "GD_Controller.h"
-#include <QRandomGenerator>
+#include <QCoreApplication>
 #include <QDebug>
 #include <algorithm>
 #include <QTextStream>
 #include <QTimer>
 
-#include "carddeck.h"
 #include "WildCardDialog.h"
-#include "NPCPlayer.h"
 #include "SoundManager.h"
 #include "SettingsManager.h"
 
+namespace {
+    // AI出牌前的最短思考时间(毫秒)，搜索时间计入其中，总时长保持稳定
+    const int kAiThinkDelayMs = 500;
+    // 轮到AI后开始思考前的停顿(毫秒)
+    const int kAiTurnDelayMs = 500;
+    // AI进贡/还贡前的停顿(毫秒)
+    const int kAiTributeDelayMs = 1000;
+    // 一圈结束后开始新一圈前的停顿(毫秒)，让玩家有时间看清上一手牌
+    const int kCircleEndPauseMs = 1500;
+
+    const int kCardsPerPlayer = 4; // 测试
+    //const int kCardsPerPlayer = 27;
+}
+
 GD_Controller::GD_Controller(QObject* parent)
     : QObject(parent)
-    , m_currentPlayerId(-1)
-    , m_circleLeaderId(-1)
-    , m_activePlayersInRound(0)
-    , m_currentRoundNumber(0)
-    , m_currentPhase(GamePhase::NotStarted)
-    , m_currentTributeIndex(0)
     , m_turnTimeoutTimer(nullptr)
     , m_tickTimer(nullptr)
     , m_turnDuration(30)
     , m_timeRemaining(30)
 {
-    // 初始化当前桌面牌型为空
-    m_currentTableCombo.type = CardComboType::Invalid;
-    m_currentTableCombo.cards_in_combo.clear();
-
     // 初始化计时器
     m_turnTimeoutTimer = new QTimer(this);
     m_turnTimeoutTimer->setSingleShot(true); // 超时只触发一次
@@ -35,75 +37,58 @@ GD_Controller::GD_Controller(QObject* parent)
 
     m_tickTimer = new QTimer(this);
     connect(m_tickTimer, &QTimer::timeout, this, &GD_Controller::onTick);
+
+    // 对局记录只追加，每局结束时写入文件
+    m_recordFile.setFileName(QCoreApplication::applicationDirPath() + "/GuanDan.gdr");
+    if (m_recordFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        m_recorder.setDevice(&m_recordFile);
+    }
+    else {
+        qWarning() << "GD_Controller: 无法打开对局记录文件，本次不记录对局:" << m_recordFile.errorString();
+    }
 }
 
 GD_Controller::~GD_Controller()
 {
-    // 析构函数，资源清理由外部管理
+    // 析构函数，资源清理由外部管理；进行中的选牌任务取消，结果不再交回
+    clearAiCache();
 }
 
 
 void GD_Controller::setupNewGame(const QVector<Player*>& players, const QVector<Team*>& teams)
 {
-    // 清理之前的数据
-    m_players.clear();
-    m_teams.clear();
-    m_passedPlayersInCircle.clear();
-    m_roundFinishOrder.clear();
-    m_pendingTributes.clear();
-
-    // 验证玩家和队伍数量
-    if (players.size() != 4 || teams.size() != 2) {
-        qDebug() << "错误：掼蛋需要4个玩家和2个队伍";
-        return;
-    }
-
-    // 设置玩家映射并验证玩家所属队伍
-    for (Player* player : players) {
-        if (!player) continue;
-        if (!player->getTeam()) {
-            qDebug() << "错误：玩家" << player->getName() << "没有所属队伍";
-            return;
-        }
-        m_players[player->getID()] = player;
-    }
+    // 清理之前的数据，旧游戏中尚未触发的延时回调作废
+    ++m_gameSerial;
+    stopTurnTimer();
+    clearAiCache();
+    m_pendingEvents.clear();
+    m_eventsPaused = false;
+    m_turnOpen = false;
 
-    // 设置队伍映射并验证每个队伍的玩家数量
-    for (Team* team : teams) {
-        if (!team) continue;
-        if (team->getPlayers().size() != 2) {
-            qDebug() << "错误：每个队伍必须有2个玩家";
-            return;
-        }
-        m_teams[team->getId()] = team;
-    }
-
-    // 初始化等级状态
-    m_levelStatus.initializeGameLevels(*teams[0], *teams[1]);
-
-    // 初始化队伍积分
-    for (Team* team : teams) {
-        team->setScore(0);
+    // 验证玩家和队伍(4个玩家、2个队伍，每队2人)
+    if (!m_engine.setup(players, teams)) {
+        return;
     }
+    m_engine.setCardsPerPlayer(kCardsPerPlayer);
 
-    qDebug() << "游戏设置完成，玩家数量:" << m_players.size() << "，队伍数量:" << m_teams.size();
+    qDebug() << "游戏设置完成，玩家数量:" << players.size() << "，队伍数量:" << teams.size();
 }
 
 void GD_Controller::startGame()
 {
-    if (m_players.size() != 4 || m_teams.size() != 2) {
+    if (!m_engine.team(0) || !m_engine.team(1)) {
         qDebug() << "错误：需要4个玩家和2个队伍才能开始游戏";
         return;
     }
 
-    // 只设置和游戏整体相关的状态
-    m_currentRoundNumber = 1;
-
     emit sigGameStarted();
     emit sigBroadcastMessage("掼蛋游戏开始！");
 
-    // 通过状态机启动第一轮
-    startNewRound();
+    // 级牌和积分在引擎中重置，随后进入第一局的发牌阶段
+    m_engine.startGame();
+    m_recorder.beginMatch(m_engine.seed(), kCardsPerPlayer);
+    m_pendingEvents += m_engine.takeEvents();
+    dispatchEvents();
 }
 
 // ==================== 玩家操作槽函数 ====================
@@ -118,21 +103,19 @@ void GD_Controller::onPlayerPlay(int playerId, const QVector<Card>& cardsToPlay)
         return;
     }
 
-    // 记录玩家所选的原始卡牌
-    m_SelectedOriginCards = cardsToPlay;
-
+    // 选中的牌能组成的合法牌型(处理癞子牌的情况)
+    const QVector<CardCombo::ComboInfo> possibleCombos = m_engine.playInterpretations(playerId, cardsToPlay);
     CardCombo::ComboInfo playedCombo;
-	// 返回playedCombo数组为玩家选中的牌的合法牌型
-    if (!PlayerPlay(playerId, cardsToPlay, playedCombo)) {
+    if (possibleCombos.isEmpty() || !chooseComboInterpretation(playerId, cardsToPlay, possibleCombos, playedCombo)) {
         emit sigShowPlayerMessage(playerId, "出牌不符合规则", true);
         qDebug() << "GD_Controller::onPlayerPlay: 玩家" << playerId << "出牌不符合规则 "
-            << "当前桌面牌型为" << m_currentTableCombo.type
-            << ",当前牌型等级为" << m_currentTableCombo.level;
+            << "当前桌面牌型为" << m_engine.tableCombo().type
+            << ",当前牌型等级为" << m_engine.tableCombo().level;
         return;
     }
 
     // 只执行出牌，然后转到下一位
-    executePlay(playerId, playedCombo);
+    executePlay(playerId, cardsToPlay, playedCombo);
 
     // 在出牌时播放音效
     SoundManager::instance().playCardPlaySound();
@@ -147,7 +130,7 @@ void GD_Controller::onPlayerPass(int playerId)
         return;
     }
 
-    if (m_currentTableCombo.type == CardComboType::Invalid) {
+    if (m_engine.tableCombo().type == CardComboType::Invalid) {
         emit sigShowPlayerMessage(playerId, "您是第一个出牌，不能过牌", true);
         return;
     }
@@ -163,531 +146,343 @@ void GD_Controller::onPlayerPass(int playerId)
 void GD_Controller::onPlayerRequestHint(int playerId)
 {
     qDebug() << "GD_Controller::onPlayerRequestHint: 玩家" << playerId << "请求出牌提示";
-    if (m_currentPhase != GamePhase::Playing || playerId != m_currentPlayerId) {
-        return;
-    }
-
-    Player* humanPlayer = getPlayerById(playerId);
-    if (!humanPlayer) return;
-
-    // 1. 创建一个临时的 NPCPlayer 实例
-    // 名字和ID不重要，因为我们只是借用它的算法
-    NPCPlayer tempAI("HintBot", -1);
-    
-    // 2. 把当前人类玩家的手牌和队伍传给这个临时AI
-    tempAI.setHandCards(humanPlayer->getHandCards());
-    tempAI.setTeam(humanPlayer->getTeam());
-
-    // 3. 调用NPCPlayer的方法来获取最佳出牌建议
-    QVector<Card> suggestedCards = tempAI.getBestPlay(m_currentTableCombo);
-
-    if (suggestedCards.isEmpty()) {
-        // AI也找不到牌，说明真的要不起
-        emit sigShowPlayerMessage(playerId, "没有找到可以打得过上家的牌，建议过牌。", false);
+    QString errorMsg;
+    if (!canPerformAction(playerId, errorMsg)) {
         return;
     }
 
-    // 4. 成功获取建议，发射信号让UI高亮这些牌
-    emit sigShowHint(playerId, suggestedCards);
-    emit sigBroadcastMessage(QString("已为 %1 提供出牌提示。").arg(humanPlayer->getName()));
+    // 提示在工作线程中计算，结果由onAiDecisionFinished发给界面
+    startAiDecision(playerId, AiPurpose::Hint);
 }
 
 void GD_Controller::onPlayerTributeCardSelected(int tributingPlayerId, const Card& tributeCard)
 {
-    if (m_currentTributeIndex >= m_pendingTributes.size()) {
+    const GameEngine::TributeInfo* currentTribute = m_engine.currentTribute();
+    if (!currentTribute || tributingPlayerId != currentTribute->fromPlayerId) {
         return;
     }
 
-    const TributeInfo& currentTribute = m_pendingTributes[m_currentTributeIndex];
-    if (tributingPlayerId != currentTribute.fromPlayerId) {
+    // 进贡须为最大的牌，还贡给队友须为10或以下，由引擎检查；不合规则时让玩家重新选择
+    const GameEngine::TributeInfo tribute = *currentTribute; // 推进后指针不再有效
+    QString errorMessage;
+    if (!stepEngine(GameEngine::Action::tribute(tributingPlayerId, tributeCard), &errorMessage)) {
+        emit sigShowPlayerMessage(tributingPlayerId, errorMessage, true);
         return;
     }
+    m_recorder.tribute(tribute.fromPlayerId, tribute.toPlayerId, tribute.isReturn, tributeCard);
+}
 
-    Player* fromPlayer = getPlayerById(currentTribute.fromPlayerId);
-    Player* toPlayer = getPlayerById(currentTribute.toPlayerId);
-    if (!fromPlayer || !toPlayer) {
-        return;
+// ==================== 引擎驱动 ====================
+
+bool GD_Controller::stepEngine(const GameEngine::Action& action, QString* errorMsg)
+{
+    if (!m_engine.step(action, errorMsg)) {
+        return false;
     }
+    m_pendingEvents += m_engine.takeEvents();
+    dispatchEvents();
+    return true;
+}
 
-    bool isValid = false;
-    QString errorMessage;
+void GD_Controller::dispatchEvents()
+{
+    // 事件处理中可能再次推进引擎(如发牌)，新事件追加到队列末尾，由外层循环继续处理
+    if (m_dispatchingEvents) return;
+    m_dispatchingEvents = true;
+    while (!m_pendingEvents.isEmpty() && !m_eventsPaused) {
+        const GameEngine::Event event = m_pendingEvents.takeFirst();
+        handleEvent(event);
+    }
+    m_dispatchingEvents = false;
+}
 
-    if (currentTribute.isReturn) {
-        // 还贡规则检查
-        Team* fromTeam = getTeamOfPlayer(currentTribute.fromPlayerId);
-        Team* toTeam = getTeamOfPlayer(currentTribute.toPlayerId);
-        bool isTeammate = (fromTeam == toTeam);
+void GD_Controller::handleEvent(const GameEngine::Event& event)
+{
+    using Event = GameEngine::Event;
+    Player* player = event.playerId >= 0 ? getPlayerById(event.playerId) : nullptr;
 
-        if (isTeammate && tributeCard.point() > Card::Card_10) {
-            errorMessage = "还贡给队友的牌必须是10或以下的牌！";
-        }
-        else {
-            isValid = true;
-        }
-    }
-    else {
-        // 进贡规则检查：必须是最大的牌
-        QVector<Card> handCards = fromPlayer->getHandCards();
-        bool isLargest = true;
-        for (const Card& card : handCards) {
-            if (card > tributeCard) {
-                isLargest = false;
-                break;
-            }
-        }
+    switch (event.type) {
+    case Event::RoundStarted:
+    {
+        qDebug() << "GD_Controller: 第" << event.value << "局开始，进入发牌阶段";
+        m_turnOpen = false;
+        clearAiCache(); // 上一局的选牌结果不再适用
 
-        if (!isLargest) {
-            errorMessage = "进贡必须选择手牌中最大的牌！";
-        }
-        else {
-            isValid = true;
-        }
-    }
+        // 初始化本局积分状态和记牌器
+        emit sigMultiplierUpdated(m_engine.multiplier());
+        initializeCardCounts();
 
-    if (isValid) {
-        // 执行进贡/还贡
-        TributeInfo tribute = currentTribute;
-        tribute.card = tributeCard;
-        
-        // 更改牌的所有者
-        tribute.card.setOwner(getPlayerById(toPlayer->getID()));
-        
-        // 转移牌
-        QVector<Card> cards;
-        cards.append(tribute.card);
-        fromPlayer->removeCards(cards);
-        toPlayer->addCards(cards);
-
-        // 更新UI
-        emit sigUpdatePlayerHand(tribute.fromPlayerId, fromPlayer->getHandCards());
-        emit sigUpdatePlayerHand(tribute.toPlayerId, toPlayer->getHandCards());
-
-        QString actionName = tribute.isReturn ? "还贡" : "进贡";
-        QString cardDesc = QString("%1%2").arg(tribute.card.SuitToString()).arg(tribute.card.PointToString());
-        emit sigBroadcastMessage(QString("%1 向 %2 %3：%4")
-            .arg(fromPlayer->getName())
-            .arg(toPlayer->getName())
-            .arg(actionName)
-            .arg(cardDesc));
+        emit sigNewRoundStarted(event.value);
+        Card::CardPoint team1Level = m_engine.levelStatus().getTeamPlayingLevel(0);
+        Card::CardPoint team2Level = m_engine.levelStatus().getTeamPlayingLevel(1);
+        emit sigTeamLevelsUpdated(team1Level, team2Level);
+        m_recorder.beginRound(event.value, team1Level, team2Level);
 
-        m_currentTributeIndex++;
-        processNextTributeAction();
-    }
-    else {
-        // 显示错误消息并让玩家重新选择
-        emit sigShowPlayerMessage(tributingPlayerId, errorMessage, true);
+        // 创建临时卡片用于显示文本消息
+        Card currentLevel_card;
+        currentLevel_card.setPoint(team1Level);
+        emit sigBroadcastMessage(QString("第%1局开始！当前级牌：%2").arg(event.value).arg(currentLevel_card.PointToString()));
+
+        // 发牌没有需要玩家选择的内容，直接推进
+        stepEngine(GameEngine::Action::proceed());
+        break;
     }
-}
 
-// ==================== 内部游戏流程方法 ====================
+    case Event::CardsDealt:
+        m_recorder.deal(event.playerId, event.cards);
+        emit sigCardsDealt(event.playerId, event.cards);
+        qDebug() << "发牌完成 - 玩家:" << (player ? player->getName() : QString()) << "牌数:" << event.cards.size();
+        break;
 
-void GD_Controller::startNewRound()
-{
-    qDebug() << "GD_Controller::startNewRound - 准备开始新一局，局数: " << m_currentRoundNumber;
-    
-    // 初始化本局积分状态
-    m_roundBaseScore = 1;  // 设置基础分为1
-    m_roundDynamicMultiplier = 1;  // 重置动态倍率为1
-    emit sigMultiplierUpdated(m_roundBaseScore * m_roundDynamicMultiplier);
-    
-    // 初始化记牌器数据
-    initializeCardCounts();
-    
-    // 唯一的职责：启动发牌状态
-    enterState(GamePhase::Dealing);
-}
+    case Event::TributeRequired:
+        emit sigBroadcastMessage(event.flag ? "双下！需要进贡" : "单下！需要进贡");
+        break;
 
-void GD_Controller::dealCardsToPlayers()
-{
-    qDebug() << "GD_Controller::dealCardsToPlayers - 开始发牌";
-
-    // 创建牌组并自动初始化（deck构造函数中会创建两副牌并洗牌）
-    CardDeck deck;
-    QVector<Card> allCards = deck.getDeckCards(); // 得到乱序的牌组（注意，是无所有者的牌组！）
-
-    // 检查牌组大小是否足够
-    const int cardsPerPlayer = 4; // 测试
-    //const int cardsPerPlayer = 27;
-    const int totalPlayers = 4;
-    if (allCards.size() < cardsPerPlayer * totalPlayers) {
-        qWarning() << "错误：牌组大小不足，无法发牌";
-        return;
-    }
+    case Event::TributeResisted:
+        emit sigBroadcastMessage("抗贡成功！");
+        break;
 
-    // 直接从m_players获取所有玩家ID
-    QVector<int> playerIds = m_players.keys().toVector();
-    std::sort(playerIds.begin(), playerIds.end()); // 确保ID按顺序排列
+    case Event::TributeRequested:
+        onTributeRequested(event.playerId, event.targetId, event.flag);
+        break;
 
-    // 给四个玩家发牌
-    for (int i = 0; i < playerIds.size() && i < totalPlayers; ++i) {
-        QVector<Card> playerCards; // 添加到每个玩家的手牌数组
-        for (int j = 0; j < cardsPerPlayer; ++j) {
-            playerCards.append(allCards[i * cardsPerPlayer + j]);
-        }
-        
-        // 获取玩家对象
-        Player* player = getPlayerById(playerIds[i]);
+    case Event::TributeGiven:
+    {
+        Player* toPlayer = getPlayerById(event.targetId);
+        // 更新UI(只传递变化的那张牌)
+        emit sigPlayerHandChanged(event.playerId, QVector<Card>(), event.cards);
+        emit sigPlayerHandChanged(event.targetId, event.cards, QVector<Card>());
 
-        // 给playerCards找主人
-        for (Card& card : playerCards) {
-            card.setOwner(player); // 设置牌的所有者ID
-        }
-        
-        // 如果玩家存在，则清空原有手牌并添加新牌
-        if (player) {
-            player->clearHandCards();  // 使用专门的清空方法，确保完全清空
-            player->addCards(playerCards);
-            emit sigCardsDealt(playerIds[i], playerCards); // 发送发牌完成信号
-            qDebug() << "发牌完成 - 玩家:" << player->getName() << "牌数:" << playerCards.size();
-        }
-        else {
-            qDebug() << "错误：玩家ID" << playerIds[i] << "不存在，无法发牌";
-        }
+        const Card& card = event.cards.first();
+        emit sigBroadcastMessage(QString("%1 向 %2 %3：%4")
+            .arg(player ? player->getName() : QString())
+            .arg(toPlayer ? toPlayer->getName() : QString())
+            .arg(event.flag ? "还贡" : "进贡")
+            .arg(QString("%1%2").arg(card.SuitToString()).arg(card.PointToString())));
+        break;
     }
-}
 
-void GD_Controller::determineFirstPlayerForRound()
-{
-    qDebug() << "GD_Controller::determineFirstPlayerForRound() - 开始确定首个出牌玩家";
-    qDebug() << "当前局数:" << m_currentRoundNumber;
-    qDebug() << "上局排名数量:" << m_lastRoundFinishOrder.size();
-
-    // 第一局：随机选择一名玩家先出
-    if (m_currentRoundNumber == 1) {
-        // 获取所有玩家ID
-        QVector<int> playerIds = m_players.keys().toVector();
-        if (playerIds.isEmpty()) {
-            qWarning() << "错误：没有可用的玩家";
-            m_currentPlayerId = 0;
-        } else {
-            // 使用 QRandomGenerator 随机选择一名玩家
-            int randomIndex = QRandomGenerator::global()->bounded(playerIds.size());
-            m_currentPlayerId = playerIds[randomIndex];
-            
-            qDebug() << "第一局随机选择玩家ID:" << m_currentPlayerId << "作为首个出牌玩家";
-        }
-        
-        m_circleLeaderId = m_currentPlayerId;
-        return;
+    case Event::TributeEnded:
+        emit sigTributePhaseEnded();
+        break;
+
+    case Event::TurnStarted:
+        onTurnStarted(event.playerId, event.flag);
+        break;
+
+    case Event::Played:
+        // 通知UI移除手牌、更新记牌器并显示出牌
+        emit sigPlayerHandChanged(event.playerId, QVector<Card>(), event.cards);
+        updateCardCounts(event.cards);
+        emit sigUpdateTableCards(event.playerId, event.combo, event.cards);
+        emit sigBroadcastMessage(QString("%1 出牌：%2").arg(player ? player->getName() : QString()).arg(event.combo.getDescription()));
+        break;
+
+    case Event::Passed:
+        emit sigBroadcastMessage(QString("%1 选择过牌").arg(player ? player->getName() : QString()));
+        emit sigPlayerPassed(event.playerId);
+        break;
+
+    case Event::MultiplierChanged:
+        emit sigMultiplierUpdated(event.value);
+        break;
+
+    case Event::PlayerFinished:
+        emit sigBroadcastMessage(QString("%1 出完了所有牌，获得第%2名！")
+            .arg(player ? player->getName() : QString())
+            .arg(event.value));
+        break;
+
+    case Event::CircleEnded:
+    {
+        qDebug() << "GD_Controller: 圈结束，下一圈由" << event.playerId << "领出";
+        // 引擎已经开始新的一圈；界面停顿一下再清空桌面、轮到领出者，期间先为领出预先思考
+        ponderTurn(m_engine.currentPlayerId(), m_engine.tableCombo(), m_engine.tableOwnerId());
+        m_eventsPaused = true;
+        const int serial = m_gameSerial;
+        const int leaderId = event.playerId;
+        QTimer::singleShot(kCircleEndPauseMs, this, [this, serial, leaderId]() {
+            if (serial != m_gameSerial) return;
+            m_eventsPaused = false;
+            emit sigClearTableCards();
+            if (Player* leader = getPlayerById(leaderId)) {
+                emit sigBroadcastMessage(QString("新的一圈开始，由 %1 出牌。").arg(leader->getName()));
+            }
+            m_newCircleAnnounced = true;
+            dispatchEvents();
+        });
+        break;
     }
 
-    // 非第一局：使用上一局最后一名作为首出玩家
-    if (!m_lastRoundFinishOrder.isEmpty()) {
-        m_currentPlayerId = m_lastRoundFinishOrder.last();
-        m_circleLeaderId = m_currentPlayerId;
-        qDebug() << "非第一局，选择上一局最后一名玩家ID:" << m_currentPlayerId << "作为首个出牌玩家";
-    } else {
-        // 如果没有上一局排名信息，使用默认玩家
-        qWarning() << "错误：非第一局但没有上一局的排名信息，使用默认玩家0";
-        m_currentPlayerId = 0;
-        m_circleLeaderId = m_currentPlayerId;
+    case Event::RoundEnded:
+    {
+        qDebug() << "GD_Controller: 本局结束，名次" << m_engine.roundFinishOrder();
+        m_turnOpen = false;
+        stopTurnTimer();
+        clearAiCache();
+        // 结算放到下一个事件循环中进行
+        const int serial = m_gameSerial;
+        QTimer::singleShot(0, this, [this, serial]() {
+            if (serial != m_gameSerial) return;
+            stepEngine(GameEngine::Action::proceed());
+        });
+        break;
     }
-}
 
-// 清空当前桌面牌型和过牌玩家列表，并发送清空桌面牌型的信号
-void GD_Controller::resetTableCombo()
-{
-    m_currentTableCombo.type = CardComboType::Invalid;
-    m_currentTableCombo.cards_in_combo.clear();
-}
+    case Event::LevelsUpdated:
+        emit sigTeamLevelsUpdated(m_engine.levelStatus().getTeamPlayingLevel(0), m_engine.levelStatus().getTeamPlayingLevel(1));
+        break;
 
-// 判断玩家是否可以出牌，如果可以出牌的话处理为具体牌型，并返回出牌的牌型信息 (WildCardDialog的调用！)
-bool GD_Controller::PlayerPlay(int playerId, const QVector<Card>& cardsToPlay, CardCombo::ComboInfo& outPlayedCombo)
-{
-    Player* player = getPlayerById(playerId);
+    case Event::ScoresUpdated:
+        emit sigScoresUpdated(m_engine.team(0)->getScore(), m_engine.team(1)->getScore());
+        break;
 
-    // 验证玩家是否拥有这些牌
-    for (const Card& card : cardsToPlay) {
-        if (!player->getHandCards().contains(card)) {
-			qDebug() << "玩家" << player->getName() << "没有手牌" << card.PointToString();
-            return false;
-        }
-    }
+    case Event::RoundSettled:
+        m_recorder.endRound(event.order);
+        emit sigRoundOver(generateRoundSummary(event.value, event.order), event.order);
+        break;
 
-    // 获取当前级牌
-    Card::CardPoint currentLevel = m_levelStatus.getTeamPlayingLevel(getTeamOfPlayer(playerId)->getId());
-    // 使用Player的canPlayCards方法验证牌型
-    if (player->canPlayCards(cardsToPlay, m_currentTableCombo)) {
-
-		// 可以出牌，则outPlayedCombo数组为玩家选中的牌的合法牌型 (处理癞子牌的情况)
-        QVector<CardCombo::ComboInfo> possibleCombos = CardCombo::getAllPossibleValidPlays(
-            cardsToPlay,           // 玩家选择要打出的这些牌
-            player,
-            m_currentTableCombo.type,
-            m_currentTableCombo.level);
-
-		// 如果只有一个可能的组合，则直接使用它
-        if (possibleCombos.size() == 1) 
-        {
-			outPlayedCombo = possibleCombos[0];
-            return true;
-        }
+    case Event::GameOver:
+    {
+        qDebug() << "GD_Controller: 游戏结束";
+        clearAiCache();
+        const int winnerTeamId = event.value;
+        m_recorder.endMatch(winnerTeamId);
+        QString finalMessage = QString("恭喜%1队获得最终胜利！").arg(winnerTeamId + 1);
+        emit sigGameOver(winnerTeamId, QString("队伍%1").arg(winnerTeamId + 1), finalMessage);
+        break;
+    }
+    }
+}
 
-		// 如果有多个可能的组合，则需要WildCardDialog处理
-		if (possibleCombos.size() > 1)
-		{
-            // 多种可能组合处理：AI直接取第一，玩家仅在包含癞子时弹窗，否则也取第一
-            if (player->getType() == Player::AI) {
-                outPlayedCombo = possibleCombos.first();
-                return true;
-            }
-            bool hasWild = false;
-            for (const Card& card : cardsToPlay) {
-                if (card.isWildCard()) { hasWild = true; break; }
-            }
-            if (!hasWild) {
-                outPlayedCombo = possibleCombos.first();
-                return true;
-            }
-            // 包含癞子，弹框让玩家选择具体牌型
-            qDebug() << "GD_Controller::PlayerPlay：WildCardDialog被调用";
-            WildCardDialog dialog(possibleCombos, nullptr);
-            if (dialog.exec() == QDialog::Accepted && dialog.hasValidSelection()) {
-                outPlayedCombo = dialog.getSelectedCombo();
-                return true;
-            }
-            return false;
-		}
+void GD_Controller::onTurnStarted(int playerId, bool canPass)
+{
+    Player* player = getPlayerById(playerId);
+    if (!player) return;
+
+    // 设置当前玩家并启用其控制(新的一圈开始时不能过牌)
+    m_turnOpen = true;
+    emit sigSetCurrentTurnPlayer(playerId, player->getName());
+    emit sigEnablePlayerControls(playerId, true, canPass);
+    if (!m_newCircleAnnounced) {
+        emit sigBroadcastMessage(QString("轮到 %1 出牌！").arg(player->getName()));
+    }
+    m_newCircleAnnounced = false;
+
+    // 启动计时器，并为这一回合预先思考
+    startTurnTimer();
+    ponderTurn(playerId, m_engine.tableCombo(), m_engine.tableOwnerId());
+
+    // 如果是AI玩家，稍后请求选牌(仍是该玩家的回合时才会提交)
+    if (player->getType() == Player::AI) {
+        const int serial = m_gameSerial;
+        QTimer::singleShot(kAiTurnDelayMs, this, [this, serial, playerId]() {
+            if (serial != m_gameSerial) return;
+            requestAiPlay(playerId);
+        });
     }
-    // 不能出牌，返回false
-    else
-    {
-        qDebug() << "当前场上牌型为 " << m_currentTableCombo.type << " ，当前牌型等级为 " << m_currentTableCombo.level;
-        qDebug() << "GD_Controller::PlayerPlay： 玩家" << player->getName() << "选择的牌不符合出牌规则";
-        return false;
-	}
-	qDebug() << "GD_Controller::PlayerPlay： 错误错误错误！！！";
-    return false;
 }
 
-// 玩家选择手牌后出牌处理函数
-void GD_Controller::processPlayerPlay(int playerId, const CardCombo::ComboInfo& playedCombo)
+void GD_Controller::onTributeRequested(int fromPlayerId, int toPlayerId, bool isReturn)
 {
-    // 如果出牌不合法
-    if (playedCombo.type == CardComboType::Invalid) {
+    Player* fromPlayer = getPlayerById(fromPlayerId);
+    Player* toPlayer = getPlayerById(toPlayerId);
+    if (!fromPlayer || !toPlayer) {
+        qWarning() << "错误：找不到进贡相关的玩家";
         return;
     }
-    // 从玩家手牌中移除玩家选中的原始卡牌
-    Player* player = getPlayerById(playerId);
-    player->removeCards(m_SelectedOriginCards);
-    
-    // 更新记牌器数据
-    updateCardCounts(m_SelectedOriginCards);
-    
-    m_SelectedOriginCards.clear();
-
-    // 更新桌面牌型
-    m_currentTableCombo = playedCombo;
-    m_circleLeaderId = playerId;
-    m_passedPlayersInCircle.clear(); // 清空本圈已过牌的玩家
 
-    // 通知UI更新
-    emit sigUpdatePlayerHand(playerId, player->getHandCards());
-    emit sigUpdateTableCards(playerId, playedCombo, m_SelectedOriginCards);
-
-    // 检查是否需要更新倍率
-    if (playedCombo.type == CardComboType::Bomb) {
-        m_roundDynamicMultiplier *= 2;
-        emit sigMultiplierUpdated(m_roundBaseScore * m_roundDynamicMultiplier);
+    emit sigEnablePlayerControls(fromPlayerId, true, false);
+    if (!isReturn) {
+        emit sigBroadcastMessage(QString("请%1选择最大的牌进贡").arg(fromPlayer->getName()));
+    }
+    else if (getTeamOfPlayer(fromPlayerId) == getTeamOfPlayer(toPlayerId)) {
+        emit sigBroadcastMessage(QString("请%1选择一张10或以下的牌还贡给队友%2")
+            .arg(fromPlayer->getName())
+            .arg(toPlayer->getName()));
+    }
+    else {
+        emit sigBroadcastMessage(QString("请%1选择一张牌还贡给%2")
+            .arg(fromPlayer->getName())
+            .arg(toPlayer->getName()));
     }
 
-    QString message = QString("%1 出牌：%2")
-        .arg(player->getName())
-        .arg(playedCombo.getDescription());
-    emit sigBroadcastMessage(message);
-}
-
-// 玩家选择过牌处理函数
-void GD_Controller::processPlayerPass(int playerId)
-{
-	// 在过牌玩家列表中添加玩家ID
-    Player* player = getPlayerById(playerId);
-    if (!player) {
-		qDebug() << "GD_Controller::processPlayerPass: Player with ID" << playerId << "not found!";
+    // AI自动选择
+    if (fromPlayer->getType() == Player::AI) {
+        if (!fromPlayer->getHandSet().isEmpty()) {
+            // 还贡出最小的牌，进贡出最大的牌
+            Card cardToTribute = isReturn ? fromPlayer->getSmallestCard() : fromPlayer->getLargestCard();
+            const int serial = m_gameSerial;
+            QTimer::singleShot(kAiTributeDelayMs, this, [this, serial, fromPlayerId, cardToTribute]() {
+                if (serial != m_gameSerial) return;
+                onPlayerTributeCardSelected(fromPlayerId, cardToTribute);
+            });
+        }
         return;
     }
 
-    m_passedPlayersInCircle.insert(playerId);
+    // 人类玩家：发出信号请求UI交互
+    emit sigAskForTribute(fromPlayerId, fromPlayer->getName(), toPlayerId, toPlayer->getName(), isReturn);
 
-    QString message = QString("%1 选择不出").arg(player->getName());
+    // 发送提示消息
+    QString actionName = isReturn ? "还贡" : "进贡";
+    QString message = QString("请%1选择一张牌%2给%3")
+        .arg(fromPlayer->getName())
+        .arg(actionName)
+        .arg(toPlayer->getName());
     emit sigBroadcastMessage(message);
 }
 
-// 当玩家出完牌时判定
-bool GD_Controller::handleRoundEnd()
+// 多种牌型解释时的选择 (WildCardDialog的调用！)
+bool GD_Controller::chooseComboInterpretation(int playerId, const QVector<Card>& cards,
+    const QVector<CardCombo::ComboInfo>& combos, CardCombo::ComboInfo& chosen)
 {
-    qDebug() << "GD_Controller::handleRoundEnd： 开始判断";
-    
-    // 先更新已完成出牌的玩家
-    updateFinishedPlayers();
-    
-    // 检查是否只剩最后一名玩家
-    if (isLastPlayerStanding()) {
-        qDebug() << "GD_Controller::handleRoundEnd： 仅剩一名玩家";
-        
-        // 立刻改变游戏阶段，阻止任何新的出牌/过牌操作
-        // m_currentPhase = GamePhase::RoundOver;
-        
-        // 将最后一名玩家添加到完成顺序中
-        appendLastPlayer();
-        
-        qDebug() << "GD_Controller::handleRoundEnd： 回合确认结束，将调度处理结果";
-        
-        // 使用QTimer::singleShot来调度processRoundResults，确保它在下一个事件循环中执行
-        // QTimer::singleShot(0, this, &GD_Controller::processRoundResults);
-        enterState(GamePhase::RoundOver);
-        
+    chosen = combos.first();
+    if (combos.size() == 1) return true;
+
+    // 多种可能组合处理：AI直接取第一，玩家仅在包含癞子时弹窗，否则也取第一
+    Player* player = getPlayerById(playerId);
+    if (!player || player->getType() == Player::AI) return true;
+    const LevelContext levelCtx = player->getLevelContext();
+    bool hasWild = std::any_of(cards.begin(), cards.end(), [&levelCtx](const Card& card) {
+        return levelCtx.isWildCard(card);
+    });
+    if (!hasWild) return true;
+
+    // 包含癞子，弹框让玩家选择具体牌型
+    qDebug() << "GD_Controller::chooseComboInterpretation：WildCardDialog被调用";
+    WildCardDialog dialog(combos, nullptr);
+    if (dialog.exec() == QDialog::Accepted && dialog.hasValidSelection()) {
+        chosen = dialog.getSelectedCombo();
         return true;
     }
-    
-    qDebug() << "GD_Controller::handleRoundEnd： 回合未结束";
     return false;
 }
 
-void GD_Controller::processRoundResults()
-{
-    try {
-        qDebug() << "processRoundResults - 开始处理回合结果";
-        qDebug() << "当前回合玩家完成顺序:" << m_roundFinishOrder;
-        
-        if (m_roundFinishOrder.size() != 4) {
-            qDebug() << "错误：回合结束时玩家完成顺序数量不正确:" << m_roundFinishOrder.size();
-            return;
-        }
-
-        // 找到获胜队伍和失败队伍
-        Team* winningTeam = nullptr;
-        Team* losingTeam = nullptr;
-        int levelIncrement = 0;
-
-        // 根据完成顺序确定获胜队伍
-        if (!m_roundFinishOrder.isEmpty()) {
-            int firstFinisherId = m_roundFinishOrder.first();
-            winningTeam = getTeamOfPlayer(firstFinisherId);
-            
-            // 找到失败队伍
-            for (const auto& team : m_teams) {
-                if (team != winningTeam) {
-                    losingTeam = team;
-                    break;
-                }
-            }
-
-            // 计算升级级数
-            Card::CardPoint oldLevel = winningTeam->getCurrentLevelRank();
-            
-            // 先记录旧的级别
-            Card::CardPoint oldLevelFromStatus = m_levelStatus.getTeamPlayingLevel(winningTeam->getId());
-            
-            // 更新级别
-            // 将一基于1的名次转换为0基索引再传入升级逻辑
-            int partnerIndex = -1;
-            for (int i = 1; i < m_roundFinishOrder.size(); ++i) {
-                Player* player = getPlayerById(m_roundFinishOrder[i]);
-                if (player && player->getTeam() == winningTeam) {
-                    partnerIndex = i;
-                    break;
-                }
-            }
-            
-            if (partnerIndex != -1) {
-                m_levelStatus.updateLevelsAfterRound(winningTeam->getId(), partnerIndex,
-                    *m_teams[0], *m_teams[1]);
-                    
-                // 获取新的级别
-                Card::CardPoint newLevelFromStatus = m_levelStatus.getTeamPlayingLevel(winningTeam->getId());
-                
-                // 发送级牌更新信号
-                emit sigTeamLevelsUpdated(m_levelStatus.getTeamPlayingLevel(0), m_levelStatus.getTeamPlayingLevel(1));
-                
-                // 计算升级了几级
-                levelIncrement = static_cast<int>(newLevelFromStatus) - static_cast<int>(oldLevelFromStatus);
-
-                // 计算并更新积分
-                if (levelIncrement > 0) {
-                    int scoreChange = levelIncrement * m_roundBaseScore * m_roundDynamicMultiplier;
-                    winningTeam->addScore(scoreChange);
-                    
-                    // 发出积分更新信号
-                    emit sigScoresUpdated(m_teams[0]->getScore(), m_teams[1]->getScore());
-                }
-            }
-        }
-
-        // 生成本局总结
-        QString summary = generateRoundSummary();
-        
-        // 保存本局的排名顺序，用于下一局的进贡判断（在发送信号前保存）
-        m_lastRoundFinishOrder = m_roundFinishOrder;
-        qDebug() << "已保存本局排名顺序:" << m_lastRoundFinishOrder;
-        
-        try {
-            // 发送回合结束信号
-            emit sigRoundOver(summary, m_roundFinishOrder);
-        }
-        catch (...) {
-            qDebug() << "警告：发送回合结束信号时发生异常，但将继续处理";
-        }
-
-        // 检查游戏是否结束
-        if (m_levelStatus.isGameOver()) {
-            enterState(GamePhase::GameOver);
-        }
-        else {
-            // 准备开始新的一局
-            m_currentRoundNumber++;
-            qDebug() << "开始新的一局，局数更新为:" << m_currentRoundNumber;
-            
-            // 开始新一局前清空本局出牌顺序（注意：m_lastRoundFinishOrder已经保存了上局顺序）
-            m_roundFinishOrder.clear();
-            qDebug() << "已清空当前局出牌顺序，准备开始新一局";
-            
-            // 开始新一局
-            startNewRound();
-        }
-    }
-    catch (const std::exception& e) {
-        qDebug() << "processRoundResults发生异常:" << e.what();
-        // 确保状态正确更新，即使发生异常
-        m_lastRoundFinishOrder = m_roundFinishOrder;  // 保存本局排名
-        m_roundFinishOrder.clear();                   // 清空当前局排名
-        m_currentRoundNumber++;                       // 更新局数
-        startNewRound();                              // 开始新一局
-    }
-    catch (...) {
-        qDebug() << "processRoundResults发生未知异常";
-        // 确保状态正确更新，即使发生异常
-        m_lastRoundFinishOrder = m_roundFinishOrder;  // 保存本局排名
-        m_roundFinishOrder.clear();                   // 清空当前局排名
-        m_currentRoundNumber++;                       // 更新局数
-        startNewRound();                              // 开始新一局
-    }
-}
-
 // 生成一局总结
-QString GD_Controller::generateRoundSummary() const
+QString GD_Controller::generateRoundSummary(int roundNumber, const QVector<int>& finishOrder) const
 {
     QString summary;
     QTextStream stream(&summary);
 
-    stream << QString("第%1局结束！\n").arg(m_currentRoundNumber);
+    stream << QString("第%1局结束！\n").arg(roundNumber);
     stream << "最终排名：\n";
 
-    for (int i = 0; i < m_roundFinishOrder.size(); ++i) {
-        Player* player = getPlayerById(m_roundFinishOrder[i]);
+    for (int i = 0; i < finishOrder.size(); ++i) {
+        Player* player = getPlayerById(finishOrder[i]);
         if (player) {
             stream << QString("第%1名：%2\n").arg(i + 1).arg(player->getName());
         }
     }
 
     // 添加级牌变化信息
-    for (auto it = m_teams.begin(); it != m_teams.end(); ++it) {
-        Team* team = it.value();
+    for (int teamId = 0; teamId < 2; ++teamId) {
+        Team* team = m_engine.team(teamId);
         if (team) { // 进行空指针检查
             Card levelCard;
             levelCard.setPoint(team->getCurrentLevelRank());
             stream << QString("队伍%1当前级牌：%2\n")
-                .arg(it.key() + 1)
+                .arg(teamId + 1)
                 .arg(levelCard.PointToString());
         }
     }
@@ -695,648 +490,80 @@ QString GD_Controller::generateRoundSummary() const
     return summary;
 }
 
-void GD_Controller::startTributePhaseLogic()
-{
-    m_pendingTributes.clear();
-    m_currentTributeIndex = 0;
-
-    // 根据上局排名确定进贡情况
-    if (m_lastRoundFinishOrder.size() < 4) {
-        // 异常情况，直接进入游戏阶段
-        enterState(GamePhase::Playing);
-        return;
-    }
-
-    int firstPlayerId = m_lastRoundFinishOrder[0];   // 头游
-    int secondPlayerId = m_lastRoundFinishOrder[1];  // 二游  
-    int thirdPlayerId = m_lastRoundFinishOrder[2];   // 三游
-    int fourthPlayerId = m_lastRoundFinishOrder[3];  // 末游
-
-    Team* firstTeam = getTeamOfPlayer(firstPlayerId);
-    Team* fourthTeam = getTeamOfPlayer(fourthPlayerId);
-    Team* thirdTeam = getTeamOfPlayer(thirdPlayerId);
-
-    bool isDoubleDown = (thirdTeam == fourthTeam); // 双下：三游四游同队
-
-    // 检查抗贡条件
-    Player* fourthPlayer = getPlayerById(fourthPlayerId);
-    Player* thirdPlayer = getPlayerById(thirdPlayerId);
-
-    bool canResistTribute = false;
-
-    if (isDoubleDown) {
-        // 双下情况：两人各有一张大王或其中一人有两张大王
-        int BigJokerInThird = 0;
-        int BigJokerInFourth = 0;
-
-        for (const Card& card : thirdPlayer->getHandCards()) {
-            if (card.point() == Card::Card_BJ) BigJokerInThird++;
-        }
-        for (const Card& card : fourthPlayer->getHandCards()) {
-            if (card.point() == Card::Card_BJ) BigJokerInFourth++;
-        }
-
-        canResistTribute = (BigJokerInThird >= 1 && BigJokerInFourth >= 1) ||
-            (BigJokerInThird >= 2) || (BigJokerInFourth >= 2);
-    }
-    else {
-        // 单下情况：末游有两张大王
-        int BigJokers = 0;
-        for (const Card& card : fourthPlayer->getHandCards()) {
-            if (card.point() == Card::Card_BJ) BigJokers++;
-        }
-        canResistTribute = (BigJokers >= 2);
-    }
-
-    if (canResistTribute) {
-        // 抗贡成功，头游先出牌
-        emit sigBroadcastMessage("抗贡成功！");
-        m_currentPlayerId = firstPlayerId;
-        enterState(GamePhase::Playing);
-        emit sigSetCurrentTurnPlayer(m_currentPlayerId, getPlayerById(m_currentPlayerId)->getName());
-        emit sigEnablePlayerControls(m_currentPlayerId, true, false);
-        return;
-    }
-
-    // 需要进贡
-    if (isDoubleDown) {
-        // 双下：两人都要进贡
-        TributeInfo tribute1;
-        tribute1.fromPlayerId = thirdPlayerId;
-        tribute1.toPlayerId = firstPlayerId;
-        tribute1.isReturn = false;
-        m_pendingTributes.append(tribute1);
-
-        TributeInfo tribute2;
-        tribute2.fromPlayerId = fourthPlayerId;
-        tribute2.toPlayerId = secondPlayerId;
-        tribute2.isReturn = false;
-        m_pendingTributes.append(tribute2);
-
-        // 还贡
-        TributeInfo return1;
-        return1.fromPlayerId = firstPlayerId;
-        return1.toPlayerId = thirdPlayerId;
-        return1.isReturn = true;
-        m_pendingTributes.append(return1);
-
-        TributeInfo return2;
-        return2.fromPlayerId = secondPlayerId;
-        return2.toPlayerId = fourthPlayerId;
-        return2.isReturn = true;
-        m_pendingTributes.append(return2);
-
-        emit sigBroadcastMessage("双下！需要进贡");
-    }
-    else {
-        // 单下：末游向头游进贡
-        TributeInfo tribute;
-        tribute.fromPlayerId = fourthPlayerId;
-        tribute.toPlayerId = firstPlayerId;
-        tribute.isReturn = false;
-        m_pendingTributes.append(tribute);
-
-        // 还贡
-        TributeInfo returnTribute;
-        returnTribute.fromPlayerId = firstPlayerId;
-        returnTribute.toPlayerId = fourthPlayerId;
-        returnTribute.isReturn = true;
-        m_pendingTributes.append(returnTribute);
-
-        emit sigBroadcastMessage("单下！需要进贡");
-    }
-
-    processNextTributeAction();
-}
-
-void GD_Controller::processNextTributeAction()
-{
-    if (m_currentTributeIndex >= m_pendingTributes.size()) {
-        // 所有进贡/还贡完成
-        emit sigTributePhaseEnded();
-
-        // 确定首出玩家
-        // 默认情况下，都由上一局的头游先出牌
-        if (!m_lastRoundFinishOrder.isEmpty()) {
-            m_currentPlayerId = m_lastRoundFinishOrder.first();
-            qDebug() << "进贡阶段结束，确定首出玩家为上一局的头游: " << m_currentPlayerId;
-        }
-        else {
-            m_currentPlayerId = 0; // 备用逻辑
-            qWarning() << "无法获取上局排名，默认玩家0先出";
-        }
-
-        // 特殊情况：双下时，由头游的对家（即上一局的二游）先出牌
-        Player* thirdPlayer = getPlayerById(m_lastRoundFinishOrder[2]);
-        Player* fourthPlayer = getPlayerById(m_lastRoundFinishOrder[3]);
-        if (thirdPlayer && fourthPlayer && thirdPlayer->getTeam() == fourthPlayer->getTeam()) {
-            m_currentPlayerId = m_lastRoundFinishOrder[1];
-            qDebug() << "检测到双下，首出玩家变更为头游的对家（二游）: " << m_currentPlayerId;
-        }
-
-        m_circleLeaderId = m_currentPlayerId;
-
-        // 通过状态机进入出牌阶段
-        enterState(GamePhase::Playing);
-        return;
-    }
-
-    const TributeInfo& currentTribute = m_pendingTributes[m_currentTributeIndex];
-    Player* fromPlayer = getPlayerById(currentTribute.fromPlayerId);
-    Player* toPlayer = getPlayerById(currentTribute.toPlayerId);
-
-    if (!fromPlayer || !toPlayer) {
-        qWarning() << "错误：找不到进贡相关的玩家";
-        m_currentTributeIndex++;
-        processNextTributeAction();
-        return;
-    }
-
-    // 进入对应的进贡状态
-    if (currentTribute.isReturn) {
-        // 还贡阶段
-        enterState(GamePhase::TributeProcess);
-    } else {
-        // 进贡阶段
-        enterState(GamePhase::TributeInput);
-    }
-
-    // AI自动选择
-    if (fromPlayer->getType() == Player::AI) {
-        QVector<Card> hand = fromPlayer->getHandCards();
-        std::sort(hand.begin(), hand.end());
-        if (!hand.isEmpty()) {
-            Card cardToTribute = currentTribute.isReturn ? hand.first() : hand.last();
-            int fid = currentTribute.fromPlayerId;
-            QTimer::singleShot(1000, [this, fid, cardToTribute]() {
-                this->onPlayerTributeCardSelected(fid, cardToTribute);
-            });
-        }
-        return;
-    }
-
-    // 人类玩家：发出信号请求UI交互
-    emit sigAskForTribute(currentTribute.fromPlayerId, fromPlayer->getName(),
-                         currentTribute.toPlayerId, toPlayer->getName(),
-                         currentTribute.isReturn);
-
-    // 发送提示消息
-    QString actionName = currentTribute.isReturn ? "还贡" : "进贡";
-    QString message = QString("请%1选择一张牌%2给%3")
-        .arg(fromPlayer->getName())
-        .arg(actionName)
-        .arg(toPlayer->getName());
-    emit sigBroadcastMessage(message);
-}
-
 // ==================== 辅助方法 ====================
 
 Player* GD_Controller::getPlayerById(int id) const
 {
-    // 通过QMap的映射关系查找
-    auto it = m_players.find(id);
-    if (it != m_players.end()) {
-        return it.value();
-    }
-	// 如果没找到，则返回nullptr并输出
-    else {
-        qDebug() << "GD_Controller::getPlayerById: Player with ID " << id << " not found!";
-        return nullptr;
-    }
-}
-Team* GD_Controller::getTeamOfPlayer(int playerId) const
-{
-    Player* player = getPlayerById(playerId);
+    Player* player = m_engine.player(id);
     if (!player) {
-        return nullptr;
+        qDebug() << "GD_Controller::getPlayerById: Player with ID " << id << " not found!";
     }
-
-    int teamId = player->getTeam()->getId();
-    auto it = m_teams.find(teamId);
-    return (it != m_teams.end()) ? it.value() : nullptr;
+    return player;
 }
 
-bool GD_Controller::isPlayerInGame(int playerId) const
+int GD_Controller::getHandCardCount(int playerId) const
 {
-    return !m_roundFinishOrder.contains(playerId);
+    return m_engine.handCardCount(playerId);
 }
 
-QVector<int> GD_Controller::getActivePlayerIdsSorted() const
+Team* GD_Controller::getTeamOfPlayer(int playerId) const
 {
-    QVector<int> allIds;
-    for (auto it = m_players.begin(); it != m_players.end(); ++it) {
-        allIds.append(it.key());
-    }
-
-    // 按座位顺序排序
-    std::sort(allIds.begin(), allIds.end());
-
-    // 只返回还在没出完牌的玩家
-    QVector<int> activeIds;
-    for (int id : allIds) {
-        if (isPlayerInGame(id)) {
-            activeIds.append(id);
-        }
-    }
-    return activeIds;
-}
-
-bool GD_Controller::allOtherActivePlayersPassed(int currentPlayerId) const
-{
-    QVector<int> activeIds = getActivePlayerIdsSorted();
-
-    for (int playerId : activeIds) {
-        // 如果除了当前玩家之外的玩家还有未跳过的，返回false
-        if (playerId != currentPlayerId && !m_passedPlayersInCircle.contains(playerId)) {
-            return false;
-        }
-    }
-    return true;
+    return m_engine.teamOfPlayer(playerId);
 }
 
 bool GD_Controller::canPerformAction(int playerId, QString& errorMsg)
 {
-    if (m_currentPhase != GamePhase::Playing) {
+    if (m_engine.phase() != GameEngine::Phase::Playing) {
         errorMsg = "当前不是出牌阶段";
         qDebug() << "Action failed for player" << playerId
-            << ". Reason: Invalid Phase. Current:" << static_cast<int>(m_currentPhase)
-            << ", Expected: Playing (" << static_cast<int>(GamePhase::Playing) << ")";
+            << ". Reason: Invalid Phase. Current:" << static_cast<int>(m_engine.phase());
         return false;
     }
-    if (playerId != m_currentPlayerId) {
+    // 新一圈开始前的停顿中，引擎已轮到领出者，但界面还没有启用他的操作
+    if (playerId != m_engine.currentPlayerId() || !m_turnOpen) {
         errorMsg = "还没轮到您操作";
         qDebug() << "Action failed for player" << playerId
-            << ". Reason: Not current player. Current turn:" << m_currentPlayerId;
+            << ". Reason: Not current player. Current turn:" << m_engine.currentPlayerId();
         return false;
     }
     return true;
 }
 
-void GD_Controller::executePlay(int playerId, const CardCombo::ComboInfo& playedCombo)
+void GD_Controller::executePlay(int playerId, const QVector<Card>& cards, const CardCombo::ComboInfo& playedCombo)
 {
     stopTurnTimer(); // 停止计时器
-    
-    // 更新手牌并广播出牌信息
-    processPlayerPlay(playerId, playedCombo); // 这个函数会设置 m_circleLeaderId
-    QString message = QString("%1 出牌: %2").arg(getPlayerById(playerId)->getName()).arg(playedCombo.getDescription());
-    emit sigBroadcastMessage(message);
-
-    // 通知UI更新显示出牌
-    emit sigUpdateTableCards(playerId, playedCombo, m_SelectedOriginCards);
+    clearAiCache(); // 出牌改变了手牌和公开信息，未完成的选牌和预先思考的结果都作废
+    m_turnOpen = false;
 
+    // 引擎更新手牌和桌面并推进到下一位玩家，界面随事件更新
+    QString errorMsg;
+    if (!stepEngine(GameEngine::Action::play(playerId, cards, playedCombo), &errorMsg)) {
+        m_turnOpen = true;
+        emit sigShowPlayerMessage(playerId, errorMsg, true);
+        return;
+    }
+    // 引擎随即派发的事件中没有写记录的(一局结算在下一个事件循环中)，记录顺序与动作顺序一致
+    m_recorder.play(playerId, cards, playedCombo);
     qDebug() << "GD_Controller::executePlay： 出牌处理完成, playerId=" << playerId;
-
-    // 推进游戏
-    advanceToNextPlayer();
 }
 
 void GD_Controller::executePass(int playerId)
 {
     stopTurnTimer(); // 停止计时器
-    
-    // 处理过牌并广播信息
-    processPlayerPass(playerId);
-    QString message = QString("%1 选择过牌").arg(getPlayerById(playerId)->getName());
-    emit sigBroadcastMessage(message);
-
-    // 发出玩家过牌信号
-    emit sigPlayerPassed(playerId);
+    cancelAiDecision(); // 本回合已经行动，未完成的选牌(如提示)作废；过牌不改变局面，预先思考的结果保留
+    m_turnOpen = false;
 
-    qDebug() << "GD_Controller::executePass： 过牌处理完成, playerId=" << playerId;
-
-    // 推进游戏
-    advanceToNextPlayer();
-}
-
-void GD_Controller::nextPlayer()
-{
-    // 固定顺序：0,1,2,3,0,1,2,3...
-    const int numPlayers = m_players.size();
-    if (numPlayers == 0) return;
-
-    int nextId = (m_currentPlayerId + 1) % numPlayers;
-
-    // 跳过已经出完牌的玩家
-    while (m_roundFinishOrder.contains(nextId) && m_activePlayersInRound > 1) {
-        nextId = (nextId + 1) % numPlayers;
-    }
-
-    m_currentPlayerId = nextId;
-
-    qDebug() << "GD_Controller::nextPlayer： 下一个玩家ID计算为 " << m_currentPlayerId;
-}
-
-// 新增：扫描并更新已完成出牌的玩家状态，并发送广播
-void GD_Controller::updateFinishedPlayers()
-{
-    for (auto it = m_players.begin(); it != m_players.end(); ++it) {
-        Player* player = it.value();
-        if (player && player->getHandCards().isEmpty() && !m_roundFinishOrder.contains(it.key())) {
-            m_roundFinishOrder.append(it.key());
-            m_activePlayersInRound--;
-            QString message = QString("%1 出完了所有牌，获得第%2名！")
-                .arg(player->getName())
-                .arg(5 - m_activePlayersInRound);
-            emit sigBroadcastMessage(message);
-            qDebug() << "GD_Controller::updateFinishedPlayers： 玩家" << it.key() << "出完牌";
-        }
-    }
-}
-
-bool GD_Controller::isLastPlayerStanding() const
-{
-    return m_activePlayersInRound <= 1;
-}
-
-void GD_Controller::appendLastPlayer()
-{
-    for (auto it = m_players.begin(); it != m_players.end(); ++it) {
-        if (!m_roundFinishOrder.contains(it.key())) {
-            m_roundFinishOrder.append(it.key());
-            qDebug() << "GD_Controller::appendLastPlayer： 最后一名玩家ID=" << it.key();
-            break;
-        }
-    }
-}
-
-void GD_Controller::enterState(GamePhase newPhase)
-{
-    if (m_currentPhase == newPhase) return;
-
-    qDebug() << "状态转换：从" << static_cast<int>(m_currentPhase) << "到" << static_cast<int>(newPhase);
-    m_currentPhase = newPhase;
-
-    switch (newPhase) {
-        case GamePhase::NotStarted:
-            // 重置所有游戏状态
-            m_currentPlayerId = -1;
-            m_circleLeaderId = -1;
-            m_activePlayersInRound = 0;
-            m_currentRoundNumber = 0;
-            m_currentTableCombo.type = CardComboType::Invalid;
-            m_currentTableCombo.cards_in_combo.clear();
-            m_passedPlayersInCircle.clear();
-            break;
-
-        case GamePhase::Dealing:
-            qDebug() << "进入状态：Dealing - 开始发牌阶段";
-            // 1. 重置本轮状态
-            m_passedPlayersInCircle.clear();
-            m_activePlayersInRound = 4;
-            m_currentTableCombo.type = CardComboType::Invalid;
-            m_currentTableCombo.cards_in_combo.clear();
-            m_circleLeaderId = -1;
-            
-            // 2. 发送新一轮开始的信号和消息
-            emit sigNewRoundStarted(m_currentRoundNumber);
-            {
-                Card::CardPoint team1Level = m_levelStatus.getTeamPlayingLevel(0);
-                Card::CardPoint team2Level = m_levelStatus.getTeamPlayingLevel(1);
-                
-                // 发送级牌更新信号
-                emit sigTeamLevelsUpdated(team1Level, team2Level);
-                
-                // 创建临时卡片用于显示文本消息
-                Card currentLevel_card;
-                currentLevel_card.setPoint(team1Level);
-                QString levelStr = currentLevel_card.PointToString();
-                emit sigBroadcastMessage(QString("第%1局开始！当前级牌：%2").arg(m_currentRoundNumber).arg(levelStr));
-            }
-            
-            // 3. 调用发牌函数
-            dealCardsToPlayers();
-
-            // 4. 发牌后，决定下一步流程
-            if (m_currentRoundNumber > 1 && m_lastRoundFinishOrder.size() == 4) {
-                qDebug() << "发牌完毕，进入进贡流程";
-                startTributePhaseLogic();
-            } else {
-                qDebug() << "发牌完毕，直接进入出牌流程";
-                determineFirstPlayerForRound();
-                enterState(GamePhase::Playing);
-            }
-            break;
-
-        case GamePhase::Playing:
-            {
-                qDebug() << "进入状态：Playing - 开始出牌阶段";
-                // 确保当前玩家已设置
-                if (m_currentPlayerId == -1) {
-                    qWarning() << "错误：进入Playing状态时currentPlayerId未设置";
-                    return;
-                }
-
-                Player* currentPlayer = getPlayerById(m_currentPlayerId);
-                if (!currentPlayer) {
-                    qWarning() << "错误：找不到当前玩家，ID:" << m_currentPlayerId;
-                    return;
-                }
-
-                // 设置当前玩家并启用其控制
-                emit sigSetCurrentTurnPlayer(m_currentPlayerId, currentPlayer->getName());
-                
-                // 如果是新的一圈开始，不能过牌
-                bool canPass = (m_currentTableCombo.type != CardComboType::Invalid);
-                emit sigEnablePlayerControls(m_currentPlayerId, true, canPass);
-
-                // 广播轮到谁出牌
-                emit sigBroadcastMessage(QString("轮到 %1 出牌！").arg(currentPlayer->getName()));
-                
-                // 启动计时器
-                startTurnTimer();
-
-        		// 如果是AI玩家，触发自动出牌
-                QTimer::singleShot(0, [this]() {
-                    if (Player* p = getPlayerById(m_currentPlayerId)) {
-                        p->autoPlay(this, m_currentTableCombo);
-                    }
-                });
-            }
-            break;
-
-        case GamePhase::TributeInput:
-            {
-                qDebug() << "进入状态：TributeInput - 等待玩家选择进贡牌";
-                const TributeInfo& currentTribute = m_pendingTributes[m_currentTributeIndex];
-                Player* fromPlayer = getPlayerById(currentTribute.fromPlayerId);
-                
-                if (fromPlayer) {
-                    emit sigEnablePlayerControls(currentTribute.fromPlayerId, true, false);
-                    emit sigBroadcastMessage(QString("请%1选择最大的牌进贡").arg(fromPlayer->getName()));
-                }
-            }
-            break;
-
-        case GamePhase::TributeProcess:
-            {
-                qDebug() << "进入状态：TributeProcess - 等待玩家选择还贡牌";
-                const TributeInfo& currentTribute = m_pendingTributes[m_currentTributeIndex];
-                Player* fromPlayer = getPlayerById(currentTribute.fromPlayerId);
-                Player* toPlayer = getPlayerById(currentTribute.toPlayerId);
-                
-                if (fromPlayer && toPlayer) {
-                    Team* fromTeam = getTeamOfPlayer(currentTribute.fromPlayerId);
-                    Team* toTeam = getTeamOfPlayer(currentTribute.toPlayerId);
-                    bool isTeammate = (fromTeam == toTeam);
-                    
-                    emit sigEnablePlayerControls(currentTribute.fromPlayerId, true, false);
-                    if (isTeammate) {
-                        emit sigBroadcastMessage(QString("请%1选择一张10或以下的牌还贡给队友%2")
-                            .arg(fromPlayer->getName())
-                            .arg(toPlayer->getName()));
-                    } else {
-                        emit sigBroadcastMessage(QString("请%1选择一张牌还贡给%2")
-                            .arg(fromPlayer->getName())
-                            .arg(toPlayer->getName()));
-                    }
-                }
-            }
-            break;
-
-        case GamePhase::RoundOver:
-            qDebug() << "进入状态：RoundOver - 本局结束";
-            // 回合结束，调度结果处理
-            QTimer::singleShot(0, this, &GD_Controller::processRoundResults);
-            break;
-
-        case GamePhase::GameOver:
-            {
-                qDebug() << "进入状态：GameOver - 游戏结束";
-                // 游戏结束，处理最终逻辑
-                int winnerTeamId = m_levelStatus.getGameWinnerTeamId();
-                Team* finalWinner = m_teams[winnerTeamId];
-                if (finalWinner) {
-                    QString finalMessage = QString("恭喜%1队获得最终胜利！").arg(winnerTeamId + 1);
-                    try {
-                        emit sigGameOver(winnerTeamId, QString("队伍%1").arg(winnerTeamId + 1), finalMessage);
-                    }
-                    catch (...) {
-                        qDebug() << "警告：发送游戏结束信号时发生异常";
-                    }
-                }
-            }
-            break;
-    }
-}
-
-void GD_Controller::advanceToNextPlayer()
-{
-    // 记录当前行动的玩家ID，以便后续判断该玩家是否刚刚出完牌
-    int lastPlayerId = m_currentPlayerId;
-    
-    // 1. 每次推进前，都先检查是否有人出完牌，以及是否因此导致回合结束
-    if (handleRoundEnd()) {
-        // 如果回合结束，processRoundResults会被调用并启动新一轮或结束游戏，
-        // 此处无需再做任何事。
+    QString errorMsg;
+    if (!stepEngine(GameEngine::Action::pass(playerId), &errorMsg)) {
+        m_turnOpen = true;
+        emit sigShowPlayerMessage(playerId, errorMsg, true);
         return;
     }
-    
-    // 检查刚才行动的玩家是否已经出完牌（即不再游戏中）
-    bool lastPlayerFinished = !isPlayerInGame(lastPlayerId);
-    
-    // 2. 检查当前"圈"是否结束
-    // 条件: (A)当前有领出者，并且所有其他活跃玩家都已经Pass了
-    //       (B)刚才行动的玩家出完了所有牌
-    bool allOthersPassed = (m_circleLeaderId != -1 && allOtherActivePlayersPassed(m_circleLeaderId));
-    bool circleEnded = allOthersPassed || lastPlayerFinished;
-
-	// 如果圈结束，处理圈结束逻辑
-    if (circleEnded)
-    {
-        qDebug() << "advanceToNextPlayer: 圈结束! " 
-                 << (lastPlayerFinished ? "玩家出完牌导致圈结束。" : "所有其他玩家已Pass。")
-                 << "领出者: " << m_circleLeaderId;
-        
-        // 确定下一圈的领出者
-        int nextLeaderId = -1;
-        
-        if (allOthersPassed && isPlayerInGame(m_circleLeaderId)) {
-            // 情况A：所有人都Pass且圈主还在游戏中，由圈主开始新一圈
-            nextLeaderId = m_circleLeaderId;
-            qDebug() << "圈主 " << m_circleLeaderId << " 仍在游戏中，由他开始新一圈。";
-        }
-        else {
-            // 情况B：出牌者打光牌或圈主已出完牌
-            // 由当前行动者的下一位未出完牌的玩家开始新一圈
-            m_currentPlayerId = lastPlayerId;
-            nextPlayer(); // 找到下一个合法玩家
-            nextLeaderId = m_currentPlayerId;
-            qDebug() << "需要寻找新的圈主，下一圈由 " << nextLeaderId << " 开始。";
-        }
-
-        // 延迟1.5秒后再开始新一圈，让玩家有时间看清上一手牌
-        QTimer::singleShot(1500, this, [this, nextLeaderId]() {
-            // 设置新一圈的领出者和当前玩家
-            m_currentPlayerId = nextLeaderId;
-            m_circleLeaderId = nextLeaderId;
-            
-            Player* leader = getPlayerById(m_currentPlayerId);
-            if (!leader) return; // 安全检查
-            
-            // 重置桌面，开始新的一圈
-            resetTableCombo();
-            m_passedPlayersInCircle.clear();
-            
-            // 通知UI和所有玩家
-            emit sigClearTableCards();
-            emit sigBroadcastMessage(QString("新的一圈开始，由 %1 出牌。").arg(leader->getName()));
-            emit sigSetCurrentTurnPlayer(m_currentPlayerId, leader->getName());
-            
-            // 新一圈的领出者不能Pass
-            emit sigEnablePlayerControls(m_currentPlayerId, true, false);
-            
-            // 启动计时器
-            startTurnTimer();
-
-            // 如果是AI玩家，触发其行动
-            if (leader->getType() == Player::AI) {
-                QTimer::singleShot(500, this, [this]() {
-                    if (m_currentPhase == GamePhase::Playing) {
-                        Player* p = getPlayerById(m_currentPlayerId);
-                        if (p && p->getType() == Player::AI) {
-                            p->autoPlay(this, m_currentTableCombo);
-                        }
-                    }
-                });
-            }
-        });
-    }
-    else
-    {
-        // 3. 圈未结束，正常轮到下一位玩家
-        nextPlayer(); // nextPlayer() 只负责按顺序计算出下一个玩家ID
-        
-        Player* next_p = getPlayerById(m_currentPlayerId);
-        if (!next_p) return; // 安全检查
-        
-        qDebug() << "advanceToNextPlayer: 圈未结束，轮到下一位玩家 " << m_currentPlayerId;
-        
-        // 通知UI和所有玩家
-        emit sigBroadcastMessage(QString("轮到 %1 出牌！").arg(next_p->getName()));
-        emit sigSetCurrentTurnPlayer(m_currentPlayerId, next_p->getName());
-        
-        // 圈未结束时，玩家可以选择出牌或过牌
-        emit sigEnablePlayerControls(m_currentPlayerId, true, true);
-        
-        // 启动计时器
-        startTurnTimer();
-    }
-    
-    // 4. 如果圈未结束，触发AI行动
-    // 注意：圈结束的情况下，AI行动会在延迟后的新一圈开始时触发
-    if (!circleEnded) {
-        QTimer::singleShot(500, [this]() {
-            if (m_currentPhase == GamePhase::Playing) {
-                Player* p = getPlayerById(m_currentPlayerId);
-                if (p && p->getType() == Player::AI) {
-                    p->autoPlay(this, m_currentTableCombo);
-                }
-            }
-        });
-    }
+    m_recorder.pass(playerId);
+    qDebug() << "GD_Controller::executePass： 过牌处理完成, playerId=" << playerId;
 }
 
-// 添加记牌器相关的新方法实现
+// ==================== 记牌器 ====================
 void GD_Controller::initializeCardCounts()
 {
     qDebug() << "GD_Controller::initializeCardCounts - 初始化记牌器数据";
@@ -1417,36 +644,247 @@ void GD_Controller::onTick()
 
 void GD_Controller::onTurnTimeout()
 {
-    qDebug() << "玩家 " << m_currentPlayerId << " 操作超时!";
+    const int currentPlayerId = m_engine.currentPlayerId();
+    qDebug() << "玩家 " << currentPlayerId << " 操作超时!";
     stopTurnTimer(); // 确保所有计时器都停了
 
-    Player* currentPlayer = getPlayerById(m_currentPlayerId);
+    // 本回合的思考(或提示)已超时：尚未完成的搜索一并取消，不再占用线程池，下面代打的选牌不必与它争抢
+    if (m_aiRequest.active) {
+        auto it = m_aiCache.find(m_aiRequest.key);
+        if (it != m_aiCache.end() && it->handle) {
+            AiTask::cancel(it->handle);
+            m_aiCache.erase(it);
+        }
+    }
+    cancelAiDecision();
+
+    if (m_engine.phase() != GameEngine::Phase::Playing || !m_turnOpen) return;
+    Player* currentPlayer = getPlayerById(currentPlayerId);
     if (!currentPlayer || currentPlayer->getHandCards().isEmpty()) return;
 
-    if (currentPlayer->getType() == Player::AI) {
-        // AI玩家超时，直接调用其自动出牌逻辑
-        currentPlayer->autoPlay(this, m_currentTableCombo);
+    // 改用普通难度的选牌代为出牌(预先思考的结果已算好时直接使用)
+    if (currentPlayer->getType() == Player::AI || m_engine.tableCombo().type == CardComboType::Invalid) {
+        // AI玩家，或轮到人类玩家领出必须出牌
+        startAiDecision(currentPlayerId, AiPurpose::TimeoutPlay);
     } else {
-        // 人类玩家超时，使用临时AI来决定出牌
-        if (m_currentTableCombo.type == CardComboType::Invalid) {
-            // 轮到自己出牌，必须出
-            // 使用临时AI
-            NPCPlayer tempAI("HintBot", -1);
-            tempAI.setHandCards(currentPlayer->getHandCards());
-            tempAI.setTeam(currentPlayer->getTeam());
-            
-            // 让AI找一个最小的牌打出去
-            QVector<Card> cardsToPlay = tempAI.getBestPlay(m_currentTableCombo);
-            if (cardsToPlay.isEmpty()) { // 极端情况，AI也找不到牌
-                // 打出最小的一张单牌
-                QVector<Card> sortedHand = currentPlayer->getHandCards();
-                std::sort(sortedHand.begin(), sortedHand.end());
-                cardsToPlay.append(sortedHand.first());
-            }
-            onPlayerPlay(m_currentPlayerId, cardsToPlay);
+        // 人类玩家跟牌，可以直接过
+        onPlayerPass(currentPlayerId);
+    }
+}
+
+// ==================== 异步AI选牌 ====================
+
+void GD_Controller::requestAiPlay(int playerId)
+{
+    if (m_engine.phase() != GameEngine::Phase::Playing || !m_turnOpen || playerId != m_engine.currentPlayerId()) return;
+    startAiDecision(playerId, AiPurpose::Play);
+}
+
+AiTask::Snapshot GD_Controller::makeAiSnapshot(int playerId, int difficulty, const CardCombo::ComboInfo& table, int tableOwner) const
+{
+    // 在主线程中拍下局面快照，工作线程只读取快照
+    AiTask::Snapshot snapshot = AiTask::makeSnapshot(m_engine, playerId, difficulty, table, tableOwner);
+    if (difficulty >= SettingsManager::AiHard) {
+        snapshot.budgetMs = SettingsManager::loadAiThinkTime();
+        snapshot.threadCount = SettingsManager::loadAiThreadCount();
+    }
+    return snapshot;
+}
+
+quint64 GD_Controller::submitAiTask(const AiTask::Snapshot& snapshot, bool ponder)
+{
+    const quint64 key = AiTask::snapshotKey(snapshot);
+    if (m_aiCache.contains(key)) return key; // 已在思考或已有结果
+
+    AiCacheEntry entry;
+    entry.ponder = ponder;
+    entry.handle = AiTask::start(snapshot, this, [this, key](const AiTask::Handle& handle, const QVector<Card>& cards, bool searched) {
+        onAiTaskFinished(key, handle, cards, searched);
+    });
+    m_aiCache.insert(key, entry);
+    return key;
+}
+
+void GD_Controller::startAiDecision(int playerId, AiPurpose purpose)
+{
+    if (!getPlayerById(playerId)) return;
+    cancelAiDecision();
+
+    // AI出牌和提示按设置的难度思考，与预先思考的快照一致；超时代打用普通难度尽快给出结果，
+    // 但若按设置难度预先思考的结果已经算好，直接使用
+    const int difficulty = SettingsManager::loadAiDifficulty();
+    AiTask::Snapshot snapshot = makeAiSnapshot(playerId, difficulty, m_engine.tableCombo(), m_engine.tableOwnerId());
+    if (purpose == AiPurpose::TimeoutPlay && difficulty != SettingsManager::AiNormal) {
+        auto it = m_aiCache.constFind(AiTask::snapshotKey(snapshot));
+        if (it == m_aiCache.constEnd() || !it->ready) {
+            snapshot = makeAiSnapshot(playerId, SettingsManager::AiNormal, m_engine.tableCombo(), m_engine.tableOwnerId());
+        }
+    }
+
+    // 实际轮到的局面优先于预先思考：需要新的搜索时，取消正在进行的预先思考，避免两个搜索争抢线程池
+    const quint64 key = AiTask::snapshotKey(snapshot);
+    if (snapshot.difficulty >= SettingsManager::AiHard && !m_aiCache.contains(key)) {
+        cancelPonderTasks();
+    }
+
+    m_aiRequest.active = true;
+    m_aiRequest.key = submitAiTask(snapshot);
+    m_aiRequest.playerId = playerId;
+    m_aiRequest.purpose = purpose;
+    m_aiRequestClock.start();
+    AiCacheEntry& entry = m_aiCache[key];
+    entry.ponder = false; // 已有请求等待该任务，不再取消
+    if (entry.ready) {
+        const QVector<Card> cards = entry.cards; // 交付可能立即出牌并清空缓存
+        deliverAiDecision(cards);
+    }
+}
+
+void GD_Controller::ponderTurn(int playerId, const CardCombo::ComboInfo& table, int tableOwner)
+{
+    if (!SettingsManager::loadAiPonder()) return;
+
+    // AI玩家思考自己的出牌，人类玩家的局面为提示预先计算
+    ponder(playerId, table, tableOwner);
+
+    // 当前玩家过牌时下家面对同一桌面牌型；若下家就是出牌者(其余玩家都已过牌)，则由它领出新一圈
+    // 当前玩家出牌后的局面取决于出什么牌，不做预测
+    if (table.type == CardComboType::Invalid) return;
+    for (int offset = 1; offset < Rollout::SEAT_COUNT; ++offset) {
+        const int next = (playerId + offset) % Rollout::SEAT_COUNT;
+        if (!m_engine.isPlayerInGame(next)) continue;
+        if (next == tableOwner) {
+            ponder(next, CardCombo::ComboInfo(), -1);
         } else {
-            // 跟牌，可以直接过
-            onPlayerPass(m_currentPlayerId);
+            ponder(next, table, tableOwner);
         }
+        break;
+    }
+}
+
+void GD_Controller::ponder(int playerId, const CardCombo::ComboInfo& table, int tableOwner)
+{
+    if (!m_engine.isPlayerInGame(playerId)) return;
+    const AiTask::Snapshot snapshot = makeAiSnapshot(playerId, SettingsManager::loadAiDifficulty(), table, tableOwner);
+    const quint64 key = AiTask::snapshotKey(snapshot);
+    if (m_aiCache.contains(key)) return;
+    for (const AiTask::Snapshot& queued : m_ponderQueue) {
+        if (AiTask::snapshotKey(queued) == key) return;
+    }
+    m_ponderQueue.append(snapshot);
+    submitNextPonder();
+}
+
+void GD_Controller::submitNextPonder()
+{
+    for (const AiCacheEntry& entry : m_aiCache) {
+        if (entry.handle) return; // 有任务在运行，完成后再提交
     }
-}
\ No newline at end of file
+    while (!m_ponderQueue.isEmpty()) {
+        const AiTask::Snapshot snapshot = m_ponderQueue.takeFirst();
+        if (m_aiCache.contains(AiTask::snapshotKey(snapshot))) continue;
+        submitAiTask(snapshot, true);
+        return;
+    }
+}
+
+void GD_Controller::cancelPonderTasks()
+{
+    for (auto it = m_aiCache.begin(); it != m_aiCache.end();) {
+        if (it->handle && it->ponder) {
+            AiTask::cancel(it->handle);
+            it = m_aiCache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void GD_Controller::cancelAiDecision()
+{
+    // 请求对应的任务仍留在缓存中继续思考，之后同一局面可能再次请求(如再次点击提示)
+    m_aiRequest.active = false;
+    ++m_aiRequestSerial;
+}
+
+void GD_Controller::clearAiCache()
+{
+    cancelAiDecision();
+    for (auto it = m_aiCache.begin(); it != m_aiCache.end(); ++it) {
+        AiTask::cancel(it->handle);
+    }
+    m_aiCache.clear();
+    m_ponderQueue.clear();
+}
+
+void GD_Controller::onAiTaskFinished(quint64 key, const AiTask::Handle& handle, const QVector<Card>& cards, bool searched)
+{
+    auto it = m_aiCache.find(key);
+    if (it == m_aiCache.end() || it->handle != handle) return; // 缓存已清空或任务已取消
+    if (searched) {
+        it->handle.reset();
+        it->ready = true;
+        it->cards = cards;
+    } else {
+        // 搜索在预算内没有完成任何模拟，结果只是启发式选牌：不缓存，之后再请求同一局面时重新搜索
+        m_aiCache.erase(it);
+    }
+    if (m_aiRequest.active && m_aiRequest.key == key) {
+        deliverAiDecision(cards);
+    }
+    submitNextPonder();
+}
+
+void GD_Controller::deliverAiDecision(const QVector<Card>& cards)
+{
+    const AiRequest request = m_aiRequest;
+    m_aiRequest.active = false;
+
+    // 预先思考的结果可能在轮到时已经算好，AI出牌仍保留最短的思考时间，避免连续出牌过快
+    const qint64 remaining = request.purpose == AiPurpose::Play ? kAiThinkDelayMs - m_aiRequestClock.elapsed() : 0;
+    if (remaining <= 0) {
+        onAiDecisionFinished(request.playerId, request.purpose, cards);
+        return;
+    }
+    const int serial = m_aiRequestSerial;
+    QTimer::singleShot(static_cast<int>(remaining), this, [this, serial, request, cards]() {
+        if (serial != m_aiRequestSerial) return; // 期间请求已被取消
+        onAiDecisionFinished(request.playerId, request.purpose, cards);
+    });
+}
+
+void GD_Controller::onAiDecisionFinished(int playerId, AiPurpose purpose, const QVector<Card>& cards)
+{
+    if (m_engine.phase() != GameEngine::Phase::Playing || !m_turnOpen || playerId != m_engine.currentPlayerId()) return;
+    Player* player = getPlayerById(playerId);
+    if (!player) return;
+
+    // 任务中的临时AI生成的牌归属于它自己(已销毁)，交还给实际玩家
+    QVector<Card> chosen = cards;
+    for (Card& card : chosen) {
+        card.setOwner(player);
+    }
+
+    if (purpose == AiPurpose::Hint) {
+        if (chosen.isEmpty()) {
+            // AI也找不到牌，说明真的要不起
+            emit sigShowPlayerMessage(playerId, "没有找到可以打得过上家的牌，建议过牌。", false);
+            return;
+        }
+        // 成功获取建议，发射信号让UI高亮这些牌
+        emit sigShowHint(playerId, chosen);
+        emit sigBroadcastMessage(QString("已为 %1 提供出牌提示。").arg(player->getName()));
+        return;
+    }
+
+    if (chosen.isEmpty()) {
+        if (m_engine.tableCombo().type != CardComboType::Invalid) {
+            onPlayerPass(playerId);
+            return;
+        }
+        if (player->getHandCards().isEmpty()) return;
+        // 极端情况：领出时也没找到牌，打出最小的一张单牌
+        chosen.append(player->getSmallestCard());
+    }
+    onPlayerPlay(playerId, chosen);
+}
@@ -6,19 +6,27 @@
 #include <QObject>
 #include <QVector>
 #include <QMap>
-#include <QSet> // 用于记录已pass的玩家
 #include <QTimer>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QFile>
 
 #include "Card.h"
 #include "Player.h"
 #include "Team.h"
-#include "Levelstatus.h"
 #include "Cardcombo.h" // 包含 CardCombo::ComboInfo 和 CardComboType
+#include "GameEngine.h"
+#include "AiTask.h"
+#include "GameRecord.h"
 
 // 前向声明UI类
 class GameWindow;
 class PlayerWidget;
 
+// GD_Controller: 连接界面和规则引擎(GameEngine)的适配层
+// 规则和状态都在引擎中同步完成；控制器把玩家操作转成引擎动作，把引擎事件转成界面信号，
+// 并负责界面节奏(新一圈前的停顿、AI的思考时间)、回合计时、癞子牌型选择对话框、音效和AI选牌任务
+
 class GD_Controller : public QObject
 {
     Q_OBJECT
@@ -31,6 +39,15 @@ public:
     void setupNewGame(const QVector<Player*>& players, const QVector<Team*>& teams); // 传入已创建的玩家和队伍
     void startGame(); // 开始整个游戏（第一局）
 
+    // --- 供AI读取的公开局面信息(不包含其他玩家的手牌) ---
+    int getHandCardCount(int playerId) const;                          // 某玩家剩余手牌张数
+    int getTableOwnerId() const { return m_engine.tableOwnerId(); }    // 桌面牌的出牌者
+    const QVector<int>& getRoundFinishOrder() const { return m_engine.roundFinishOrder(); } // 本局已出完牌的玩家
+    const QVector<Card>& getPlayedCards() const { return m_engine.playedCards(); } // 本局已打出的牌
+
+    // AI玩家请求出牌：快照当前局面后在工作线程中选牌，结果回到主线程再出牌或过牌
+    void requestAiPlay(int playerId);
+
 public slots:
     // --- 来自UI的玩家操作槽函数 ---
 
@@ -54,7 +71,7 @@ signals:
 	void sigGameStarted(); // 游戏开始信号
     void sigNewRoundStarted(int roundNumber); 	// 新一局开始信号
     void sigCardsDealt(int playerId, const QVector<Card>& hand); // 通知玩家手牌已经发好
-    void sigUpdatePlayerHand(int playerId, const QVector<Card>& newHand); // 手牌变化时更新
+    void sigPlayerHandChanged(int playerId, const QVector<Card>& added, const QVector<Card>& removed); // 手牌增量变化，UI只更新变化的牌
 
 	// 提示信号
 	void sigShowHint(int playerId, const QVector<Card>& suggestedCards);
@@ -95,21 +112,19 @@ signals:
 
 private:
     // --- 游戏状态成员 ---
-    QMap<int, Player*> m_players; // 通过ID映射玩家指针
-    QMap<int, Team*> m_teams;     // 通过ID映射队伍指针
-
-    LevelStatus m_levelStatus;    // 级别和胜负状态管理器
+    GameEngine m_engine;          // 规则和对局状态
 
-    int m_currentPlayerId;                 // 当前轮到出牌的玩家ID
-    CardCombo::ComboInfo m_currentTableCombo; // 当前桌面上最后一手合法的牌
-    int m_circleLeaderId;                  // 本圈第一个出牌的玩家ID (即m_currentTableCombo的所有者)
-    QSet<int> m_passedPlayersInCircle;     // 本圈已经选择"不出"的玩家ID
-    QVector<int> m_roundFinishOrder;       // 按顺序记录本局完成出牌的玩家ID
-    QVector<int> m_lastRoundFinishOrder;   // 存储上一局的玩家获胜顺序，用于进贡判断
-    int m_activePlayersInRound;            // 本局还剩多少玩家没打完牌
+    // 引擎事件按顺序转成界面信号；圈结束时暂停转发，停顿后再继续
+    QVector<GameEngine::Event> m_pendingEvents;
+    bool m_dispatchingEvents = false;
+    bool m_eventsPaused = false;
+    bool m_newCircleAnnounced = false; // 已播报新一圈，轮到领出者时不再重复播报
+    bool m_turnOpen = false;           // 当前玩家的回合已经开始(界面已启用操作)，可以接受出牌/过牌
+    int m_gameSerial = 0;              // 每局游戏设置时递增，延时回调据此识别是否属于旧游戏
 
-    QVector<Card> m_SelectedOriginCards;   // 记录上次出牌时玩家选中的原始卡牌，用于正确移除手牌
-    int m_currentRoundNumber;              // 当前是第几局
+    // 对局记录：追加到程序目录下的GuanDan.gdr(格式见GameRecord)，文件打不开时不记录
+    QFile m_recordFile;
+    GameRecordWriter m_recorder;       // 在m_recordFile之后声明，先析构并把缓冲写入文件
 
     // 记牌器相关成员
     QMap<Card::CardPoint, int> m_remainingCardCounts; // 追踪每种牌的剩余数量
@@ -120,54 +135,19 @@ private:
     int m_turnDuration;                    // 当前回合的总时长
     int m_timeRemaining;                   // 当前回合的剩余时长
 
-    // --游戏阶段管理--
-    enum class GamePhase {
-		NotStarted, // 游戏未开始
-		Dealing, // 发牌阶段
-		Playing, // 出牌阶段
-        TributeInput,  // 等待玩家选择进贡的牌
-        TributeProcess, // 处理进贡逻辑
-        RoundOver, // 回合结束
-        GameOver // 游戏结束
-    };
-    GamePhase m_currentPhase;
-
-    // --进贡相关状态 (用于多步进贡/还贡)--
-    struct TributeInfo {
-        int fromPlayerId;
-        int toPlayerId;
-        Card card;
-        bool isReturn; // 是进贡还是还贡
-    };
-    QVector<TributeInfo> m_pendingTributes; // 需要处理的进贡/还贡列表
-    int m_currentTributeIndex;
-
-    // --- 内部游戏流程方法 ---
-    void enterState(GamePhase newPhase); // 状态机核心：进入新状态
-    void advanceToNextPlayer();
-    void startNewRound(); // 开始新的一局 
-	void dealCardsToPlayers(); // 给玩家发牌
-    void determineFirstPlayerForRound(); // 决定新一局谁先出牌
-    void resetTableCombo(); // 重置桌面牌型
-
-    bool PlayerPlay(int playerId, const QVector<Card>& cardsToPlay, CardCombo::ComboInfo& outPlayedCombo);
-	void processPlayerPlay(int playerId, const CardCombo::ComboInfo& playedCombo);
-	// 玩家是否可以跳过
-    void processPlayerPass(int playerId);
-
-    // 扫描并更新已完成出牌的玩家状态，并发送广播
-    void updateFinishedPlayers();
-    // 判断只剩一个玩家
-    bool isLastPlayerStanding() const;
-    // 将最后一名玩家加入完成顺序
-    void appendLastPlayer();
-
-    void processRoundResults();         // 处理一局结束后的计分、升级等
-    QString generateRoundSummary() const;
-
-    void startTributePhaseLogic();      // 开始进贡/还贡的逻辑设定
-    void processNextTributeAction();    // 处理当前待办的进贡/还贡项
-    void completeTribute(const TributeInfo& tribute); // 完成一次贡牌/还牌的转移
+    // --- 引擎驱动 ---
+    // 执行一个引擎动作并转发产生的事件，动作不合法时返回false
+    bool stepEngine(const GameEngine::Action& action, QString* errorMsg = nullptr);
+    void dispatchEvents();
+    void handleEvent(const GameEngine::Event& event);
+    void onTurnStarted(int playerId, bool canPass);
+    void onTributeRequested(int fromPlayerId, int toPlayerId, bool isReturn);
+
+    // 选中的牌有多种牌型解释时确定打哪一种：AI和不含癞子的牌取第一种，人类玩家含癞子时弹框选择
+    bool chooseComboInterpretation(int playerId, const QVector<Card>& cards,
+        const QVector<CardCombo::ComboInfo>& combos, CardCombo::ComboInfo& chosen);
+
+    QString generateRoundSummary(int roundNumber, const QVector<int>& finishOrder) const;
 
     // 记牌器相关方法
     void initializeCardCounts(); // 初始化记牌器数据
@@ -177,31 +157,68 @@ private:
     void startTurnTimer();
     void stopTurnTimer();
 
+    // --- 异步AI选牌(见AiTask) ---
+    enum class AiPurpose {
+        Play,        // AI玩家正常出牌
+        TimeoutPlay, // 回合超时后代为出牌(普通难度，不等待思考时间)
+        Hint         // 为人类玩家提示出牌
+    };
+    // 选牌结果缓存：按AiTask::snapshotKey保存进行中或已完成的任务
+    // 预先思考(pondering)在其他玩家的回合提交可能轮到的局面，真正轮到时直接取用结果
+    struct AiCacheEntry {
+        AiTask::Handle handle; // 进行中的任务，完成后为空
+        bool ponder = false;   // 预先思考提交、还没有请求等待的任务，实际的请求需要搜索线程时可以取消
+        bool ready = false;
+        QVector<Card> cards;
+    };
+    QHash<quint64, AiCacheEntry> m_aiCache;
+    // 等待提交的预先思考：同时运行的多个搜索会争抢搜索线程池，后提交的一个几乎得不到模拟，
+    // 因此预先思考逐个提交，前一个任务完成后再提交下一个
+    QVector<AiTask::Snapshot> m_ponderQueue;
+    // 正在等待结果的选牌请求，同一时间只有一个
+    struct AiRequest {
+        bool active = false;
+        quint64 key = 0;
+        int playerId = -1;
+        AiPurpose purpose = AiPurpose::Play;
+    };
+    AiRequest m_aiRequest;
+    QElapsedTimer m_aiRequestClock; // 请求提交的时刻，AI出牌至少"思考"kAiThinkDelayMs
+    int m_aiRequestSerial = 0;      // 每次取消请求时递增，延迟交付的结果据此识别是否过期
+
+    // 为playerId拍下局面快照；table、tableOwner为其面对的桌面牌型和出牌者
+    AiTask::Snapshot makeAiSnapshot(int playerId, int difficulty, const CardCombo::ComboInfo& table, int tableOwner) const;
+    // 缓存中没有该快照时提交任务，返回快照的键
+    quint64 submitAiTask(const AiTask::Snapshot& snapshot, bool ponder = false);
+    // 为当前回合的玩家请求选牌，缓存中已有结果时立即交付
+    void startAiDecision(int playerId, AiPurpose purpose);
+    // 回合开始时预先思考：当前玩家的局面，以及当前玩家过牌后下家面对的局面
+    void ponderTurn(int playerId, const CardCombo::ComboInfo& table, int tableOwner);
+    void ponder(int playerId, const CardCombo::ComboInfo& table, int tableOwner);
+    // 没有任务在运行时提交队列中的下一个预先思考
+    void submitNextPonder();
+    // 取消进行中的预先思考任务，让出搜索线程池给实际的请求
+    void cancelPonderTasks();
+    // 放弃等待中的请求(缓存保留)：出牌、过牌和回合超时时调用
+    void cancelAiDecision();
+    // 取消全部任务并清空缓存：有人出牌或阶段切换后，缓存的局面都不会再出现
+    void clearAiCache();
+    // 任务完成回到主线程：存入缓存，若正是等待中的请求则交付；searched为false的退回结果只交付、不缓存
+    void onAiTaskFinished(quint64 key, const AiTask::Handle& handle, const QVector<Card>& cards, bool searched);
+    void deliverAiDecision(const QVector<Card>& cards);
+    // 执行选牌结果：仍是该玩家的回合时才执行
+    void onAiDecisionFinished(int playerId, AiPurpose purpose, const QVector<Card>& cards);
+
     // --- 辅助方法 ---
     Player* getPlayerById(int id) const; // 通过ID获取玩家指针
     Team* getTeamOfPlayer(int playerId) const;
-    bool isPlayerInGame(int playerId) const; // 玩家是否还未出完牌
-    QVector<int> getActivePlayerIdsSorted() const; // 获取当前还未出完牌的玩家ID, 按座位顺序
-    bool allOtherActivePlayersPassed(int currentPlayerId) const;
 
     // 验证当前操作阶段和执行者是否合法, 返回是否合法, 同时通过errorMsg输出提示
     bool canPerformAction(int playerId, QString& errorMsg);
 
-    // 处理玩家出牌后的流程: 更新手牌、广播消息、记录出牌信息并切换下一个玩家
-    void executePlay(int playerId, const CardCombo::ComboInfo& playedCombo);
-
-    // 处理玩家过牌后的流程: 广播消息、记录过牌信息并切换下一个玩家
+    // 处理玩家出牌/过牌: 停止计时、处理AI任务后交给引擎，并推进到下一个玩家
+    void executePlay(int playerId, const QVector<Card>& cards, const CardCombo::ComboInfo& playedCombo);
     void executePass(int playerId);
-
-    // 检查回合结束, 如结束则处理相关逻辑并返回true
-    bool handleRoundEnd();
-
-    // 切换到下一个玩家并发出控制信号
-    void nextPlayer();
-
-    // 新增：积分系统相关成员
-    int m_roundBaseScore;           // 本局基础分
-    int m_roundDynamicMultiplier;   // 本局动态倍率
 };
 
-#endif // GD_CONTROLLER_H
\ No newline at end of file
+#endif // GD_CONTROLLER_H
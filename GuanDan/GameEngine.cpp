@@ -0,0 +1,654 @@
+#include "GameEngine.h"
+
+#include <QRandomGenerator>
+#include <QDebug>
+#include <algorithm>
+
+#include "Carddeck.h"
+#include "RngStream.h"
+#include "ComboCatalog.h"
+#include "Player.h"
+#include "Team.h"
+
+// ==================== 动作 ====================
+
+GameEngine::Action GameEngine::Action::proceed()
+{
+    return Action();
+}
+
+GameEngine::Action GameEngine::Action::play(int playerId, const QVector<Card>& cards, const CardCombo::ComboInfo& combo)
+{
+    Action action;
+    action.type = Play;
+    action.playerId = playerId;
+    action.cards = cards;
+    action.combo = combo;
+    return action;
+}
+
+GameEngine::Action GameEngine::Action::pass(int playerId)
+{
+    Action action;
+    action.type = Pass;
+    action.playerId = playerId;
+    return action;
+}
+
+GameEngine::Action GameEngine::Action::tribute(int playerId, const Card& card)
+{
+    Action action;
+    action.type = Tribute;
+    action.playerId = playerId;
+    action.cards.append(card);
+    return action;
+}
+
+// ==================== 设置 ====================
+
+GameEngine::GameEngine()
+{
+}
+
+bool GameEngine::setup(const QVector<Player*>& players, const QVector<Team*>& teams)
+{
+    m_players.clear();
+    m_teams[0] = m_teams[1] = nullptr;
+    m_phase = Phase::NotStarted;
+
+    if (players.size() != PLAYER_COUNT || teams.size() != 2) {
+        qDebug() << "错误：掼蛋需要4个玩家和2个队伍";
+        return false;
+    }
+
+    m_players.fill(nullptr, PLAYER_COUNT);
+    for (Player* player : players) {
+        if (!player || !player->getTeam() || player->getID() < 0 || player->getID() >= PLAYER_COUNT) {
+            qDebug() << "错误：玩家ID须为0~3且已加入队伍";
+            return false;
+        }
+        m_players[player->getID()] = player;
+    }
+    for (Team* team : teams) {
+        if (!team || team->getId() < 0 || team->getId() > 1 || team->getPlayers().size() != 2) {
+            qDebug() << "错误：队伍ID须为0、1且每队2个玩家";
+            return false;
+        }
+        m_teams[team->getId()] = team;
+    }
+    if (m_players.contains(nullptr) || !m_teams[0] || !m_teams[1]) {
+        qDebug() << "错误：玩家或队伍ID重复";
+        return false;
+    }
+    return true;
+}
+
+void GameEngine::startGame()
+{
+    if (!m_teams[0] || !m_teams[1]) return;
+
+    m_levelStatus = LevelStatus();
+    m_levelStatus.initializeGameLevels(*m_teams[0], *m_teams[1]);
+    for (Team* team : m_teams) {
+        team->setScore(0);
+    }
+    // 没有指定种子时每场比赛取一个随机种子；seed()可以取出，用于重放
+    if (!m_fixedSeed) {
+        m_seed = QRandomGenerator::global()->generate64();
+    }
+    m_matchRng = RngStream(m_seed);
+    m_roundNumber = 1;
+    m_roundFinishOrder.clear();
+    m_lastRoundFinishOrder.clear();
+    m_events.clear();
+    beginRound();
+}
+
+// ==================== 查询 ====================
+
+const GameEngine::TributeInfo* GameEngine::currentTribute() const
+{
+    if (m_phase != Phase::Tribute || m_currentTributeIndex >= m_pendingTributes.size()) return nullptr;
+    return &m_pendingTributes[m_currentTributeIndex];
+}
+
+Player* GameEngine::player(int playerId) const
+{
+    return (playerId >= 0 && playerId < m_players.size()) ? m_players[playerId] : nullptr;
+}
+
+Team* GameEngine::team(int teamId) const
+{
+    return (teamId == 0 || teamId == 1) ? m_teams[teamId] : nullptr;
+}
+
+Team* GameEngine::teamOfPlayer(int playerId) const
+{
+    Player* p = player(playerId);
+    return (p && p->getTeam()) ? team(p->getTeam()->getId()) : nullptr;
+}
+
+int GameEngine::handCardCount(int playerId) const
+{
+    Player* p = player(playerId);
+    return p ? p->getHandCards().size() : 0;
+}
+
+QVector<CardCombo::ComboInfo> GameEngine::playInterpretations(int playerId, const QVector<Card>& cards) const
+{
+    Player* p = player(playerId);
+    // 验证玩家是否拥有这些牌(通过手牌计数矩阵判断，按张数计)
+    if (!p || cards.isEmpty() || !p->hasCards(cards)) return {};
+    return CardCombo::getAllPossibleValidPlays(cards, p, m_tableCombo.type, m_tableCombo.level);
+}
+
+QVector<GameEngine::Action> GameEngine::legalActions() const
+{
+    QVector<Action> actions;
+    switch (m_phase) {
+    case Phase::Dealing:
+    case Phase::RoundOver:
+        actions.append(Action::proceed());
+        break;
+
+    case Phase::Tribute: {
+        const TributeInfo* tribute = currentTribute();
+        Player* from = tribute ? player(tribute->fromPlayerId) : nullptr;
+        if (!from) break;
+        // 同点数同花色的牌只列一次
+        QVector<Card> seen;
+        for (const Card& card : from->getHandCards()) {
+            if (seen.contains(card) || !tributeCardAllowed(*tribute, card, nullptr)) continue;
+            seen.append(card);
+            actions.append(Action::tribute(tribute->fromPlayerId, card));
+        }
+        break;
+    }
+
+    case Phase::Playing: {
+        Player* p = player(m_currentPlayerId);
+        if (!p) break;
+        if (m_tableCombo.type != CardComboType::Invalid) {
+            actions.append(Action::pass(m_currentPlayerId));
+        }
+
+        // 由牌型目录列出能组成且能压过桌面的牌型，再用规则引擎一次性校验并得到具体牌型
+        const ComboCatalog& catalog = ComboCatalog::forLevel(p->getLevelContext().levelRank());
+        const ComboCatalog::HandCounts counts = ComboCatalog::HandCounts::fromHand(p->getHandSet(), p->getLevelContext());
+        QVector<QVector<Card>> candidates;
+        QVector<int> candidateTypes;
+        for (const ComboCatalog::Entry& entry : catalog.entries()) {
+            if (!CardCombo::canBeat(entry.type, entry.level, m_tableCombo.type, m_tableCombo.level)) continue;
+            if (catalog.wildsNeeded(entry, counts) < 0) continue;
+            QVector<Card> cards = catalog.materialize(entry, p->getHandSet(), p);
+            if (cards.isEmpty()) continue;
+            candidates.append(cards);
+            candidateTypes.append(entry.type);
+        }
+        const CardCombo::BatchResult result = CardCombo::evaluateBatch(candidates, p, m_tableCombo.type, m_tableCombo.level);
+        for (int i = 0; i < result.size(); ++i) {
+            // 牌型必须与目录项一致(避免顺子被判为同花顺炸弹)
+            if (!result.can_beat[i] || result.types[i] != candidateTypes[i]) continue;
+            actions.append(Action::play(m_currentPlayerId, candidates[i], result.comboAt(i, candidates[i])));
+        }
+        break;
+    }
+
+    case Phase::NotStarted:
+    case Phase::GameOver:
+        break;
+    }
+    return actions;
+}
+
+QVector<GameEngine::Event> GameEngine::takeEvents()
+{
+    QVector<Event> events;
+    events.swap(m_events);
+    return events;
+}
+
+// ==================== 执行动作 ====================
+
+bool GameEngine::step(const Action& action, QString* error)
+{
+    switch (action.type) {
+    case Action::Continue:
+        if (m_phase == Phase::Dealing) {
+            dealCards();
+            // 第二局起根据上一局名次进贡，否则直接开始出牌
+            if (m_roundNumber > 1 && m_lastRoundFinishOrder.size() == PLAYER_COUNT) {
+                startTribute();
+            }
+            else {
+                chooseFirstPlayer();
+                startTurn();
+            }
+            return true;
+        }
+        if (m_phase == Phase::RoundOver) {
+            settleRound();
+            return true;
+        }
+        if (error) *error = "当前没有需要推进的步骤";
+        return false;
+
+    case Action::Play:
+        return applyPlay(action, error);
+    case Action::Pass:
+        return applyPass(action, error);
+    case Action::Tribute:
+        return applyTribute(action, error);
+    }
+    return false;
+}
+
+bool GameEngine::applyPlay(const Action& action, QString* error)
+{
+    if (m_phase != Phase::Playing) {
+        if (error) *error = "当前不是出牌阶段";
+        return false;
+    }
+    if (action.playerId != m_currentPlayerId) {
+        if (error) *error = "还没轮到您操作";
+        return false;
+    }
+
+    const QVector<CardCombo::ComboInfo> combos = playInterpretations(action.playerId, action.cards);
+    if (combos.isEmpty()) {
+        if (error) *error = "出牌不符合规则";
+        return false;
+    }
+
+    // 含癞子时可能有多种解释：取调用者选定的一种，未指定时取第一种
+    CardCombo::ComboInfo played = combos.first();
+    if (action.combo.type != CardComboType::Invalid) {
+        auto match = std::find_if(combos.begin(), combos.end(), [&action](const CardCombo::ComboInfo& combo) {
+            return combo.type == action.combo.type && combo.level == action.combo.level
+                && combo.is_flush_straight_bomb == action.combo.is_flush_straight_bomb;
+        });
+        if (match == combos.end()) {
+            if (error) *error = "出牌不符合规则";
+            return false;
+        }
+        played = *match;
+    }
+
+    Player* p = player(action.playerId);
+    p->removeCards(action.cards);
+    m_playedCards += action.cards;
+
+    m_tableCombo = played;
+    m_circleLeaderId = action.playerId;
+    m_passedPlayersInCircle.clear();
+
+    Event event;
+    event.type = Event::Played;
+    event.playerId = action.playerId;
+    event.combo = played;
+    event.cards = action.cards;
+    m_events.append(event);
+
+    // 炸弹使本局倍率翻倍
+    if (played.type == CardComboType::Bomb) {
+        m_roundDynamicMultiplier *= 2;
+        pushEvent(Event::MultiplierChanged, -1, multiplier());
+    }
+
+    advance(action.playerId);
+    return true;
+}
+
+bool GameEngine::applyPass(const Action& action, QString* error)
+{
+    if (m_phase != Phase::Playing) {
+        if (error) *error = "当前不是出牌阶段";
+        return false;
+    }
+    if (action.playerId != m_currentPlayerId) {
+        if (error) *error = "还没轮到您操作";
+        return false;
+    }
+    if (m_tableCombo.type == CardComboType::Invalid) {
+        if (error) *error = "您是第一个出牌，不能过牌";
+        return false;
+    }
+
+    m_passedPlayersInCircle.insert(action.playerId);
+    pushEvent(Event::Passed, action.playerId);
+    advance(action.playerId);
+    return true;
+}
+
+bool GameEngine::tributeCardAllowed(const TributeInfo& tribute, const Card& card, QString* error) const
+{
+    Player* from = player(tribute.fromPlayerId);
+    if (!from || !from->hasCards(QVector<Card>{ card })) {
+        if (error) *error = "手牌中没有这张牌！";
+        return false;
+    }
+
+    if (tribute.isReturn) {
+        // 还贡给队友的牌不能大于10
+        if (teamOfPlayer(tribute.fromPlayerId) == teamOfPlayer(tribute.toPlayerId) && card.point() > Card::Card_10) {
+            if (error) *error = "还贡给队友的牌必须是10或以下的牌！";
+            return false;
+        }
+        return true;
+    }
+
+    // 进贡必须是最大的牌：手牌索引直接给出最大的牌，只要它不比进贡的牌大即可
+    if (from->getLevelContext().greaterThan(from->getLargestCard(), card)) {
+        if (error) *error = "进贡必须选择手牌中最大的牌！";
+        return false;
+    }
+    return true;
+}
+
+bool GameEngine::applyTribute(const Action& action, QString* error)
+{
+    const TributeInfo* current = currentTribute();
+    if (!current) {
+        if (error) *error = "当前不是进贡阶段";
+        return false;
+    }
+    if (action.playerId != current->fromPlayerId || action.cards.size() != 1) {
+        if (error) *error = "还没轮到您操作";
+        return false;
+    }
+    const TributeInfo tribute = *current;
+    if (!tributeCardAllowed(tribute, action.cards.first(), error)) {
+        return false;
+    }
+
+    // 转移牌，并更改牌的所有者
+    QVector<Card> cards = action.cards;
+    Player* from = player(tribute.fromPlayerId);
+    Player* to = player(tribute.toPlayerId);
+    from->removeCards(cards);
+    cards.first().setOwner(to);
+    to->addCards(cards);
+
+    Event event;
+    event.type = Event::TributeGiven;
+    event.playerId = tribute.fromPlayerId;
+    event.targetId = tribute.toPlayerId;
+    event.flag = tribute.isReturn;
+    event.cards = cards;
+    m_events.append(event);
+
+    m_currentTributeIndex++;
+    nextTribute();
+    return true;
+}
+
+// ==================== 流程 ====================
+
+void GameEngine::pushEvent(Event::Type type, int playerId, int value, bool flag)
+{
+    Event event;
+    event.type = type;
+    event.playerId = playerId;
+    event.value = value;
+    event.flag = flag;
+    m_events.append(event);
+}
+
+void GameEngine::resetTable()
+{
+    m_tableCombo = CardCombo::ComboInfo();
+    m_passedPlayersInCircle.clear();
+}
+
+void GameEngine::beginRound()
+{
+    m_roundBaseScore = 1;
+    m_roundDynamicMultiplier = 1;
+    m_playedCards.clear();
+    m_roundFinishOrder.clear();
+    m_activePlayersInRound = PLAYER_COUNT;
+    m_pendingTributes.clear();
+    m_currentTributeIndex = 0;
+    resetTable();
+    m_circleLeaderId = -1;
+    m_currentPlayerId = -1;
+    // 每局的随机数流只取决于比赛种子和局数
+    m_roundRng = m_matchRng.split(static_cast<quint64>(m_roundNumber));
+
+    m_phase = Phase::Dealing;
+    pushEvent(Event::RoundStarted, -1, m_roundNumber);
+}
+
+void GameEngine::dealCards()
+{
+    // 创建牌组并用本局的随机数流洗牌(deck构造函数中会创建两副牌并洗牌)
+    CardDeck deck(m_roundRng);
+    const QVector<Card> allCards = deck.getDeckCards();
+    if (allCards.size() < m_cardsPerPlayer * PLAYER_COUNT) {
+        qWarning() << "错误：牌组大小不足，无法发牌";
+        return;
+    }
+
+    const bool preset = m_presetHands.size() == PLAYER_COUNT;
+    for (int id = 0; id < PLAYER_COUNT; ++id) {
+        Player* p = m_players[id];
+        QVector<Card> hand = preset ? m_presetHands[id] : allCards.mid(id * m_cardsPerPlayer, m_cardsPerPlayer);
+        for (Card& card : hand) {
+            card.setOwner(p);
+        }
+        p->clearHandCards();
+        p->addCards(hand);
+
+        Event event;
+        event.type = Event::CardsDealt;
+        event.playerId = id;
+        event.cards = hand;
+        m_events.append(event);
+    }
+    m_presetHands.clear();
+}
+
+void GameEngine::chooseFirstPlayer()
+{
+    if (m_roundNumber == 1) {
+        // 第一局：随机选择一名玩家先出
+        m_currentPlayerId = m_roundRng.bounded(PLAYER_COUNT);
+    }
+    else if (!m_lastRoundFinishOrder.isEmpty()) {
+        // 之后：上一局的末游先出
+        m_currentPlayerId = m_lastRoundFinishOrder.last();
+    }
+    else {
+        qWarning() << "错误：非第一局但没有上一局的排名信息，使用默认玩家0";
+        m_currentPlayerId = 0;
+    }
+    m_circleLeaderId = m_currentPlayerId;
+}
+
+void GameEngine::startTribute()
+{
+    m_pendingTributes.clear();
+    m_currentTributeIndex = 0;
+
+    const int firstPlayerId = m_lastRoundFinishOrder[0];  // 头游
+    const int secondPlayerId = m_lastRoundFinishOrder[1]; // 二游
+    const int thirdPlayerId = m_lastRoundFinishOrder[2];  // 三游
+    const int fourthPlayerId = m_lastRoundFinishOrder[3]; // 末游
+
+    m_doubleDown = teamOfPlayer(thirdPlayerId) == teamOfPlayer(fourthPlayerId); // 双下：三游末游同队
+
+    // 抗贡：双下时两人共有两张大王，单下时末游有两张大王
+    const int thirdBigJokers = player(thirdPlayerId)->getHandSet().rankCount(Card::Card_BJ);
+    const int fourthBigJokers = player(fourthPlayerId)->getHandSet().rankCount(Card::Card_BJ);
+    const bool canResistTribute = m_doubleDown ? (thirdBigJokers + fourthBigJokers >= 2) : (fourthBigJokers >= 2);
+
+    if (canResistTribute) {
+        // 抗贡成功，头游先出牌
+        pushEvent(Event::TributeResisted);
+        m_currentPlayerId = firstPlayerId;
+        m_circleLeaderId = firstPlayerId;
+        startTurn();
+        return;
+    }
+
+    if (m_doubleDown) {
+        // 双下：两人都要进贡，头游、二游分别还贡
+        m_pendingTributes.append({ thirdPlayerId, firstPlayerId, false });
+        m_pendingTributes.append({ fourthPlayerId, secondPlayerId, false });
+        m_pendingTributes.append({ firstPlayerId, thirdPlayerId, true });
+        m_pendingTributes.append({ secondPlayerId, fourthPlayerId, true });
+    }
+    else {
+        // 单下：末游向头游进贡，头游还贡
+        m_pendingTributes.append({ fourthPlayerId, firstPlayerId, false });
+        m_pendingTributes.append({ firstPlayerId, fourthPlayerId, true });
+    }
+    pushEvent(Event::TributeRequired, -1, 0, m_doubleDown);
+    nextTribute();
+}
+
+void GameEngine::nextTribute()
+{
+    if (m_currentTributeIndex >= m_pendingTributes.size()) {
+        pushEvent(Event::TributeEnded);
+        // 上一局的头游先出牌；双下时由头游的对家(二游)先出
+        m_currentPlayerId = m_doubleDown ? m_lastRoundFinishOrder[1] : m_lastRoundFinishOrder[0];
+        m_circleLeaderId = m_currentPlayerId;
+        startTurn();
+        return;
+    }
+
+    const TributeInfo& tribute = m_pendingTributes[m_currentTributeIndex];
+    m_phase = Phase::Tribute;
+    m_currentPlayerId = tribute.fromPlayerId;
+
+    Event event;
+    event.type = Event::TributeRequested;
+    event.playerId = tribute.fromPlayerId;
+    event.targetId = tribute.toPlayerId;
+    event.flag = tribute.isReturn;
+    m_events.append(event);
+}
+
+void GameEngine::startTurn()
+{
+    m_phase = Phase::Playing;
+    // 新的一圈开始时不能过牌
+    pushEvent(Event::TurnStarted, m_currentPlayerId, 0, m_tableCombo.type != CardComboType::Invalid);
+}
+
+void GameEngine::advance(int lastPlayerId)
+{
+    // 1. 记录出完牌的玩家
+    for (int id = 0; id < PLAYER_COUNT; ++id) {
+        if (m_players[id]->getHandCards().isEmpty() && !m_roundFinishOrder.contains(id)) {
+            m_roundFinishOrder.append(id);
+            m_activePlayersInRound--;
+            pushEvent(Event::PlayerFinished, id, m_roundFinishOrder.size());
+        }
+    }
+
+    // 只剩一名玩家时本局结束，他是末游
+    if (m_activePlayersInRound <= 1) {
+        for (int id = 0; id < PLAYER_COUNT; ++id) {
+            if (!m_roundFinishOrder.contains(id)) {
+                m_roundFinishOrder.append(id);
+                break;
+            }
+        }
+        m_phase = Phase::RoundOver;
+        pushEvent(Event::RoundEnded);
+        return;
+    }
+
+    // 2. 圈结束的条件：(A)其他仍在打牌的玩家都已过牌 (B)刚才行动的玩家出完了牌
+    const bool lastPlayerFinished = !isPlayerInGame(lastPlayerId);
+    const bool allOthersPassed = m_circleLeaderId != -1 && allOtherActivePlayersPassed(m_circleLeaderId);
+    if (allOthersPassed || lastPlayerFinished) {
+        // 圈主仍在打牌时由圈主领出新一圈，否则由刚才行动者的下一位领出
+        const int nextLeaderId = (allOthersPassed && isPlayerInGame(m_circleLeaderId))
+            ? m_circleLeaderId : nextActivePlayer(lastPlayerId);
+        pushEvent(Event::CircleEnded, nextLeaderId);
+        resetTable();
+        m_currentPlayerId = nextLeaderId;
+        m_circleLeaderId = nextLeaderId;
+        startTurn();
+        return;
+    }
+
+    // 3. 圈未结束，轮到下一位玩家
+    m_currentPlayerId = nextActivePlayer(lastPlayerId);
+    startTurn();
+}
+
+void GameEngine::settleRound()
+{
+    if (m_roundFinishOrder.size() != PLAYER_COUNT) {
+        qWarning() << "错误：回合结束时玩家完成顺序数量不正确:" << m_roundFinishOrder.size();
+        return;
+    }
+
+    // 头游所在队伍获胜，按其队友的名次升级
+    const int firstFinisherId = m_roundFinishOrder.first();
+    Team* winningTeam = teamOfPlayer(firstFinisherId);
+    int partnerIndex = -1;
+    for (int i = 1; i < m_roundFinishOrder.size(); ++i) {
+        if (teamOfPlayer(m_roundFinishOrder[i]) == winningTeam) {
+            partnerIndex = i;
+            break;
+        }
+    }
+
+    if (winningTeam && partnerIndex != -1) {
+        const Card::CardPoint oldLevel = m_levelStatus.getTeamPlayingLevel(winningTeam->getId());
+        m_levelStatus.updateLevelsAfterRound(winningTeam->getId(), partnerIndex, *m_teams[0], *m_teams[1]);
+        const Card::CardPoint newLevel = m_levelStatus.getTeamPlayingLevel(winningTeam->getId());
+        pushEvent(Event::LevelsUpdated);
+
+        // 积分 = 升级数 × 基础分 × 倍率
+        const int levelIncrement = static_cast<int>(newLevel) - static_cast<int>(oldLevel);
+        if (levelIncrement > 0) {
+            winningTeam->addScore(levelIncrement * m_roundBaseScore * m_roundDynamicMultiplier);
+            pushEvent(Event::ScoresUpdated);
+        }
+    }
+
+    // 保存本局的名次，用于下一局的进贡判断
+    m_lastRoundFinishOrder = m_roundFinishOrder;
+    Event settled;
+    settled.type = Event::RoundSettled;
+    settled.value = m_roundNumber;
+    settled.order = m_roundFinishOrder;
+    m_events.append(settled);
+
+    if (m_levelStatus.isGameOver()) {
+        m_phase = Phase::GameOver;
+        pushEvent(Event::GameOver, -1, m_levelStatus.getGameWinnerTeamId());
+        return;
+    }
+
+    m_roundNumber++;
+    beginRound();
+}
+
+// ==================== 辅助 ====================
+
+int GameEngine::nextActivePlayer(int playerId) const
+{
+    // 固定顺序：0,1,2,3,0,...，跳过已经出完牌的玩家
+    int nextId = (playerId + 1) % PLAYER_COUNT;
+    while (!isPlayerInGame(nextId) && m_activePlayersInRound > 1) {
+        nextId = (nextId + 1) % PLAYER_COUNT;
+    }
+    return nextId;
+}
+
+bool GameEngine::allOtherActivePlayersPassed(int leaderId) const
+{
+    for (int id = 0; id < PLAYER_COUNT; ++id) {
+        if (id != leaderId && isPlayerInGame(id) && !m_passedPlayersInCircle.contains(id)) {
+            return false;
+        }
+    }
+    return true;
+}
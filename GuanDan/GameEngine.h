@@ -0,0 +1,193 @@
+#ifndef GAMEENGINE_H
+#define GAMEENGINE_H
+
+// GameEngine: 掼蛋规则的同步状态机，只依赖QtCore，不涉及界面、定时器和音效
+// 发牌、进贡/还贡、出牌过牌和一局结束后的结算都在step(action)中立即完成，legalActions()给出当前可以执行的动作
+// 每次状态变化记录为一个事件，调用者用takeEvents()取出：GD_Controller据此发出界面信号并安排动画延时，
+// 无界面的自对弈直接丢弃事件，对局可以远快于实时地进行
+// 引擎操作外部传入的Player和Team对象：手牌保存在Player中，级牌和积分保存在Team中
+
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include "Card.h"
+#include "Cardcombo.h"
+#include "Levelstatus.h"
+#include "RngStream.h"
+
+class Player;
+class Team;
+
+class GameEngine
+{
+public:
+    static const int PLAYER_COUNT = 4;
+
+    enum class Phase {
+        NotStarted, // 游戏未开始
+        Dealing,    // 等待发牌(Continue)
+        Tribute,    // 等待进贡或还贡(Tribute)
+        Playing,    // 等待出牌或过牌(Play/Pass)
+        RoundOver,  // 一局已分出名次，等待结算(Continue)
+        GameOver    // 整场游戏结束
+    };
+
+    // 玩家或调用者提交的动作
+    struct Action {
+        enum Type {
+            Continue, // 推进发牌、一局结算等不需要玩家选择的步骤
+            Play,     // 出牌
+            Pass,     // 过牌
+            Tribute   // 进贡或还贡一张牌
+        };
+        Type type = Continue;
+        int playerId = -1;
+        QVector<Card> cards;        // Play: 选中的原始手牌；Tribute: 贡牌(一张)
+        CardCombo::ComboInfo combo; // Play: 选定的牌型解释(含癞子时可能有多种)，为Invalid时取第一种
+
+        static Action proceed();
+        static Action play(int playerId, const QVector<Card>& cards,
+            const CardCombo::ComboInfo& combo = CardCombo::ComboInfo());
+        static Action pass(int playerId);
+        static Action tribute(int playerId, const Card& card);
+    };
+
+    struct TributeInfo {
+        int fromPlayerId = -1;
+        int toPlayerId = -1;
+        bool isReturn = false; // 是进贡还是还贡
+    };
+
+    // 状态变化的记录，按发生顺序排列
+    struct Event {
+        enum Type {
+            RoundStarted,      // value: 局数
+            CardsDealt,        // playerId, cards: 发到的手牌
+            TributeRequired,   // flag: 是否双下
+            TributeResisted,   // 抗贡成功
+            TributeRequested,  // playerId: 进贡/还贡者, targetId: 接收者, flag: 是否还贡
+            TributeGiven,      // playerId, targetId, flag同上, cards: 贡牌
+            TributeEnded,      // 进贡阶段结束
+            TurnStarted,       // playerId: 轮到的玩家, flag: 能否过牌
+            Played,            // playerId, combo: 打出的牌型, cards: 原始手牌
+            Passed,            // playerId
+            MultiplierChanged, // value: 本局倍率
+            PlayerFinished,    // playerId, value: 名次(从1开始)
+            CircleEnded,       // playerId: 新一圈的领出者
+            RoundEnded,        // 名次已定，等待结算
+            LevelsUpdated,     // 两队级牌变化
+            ScoresUpdated,     // 两队积分变化
+            RoundSettled,      // value: 局数, order: 本局名次
+            GameOver           // value: 获胜队伍ID
+        };
+        Type type = RoundStarted;
+        int playerId = -1;
+        int targetId = -1;
+        int value = 0;
+        bool flag = false;
+        QVector<Card> cards;
+        QVector<int> order;
+        CardCombo::ComboInfo combo;
+    };
+
+    GameEngine();
+
+    // 传入4名玩家(ID为0~3，已加入队伍)和2支队伍(ID为0、1)，不合要求时返回false
+    bool setup(const QVector<Player*>& players, const QVector<Team*>& teams);
+    void setCardsPerPlayer(int count) { m_cardsPerPlayer = count; } // 每人发牌张数，默认27
+    // 固定比赛种子：之后每次startGame都从该种子开始，发牌和首出逐位相同；未设置时每场比赛随机取种子
+    void setSeed(quint64 seed) { m_seed = seed; m_fixedSeed = true; }
+    quint64 seed() const { return m_seed; } // 当前比赛的种子
+    // 开始整场游戏：级牌回到2、积分清零，进入第一局的发牌阶段
+    void startGame();
+    // 下一次发牌改用给定的各家手牌(按玩家ID下标)，只对一局有效；用于重放记录的对局(见GameRecord)
+    // 仍然照常洗牌，本局随机数流的消耗与原对局相同，首出不变
+    void presetDeal(const QVector<QVector<Card>>& hands) { m_presetHands = hands; }
+
+    // 当前可以执行的全部动作
+    // 出牌阶段按牌型目录列出能组成且压得过桌面的每个抽象牌型，各取一种具体出法(癞子、花色的其他组合不再展开)
+    QVector<Action> legalActions() const;
+    // 执行一个动作，不合法时返回false，error给出原因(面向玩家的提示)
+    bool step(const Action& action, QString* error = nullptr);
+    // 取出并清空自上次调用以来的事件
+    QVector<Event> takeEvents();
+
+    // --- 状态查询 ---
+    Phase phase() const { return m_phase; }
+    int roundNumber() const { return m_roundNumber; }
+    int currentPlayerId() const { return m_currentPlayerId; } // 进贡阶段为进贡/还贡者
+    const CardCombo::ComboInfo& tableCombo() const { return m_tableCombo; }
+    int tableOwnerId() const { return m_circleLeaderId; }     // 桌面牌的出牌者
+    bool hasPassed(int playerId) const { return m_passedPlayersInCircle.contains(playerId); }
+    const QVector<int>& roundFinishOrder() const { return m_roundFinishOrder; }
+    const QVector<int>& lastRoundFinishOrder() const { return m_lastRoundFinishOrder; }
+    const QVector<Card>& playedCards() const { return m_playedCards; }
+    int multiplier() const { return m_roundBaseScore * m_roundDynamicMultiplier; }
+    const LevelStatus& levelStatus() const { return m_levelStatus; }
+    const TributeInfo* currentTribute() const; // 不在进贡阶段时返回nullptr
+    bool isPlayerInGame(int playerId) const { return !m_roundFinishOrder.contains(playerId); }
+    Player* player(int playerId) const;
+    Team* team(int teamId) const;
+    Team* teamOfPlayer(int playerId) const;
+    int handCardCount(int playerId) const;
+
+    // 选中的牌能组成的所有牌型解释(含癞子时可能有多种)，不能出时返回空数组；界面据此让玩家选择
+    QVector<CardCombo::ComboInfo> playInterpretations(int playerId, const QVector<Card>& cards) const;
+
+private:
+    void pushEvent(Event::Type type, int playerId = -1, int value = 0, bool flag = false);
+
+    // --- 流程 ---
+    void beginRound();        // 重置本局状态，进入发牌阶段
+    void dealCards();
+    void chooseFirstPlayer(); // 第一局随机，之后由上一局末游先出
+    void startTribute();
+    void nextTribute();       // 处理下一项进贡/还贡，全部完成后进入出牌阶段
+    void startTurn();         // 进入出牌阶段(或继续)，轮到m_currentPlayerId
+    void advance(int lastPlayerId); // 出牌或过牌之后推进：名次、圈结束、下一位玩家
+    void settleRound();       // 升级、计分，开始下一局或结束游戏
+
+    // --- 动作 ---
+    bool applyPlay(const Action& action, QString* error);
+    bool applyPass(const Action& action, QString* error);
+    bool applyTribute(const Action& action, QString* error);
+    bool tributeCardAllowed(const TributeInfo& tribute, const Card& card, QString* error) const;
+
+    // --- 辅助 ---
+    int nextActivePlayer(int playerId) const;
+    bool allOtherActivePlayersPassed(int leaderId) const;
+    void resetTable();
+
+    QVector<Player*> m_players; // 按ID下标
+    Team* m_teams[2] = { nullptr, nullptr };
+    LevelStatus m_levelStatus;
+    int m_cardsPerPlayer = 27;
+    quint64 m_seed = 0;
+    bool m_fixedSeed = false;
+    RngStream m_matchRng;               // 比赛的随机数流，每局由它分出一条子流
+    RngStream m_roundRng;               // 本局的随机数流：洗牌和首出
+    QVector<QVector<Card>> m_presetHands; // presetDeal给定的下一局手牌
+
+    Phase m_phase = Phase::NotStarted;
+    int m_roundNumber = 0;
+    int m_currentPlayerId = -1;
+    CardCombo::ComboInfo m_tableCombo;  // 当前桌面上最后一手牌
+    int m_circleLeaderId = -1;          // 桌面牌的出牌者
+    QSet<int> m_passedPlayersInCircle;  // 本圈已经过牌的玩家
+    QVector<int> m_roundFinishOrder;    // 本局出完牌的玩家，按名次
+    QVector<int> m_lastRoundFinishOrder; // 上一局的名次，用于进贡和决定首出
+    int m_activePlayersInRound = 0;
+    QVector<Card> m_playedCards;        // 本局已打出的牌
+
+    QVector<TributeInfo> m_pendingTributes;
+    int m_currentTributeIndex = 0;
+    bool m_doubleDown = false;          // 上一局是否双下(决定进贡后谁先出)
+
+    int m_roundBaseScore = 1;           // 本局基础分
+    int m_roundDynamicMultiplier = 1;   // 本局动态倍率，每个炸弹翻倍
+
+    QVector<Event> m_events;
+};
+
+#endif // GAMEENGINE_H
@@ -0,0 +1,354 @@
+#include "GameRecord.h"
+
+#include <QDebug>
+#include <QIODevice>
+#include <cstring>
+
+namespace {
+
+    struct Crc32Table {
+        quint32 values[256];
+    };
+
+    constexpr Crc32Table makeCrc32Table()
+    {
+        Crc32Table table{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table.values[i] = c;
+        }
+        return table;
+    }
+
+    constexpr Crc32Table kCrc32Table = makeCrc32Table();
+
+} // namespace
+
+Card GameRecord::cardOfFace(int face)
+{
+    if (face == 52) return Card(Card::Card_LJ, Card::Joker);
+    if (face == 53) return Card(Card::Card_BJ, Card::Joker);
+    return Card(static_cast<Card::CardPoint>(face / 4 + Card::Card_2), static_cast<Card::CardSuit>(face % 4));
+}
+
+quint32 GameRecord::crc32(quint32 crc, const uchar* data, int size)
+{
+    crc = ~crc;
+    for (int i = 0; i < size; ++i) {
+        crc = kCrc32Table.values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// ==================== GameRecordWriter ====================
+
+GameRecordWriter::GameRecordWriter(QIODevice* device)
+    : m_device(device)
+{
+    std::memset(m_faceDealt, 0, sizeof(m_faceDealt));
+    std::memset(m_handSizes, 0, sizeof(m_handSizes));
+}
+
+GameRecordWriter::~GameRecordWriter()
+{
+    flush();
+}
+
+void GameRecordWriter::setDevice(QIODevice* device)
+{
+    flush();
+    m_device = device;
+    m_inRound = false; // 新设备从下一场比赛或下一局开始记录
+}
+
+void GameRecordWriter::beginMatch(quint64 seed, int cardsPerPlayer)
+{
+    using namespace GameRecord;
+    m_inRound = false;
+    uchar* p = beginRecord(MatchStart, 14);
+    if (!p) return;
+    putU32(p, kMagic);
+    p[4] = kVersion;
+    putU64(p + 5, seed);
+    p[13] = quint8(cardsPerPlayer);
+    endRecord();
+}
+
+void GameRecordWriter::beginRound(int roundNumber, Card::CardPoint team0Level, Card::CardPoint team1Level)
+{
+    using namespace GameRecord;
+    std::memset(m_faceDealt, 0, sizeof(m_faceDealt));
+    std::memset(m_handSizes, 0, sizeof(m_handSizes));
+    uchar* p = beginRecord(RoundStart, 4);
+    m_inRound = p != nullptr;
+    if (!p) return;
+    putU16(p, quint16(roundNumber));
+    p[2] = quint8(team0Level);
+    p[3] = quint8(team1Level);
+    endRecord();
+}
+
+void GameRecordWriter::deal(int playerId, const QVector<Card>& hand)
+{
+    using namespace GameRecord;
+    if (!m_inRound) return;
+    if (playerId < 0 || playerId >= PLAYER_COUNT || hand.size() >= kMaxHandCards) {
+        loseSync("发牌的玩家或张数超出范围");
+        return;
+    }
+
+    const int bytes = (hand.size() * 7 + 7) / 8;
+    uchar* p = beginRecord(Deal, 2 + bytes);
+    if (!p) return;
+    p[0] = quint8(playerId);
+    p[1] = quint8(hand.size());
+    std::memset(p + 2, 0, bytes);
+
+    m_handSizes[playerId] = 0;
+    for (int i = 0; i < hand.size(); ++i) {
+        const int face = faceOf(hand[i]);
+        if (m_faceDealt[face] >= 2) {
+            loseSync("同一种牌发出超过两张");
+            return;
+        }
+        const quint8 id = quint8(face + kFaceCount * m_faceDealt[face]++);
+        packId(p + 2, i, id);
+        insertCard(playerId, id);
+    }
+    endRecord();
+}
+
+void GameRecordWriter::tribute(int fromPlayerId, int toPlayerId, bool isReturn, const Card& card)
+{
+    using namespace GameRecord;
+    if (!m_inRound) return;
+    if (fromPlayerId < 0 || fromPlayerId >= PLAYER_COUNT || toPlayerId < 0 || toPlayerId >= PLAYER_COUNT) {
+        loseSync("进贡的玩家超出范围");
+        return;
+    }
+    const int index = findCard(fromPlayerId, faceOf(card), 0);
+    if (index < 0) {
+        loseSync("贡牌不在记录的手牌中");
+        return;
+    }
+
+    const quint8 id = m_hands[fromPlayerId][index];
+    uchar* p = beginRecord(Tribute, 2);
+    if (!p) return;
+    p[0] = quint8(fromPlayerId | toPlayerId << 2 | (isReturn ? 1 : 0) << 4);
+    p[1] = id;
+    endRecord();
+
+    removeCards(fromPlayerId, 1u << index);
+    if (!insertCard(toPlayerId, id)) loseSync("接收者手牌超过位掩码的宽度");
+}
+
+void GameRecordWriter::play(int playerId, const QVector<Card>& cards, const CardCombo::ComboInfo& combo)
+{
+    using namespace GameRecord;
+    if (!m_inRound) return;
+    if (playerId < 0 || playerId >= PLAYER_COUNT) {
+        loseSync("出牌的玩家超出范围");
+        return;
+    }
+
+    // 每张牌取手牌中尚未选中的第一张同种牌(编号较小的一张)
+    quint32 mask = 0;
+    for (const Card& card : cards) {
+        const int index = findCard(playerId, faceOf(card), mask);
+        if (index < 0) {
+            loseSync("打出的牌不在记录的手牌中");
+            return;
+        }
+        mask |= 1u << index;
+    }
+
+    uchar* p = beginRecord(Play, 10);
+    if (!p) return;
+    p[0] = quint8(playerId | qBound(0, combo.wild_cards_used, 3) << 2);
+    p[1] = quint8(combo.type);
+    putU32(p + 2, mask);
+    putU32(p + 6, quint32(combo.level));
+    endRecord();
+
+    removeCards(playerId, mask);
+}
+
+void GameRecordWriter::pass(int playerId)
+{
+    if (!m_inRound) return;
+    uchar* p = beginRecord(GameRecord::Pass, 1);
+    if (!p) return;
+    p[0] = quint8(playerId);
+    endRecord();
+}
+
+void GameRecordWriter::endRound(const QVector<int>& finishOrder)
+{
+    if (!m_inRound) return;
+    m_inRound = false;
+    uchar* p = beginRecord(GameRecord::RoundEnd, 1);
+    if (!p) return;
+    quint8 packed = 0;
+    for (int i = 0; i < finishOrder.size() && i < PLAYER_COUNT; ++i) {
+        packed |= quint8((finishOrder[i] & 3) << (2 * i));
+    }
+    p[0] = packed;
+    endRecord();
+    flush(); // 每局结束时落盘，中途退出最多丢失正在进行的一局
+}
+
+void GameRecordWriter::endMatch(int winningTeamId)
+{
+    m_inRound = false;
+    uchar* p = beginRecord(GameRecord::MatchEnd, 1);
+    if (!p) return;
+    p[0] = quint8(winningTeamId);
+    endRecord();
+    flush();
+}
+
+void GameRecordWriter::flush()
+{
+    if (!m_device || m_recordsSinceChecksum == 0) return;
+    writeChecksum();
+    if (m_device->write(reinterpret_cast<const char*>(m_buffer), m_used) != m_used) {
+        qWarning() << "GameRecordWriter: 写入对局记录失败，停止记录:" << m_device->errorString();
+        m_device = nullptr;
+        m_inRound = false;
+    }
+    m_used = 0;
+}
+
+// ==================== 内部实现 ====================
+
+uchar* GameRecordWriter::beginRecord(GameRecord::RecordType type, int payloadSize)
+{
+    if (!m_device) return nullptr;
+    // 本条记录和随后的校验记录都要放得下，否则先把缓冲交给设备
+    if (m_used + 2 + payloadSize + 8 > kBufferSize || m_recordsSinceChecksum >= GameRecord::kChecksumInterval) {
+        flush();
+        if (!m_device) return nullptr;
+    }
+    m_buffer[m_used] = quint8(payloadSize);
+    m_buffer[m_used + 1] = type;
+    return m_buffer + m_used + 2;
+}
+
+void GameRecordWriter::endRecord()
+{
+    m_used += 2 + m_buffer[m_used];
+    ++m_recordsSinceChecksum;
+}
+
+void GameRecordWriter::writeChecksum()
+{
+    // 缓冲中只有上一条校验记录之后的数据，整段计算
+    const quint32 crc = GameRecord::crc32(0, m_buffer, m_used);
+    uchar* p = m_buffer + m_used;
+    p[0] = 6;
+    p[1] = GameRecord::Checksum;
+    GameRecord::putU32(p + 2, crc);
+    GameRecord::putU16(p + 6, quint16(m_used));
+    m_used += 8;
+    m_recordsSinceChecksum = 0;
+}
+
+int GameRecordWriter::findCard(int playerId, int face, quint32 excludeMask) const
+{
+    for (int i = 0; i < m_handSizes[playerId]; ++i) {
+        if (GameRecord::faceOfId(m_hands[playerId][i]) == face && !(excludeMask & (1u << i))) return i;
+    }
+    return -1;
+}
+
+void GameRecordWriter::removeCards(int playerId, quint32 mask)
+{
+    int kept = 0;
+    for (int i = 0; i < m_handSizes[playerId]; ++i) {
+        if (!(mask & (1u << i))) m_hands[playerId][kept++] = m_hands[playerId][i];
+    }
+    m_handSizes[playerId] = kept;
+}
+
+bool GameRecordWriter::insertCard(int playerId, quint8 id)
+{
+    int& size = m_handSizes[playerId];
+    if (size >= GameRecord::kMaxHandCards) return false;
+    int i = size++;
+    for (; i > 0 && m_hands[playerId][i - 1] > id; --i) {
+        m_hands[playerId][i] = m_hands[playerId][i - 1];
+    }
+    m_hands[playerId][i] = id;
+    return true;
+}
+
+void GameRecordWriter::loseSync(const char* reason)
+{
+    qWarning() << "GameRecordWriter: 记录的手牌与对局不一致，本局不再记录:" << reason;
+    m_inRound = false;
+}
+
+// ==================== GameRecordReader ====================
+
+GameRecordReader::GameRecordReader(const QByteArray& data)
+    : m_data(data)
+    , m_bytes(reinterpret_cast<const uchar*>(m_data.constData()))
+    , m_size(m_data.size())
+{
+}
+
+bool GameRecordReader::next(Record& record)
+{
+    for (;;) {
+        if (m_pos == m_segmentEnd) {
+            // 跳过本段的校验记录
+            m_pos += 2 + m_bytes[m_pos];
+            m_segmentEnd = -1;
+        }
+        if (m_pos >= m_size) return false;
+        if (m_segmentEnd < 0 && !openSegment()) {
+            m_unverifiedBytes = m_size - m_pos;
+            m_pos = m_size;
+            return false;
+        }
+        if (m_segmentEnd < 0) continue; // 本段校验失败，已跳过
+
+        record.size = m_bytes[m_pos];
+        record.type = static_cast<GameRecord::RecordType>(m_bytes[m_pos + 1]);
+        record.payload = m_bytes + m_pos + 2;
+        record.offset = m_pos;
+        record.afterGap = m_gap;
+        m_gap = false;
+        m_pos += 2 + record.size;
+        return true;
+    }
+}
+
+bool GameRecordReader::openSegment()
+{
+    qint64 pos = m_pos;
+    while (pos + 2 <= m_size && pos + 2 + m_bytes[pos] <= m_size) {
+        if (m_bytes[pos + 1] != GameRecord::Checksum) {
+            pos += 2 + m_bytes[pos];
+            continue;
+        }
+        const qint64 length = pos - m_pos;
+        const bool valid = m_bytes[pos] == 6 && length <= 0xFFFF
+            && GameRecord::getU16(m_bytes + pos + 6) == length
+            && GameRecord::getU32(m_bytes + pos + 2) == GameRecord::crc32(0, m_bytes + m_pos, int(length));
+        if (valid) {
+            m_segmentEnd = pos;
+        }
+        else {
+            ++m_corruptSegments;
+            m_gap = true;
+            m_pos = pos + 2 + m_bytes[pos];
+        }
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,169 @@
+#ifndef GAMERECORD_H
+#define GAMERECORD_H
+
+// GameRecord: 整场比赛的紧凑二进制记录(发牌、进贡/还贡、每次出牌和过牌)
+// 记录流只追加，由一条条长度前缀的记录组成：[载荷长度 u8][类型 u8][载荷]，多字节整数均为小端
+// 每场比赛以MatchStart开头(含魔数和版本)，多场比赛的记录可以直接拼接在同一个文件中
+// 牌的编号为7位：点数花色的序号(0~53，见faceOf)，同一局中第二次发出的同种牌再加54，一局的108张牌编号各不相同
+// 出牌记为该玩家当前手牌的位掩码：手牌按编号升序排列，第i位表示打出第i张；同时记下牌型、等级和使用的癞子数，供重放核对
+// 每隔kChecksumInterval条记录以及每局、每场结束时写一条Checksum记录：上一条校验记录之后全部字节的CRC-32和字节数，
+// 写入中断时读取者可以丢弃最后一段不完整的数据
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include "Card.h"
+#include "Cardcombo.h"
+
+class QIODevice;
+
+namespace GameRecord {
+
+    const quint32 kMagic = 0x43524447;   // "GDRC"
+    const quint8 kVersion = 1;
+    const int kFaceCount = 54;           // 52张普通牌和大小王
+    const int kMaxHandCards = 32;        // 位掩码的宽度；手牌最多27张，进贡时暂时多1张
+    const int kChecksumInterval = 64;    // 两条校验记录之间最多的记录数
+
+    enum RecordType : quint8 {
+        MatchStart = 1, // 魔数u32、版本u8、比赛种子u64、每人发牌张数u8
+        RoundStart,     // 局数u16、0队级牌u8、1队级牌u8
+        Deal,           // 玩家u8、张数u8、各张牌的7位编号(按位紧密排列)
+        Tribute,        // 进贡者|接收者<<2|是否还贡<<4 (u8)、牌的编号u8
+        Play,           // 玩家|癞子数<<2 (u8)、牌型u8、手牌位掩码u32、牌型等级i32
+        Pass,           // 玩家u8
+        RoundEnd,       // 名次(每名2位，第1名在最低位) u8
+        MatchEnd,       // 获胜队伍u8
+        Checksum        // CRC-32 u32、覆盖的字节数u16
+    };
+
+    // 点数花色的序号：普通牌为(点数-2)*4+花色，小王52，大王53
+    inline int faceOf(const Card& card)
+    {
+        if (card.point() == Card::Card_LJ) return 52;
+        if (card.point() == Card::Card_BJ) return 53;
+        return (card.point() - Card::Card_2) * 4 + card.suit();
+    }
+    Card cardOfFace(int face);
+    inline int faceOfId(int id) { return id >= kFaceCount ? id - kFaceCount : id; }
+
+    // CRC-32(IEEE 802.3)，crc为之前各段的结果，首段传0
+    quint32 crc32(quint32 crc, const uchar* data, int size);
+
+    inline void putU16(uchar* p, quint16 v) { p[0] = uchar(v); p[1] = uchar(v >> 8); }
+    inline void putU32(uchar* p, quint32 v) { putU16(p, quint16(v)); putU16(p + 2, quint16(v >> 16)); }
+    inline void putU64(uchar* p, quint64 v) { putU32(p, quint32(v)); putU32(p + 4, quint32(v >> 32)); }
+    inline quint16 getU16(const uchar* p) { return quint16(p[0] | p[1] << 8); }
+    inline quint32 getU32(const uchar* p) { return getU16(p) | quint32(getU16(p + 2)) << 16; }
+    inline quint64 getU64(const uchar* p) { return getU32(p) | quint64(getU32(p + 4)) << 32; }
+
+    // Deal记录中第index张牌的7位编号(低位在前，跨字节时取相邻两字节)，packed须已清零再写入
+    inline void packId(uchar* packed, int index, quint8 id)
+    {
+        const int bit = index * 7;
+        const int value = id << (bit % 8);
+        packed[bit / 8] |= uchar(value);
+        if (bit % 8 > 1) packed[bit / 8 + 1] |= uchar(value >> 8);
+    }
+    inline quint8 unpackId(const uchar* packed, int index)
+    {
+        const int bit = index * 7;
+        int value = packed[bit / 8];
+        if (bit % 8 > 1) value |= packed[bit / 8 + 1] << 8;
+        return quint8(value >> (bit % 8) & 0x7F);
+    }
+
+} // namespace GameRecord
+
+// GameRecordWriter: 把对局写成GameRecord记录流
+// 记录先写入定长的内部缓冲，每次写校验记录时整段交给设备；各玩家的手牌按编号保存在定长数组中，
+// 出牌、过牌和进贡都不分配内存，可以在正式对局中一直开启
+// 记录的手牌与实际不一致(如中途才开始记录)时，本局余下的动作不再记录，直到下一局开始
+class GameRecordWriter
+{
+public:
+    explicit GameRecordWriter(QIODevice* device = nullptr);
+    ~GameRecordWriter();
+
+    // 设备须已以写入(追加)方式打开；更换设备前先把缓冲写入旧设备；传入nullptr停止记录
+    void setDevice(QIODevice* device);
+    QIODevice* device() const { return m_device; }
+    bool isRecording() const { return m_device != nullptr; }
+
+    void beginMatch(quint64 seed, int cardsPerPlayer);
+    void beginRound(int roundNumber, Card::CardPoint team0Level, Card::CardPoint team1Level);
+    void deal(int playerId, const QVector<Card>& hand);
+    void tribute(int fromPlayerId, int toPlayerId, bool isReturn, const Card& card);
+    void play(int playerId, const QVector<Card>& cards, const CardCombo::ComboInfo& combo);
+    void pass(int playerId);
+    void endRound(const QVector<int>& finishOrder);
+    void endMatch(int winningTeamId);
+
+    // 写一条校验记录并把缓冲交给设备
+    void flush();
+
+private:
+    static const int kBufferSize = 4096;
+    static const int PLAYER_COUNT = 4;
+
+    // 在缓冲中预留一条记录，返回载荷的起始位置；不在记录状态时返回nullptr
+    uchar* beginRecord(GameRecord::RecordType type, int payloadSize);
+    void endRecord();
+    void writeChecksum();
+    // playerId手牌中第一张该种牌(不含excludeMask中已选的)的下标，找不到时返回-1
+    int findCard(int playerId, int face, quint32 excludeMask) const;
+    void removeCards(int playerId, quint32 mask);
+    bool insertCard(int playerId, quint8 id); // 按编号有序插入，手牌已满时返回false
+    void loseSync(const char* reason);
+
+    QIODevice* m_device = nullptr;
+    uchar m_buffer[kBufferSize];
+    int m_used = 0;
+    int m_recordsSinceChecksum = 0;
+
+    bool m_inRound = false;                          // 本局手牌已记录且与实际一致
+    quint8 m_faceDealt[GameRecord::kFaceCount];      // 本局每种牌已发出的张数(0~2)
+    quint8 m_hands[PLAYER_COUNT][GameRecord::kMaxHandCards]; // 各玩家手牌的编号，升序
+    int m_handSizes[PLAYER_COUNT];
+};
+
+// GameRecordReader: 按顺序读出记录流中的记录(不含校验记录)
+// 每段数据先用其后的校验记录核对，通过后才交出其中的记录；核对失败的段整段跳过，
+// 其后交出的第一条记录标记afterGap，调用者应放弃进行中的比赛，从下一条MatchStart重新开始
+// 末尾没有校验记录的数据(写入中断)不交出，记入unverifiedBytes
+class GameRecordReader
+{
+public:
+    struct Record {
+        GameRecord::RecordType type = GameRecord::MatchStart;
+        const uchar* payload = nullptr; // 指向读取者持有的数据，读取者存在期间有效
+        int size = 0;
+        qint64 offset = 0;              // 记录在流中的位置
+        bool afterGap = false;          // 之前有数据段因校验失败被跳过
+    };
+
+    explicit GameRecordReader(const QByteArray& data);
+
+    // 读出下一条记录，数据读完时返回false
+    bool next(Record& record);
+
+    int corruptSegments() const { return m_corruptSegments; }
+    qint64 unverifiedBytes() const { return m_unverifiedBytes; }
+
+private:
+    // 从m_pos开始找到本段的校验记录并核对，设置m_segmentEnd；找不到校验记录时返回false
+    bool openSegment();
+
+    const QByteArray m_data; // 隐式共享，不复制数据
+    const uchar* m_bytes = nullptr;
+    qint64 m_size = 0;
+    qint64 m_pos = 0;
+    qint64 m_segmentEnd = -1;  // 本段校验记录的位置，-1表示需要打开新的一段
+    bool m_gap = false;
+    int m_corruptSegments = 0;
+    qint64 m_unverifiedBytes = 0;
+};
+
+#endif // GAMERECORD_H
@@ -346,15 +346,12 @@ void GuanDan::setupConnections()
             }
         });
 
-    // 当玩家出牌或过牌后更新手牌显示
-    connect(m_gameController, &GD_Controller::sigUpdatePlayerHand,
-        this, [this](int playerId, const QVector<Card>& cards) {
-            qDebug() << "收到玩家手牌更新信号(无动画) - 玩家ID:" << playerId << "牌数:" << cards.size();
+    // 手牌增量变化(出牌、进贡/还贡)时只更新变化的牌
+    connect(m_gameController, &GD_Controller::sigPlayerHandChanged,
+        this, [this](int playerId, const QVector<Card>& added, const QVector<Card>& removed) {
             for (PlayerAreaWidget* widget : m_playerWidgets) {
                 if (widget->getPlayer() && widget->getPlayer()->getID() == playerId) {
-                    widget->updateHandDisplayNoAnimation(cards, widget->getPlayer()->getID() == 0);
-                    // 明确命令刷新玩家信息（如剩余牌数）
-                    widget->getPlayerWidget()->updatePlayerInfo();
+                    widget->applyHandDelta(added, removed, widget->getPlayer()->getID() == 0);
                     break;
                 }
             }
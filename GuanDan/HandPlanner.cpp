@@ -0,0 +1,174 @@
+#include "HandPlanner.h"
+
+#include <cstring>
+
+namespace {
+
+    const int kAceIndex = 12; // Card_A 的点数下标
+    const int kLJIndex = 13;
+    const int kBJIndex = 14;
+
+    // 连续牌型的 (每个点数的张数, 连续点数个数)：顺子、连对、钢板
+    const int kSequenceShapes[3][2] = { { 1, 5 }, { 2, 3 }, { 3, 2 } };
+
+    // 顺序值(A最小为1，A最大为14)转换为点数下标
+    int rankIndexFromOrder(int order)
+    {
+        return (order == 1 || order == 14) ? kAceIndex : order - 2;
+    }
+
+    bool isJokerIndex(int r) { return r >= kLJIndex; }
+
+} // namespace
+
+HandPlanner::HandPlanner(const LevelContext& ctx, int maxStates)
+    : m_ctx(ctx)
+    , m_maxStates(maxStates)
+    , m_timedOut(false)
+    , m_expanded(0)
+{
+}
+
+int HandPlanner::minimumHands(const CardSet& hand)
+{
+    State state;
+    std::memset(state.counts, 0, sizeof(state.counts));
+    state.wilds = hand.wildCount(m_ctx);
+    for (int r = 0; r < CardSet::RANK_COUNT; ++r) {
+        const Card::CardPoint point = CardSet::rankAt(r);
+        int n = hand.rankCount(point);
+        if (point == m_ctx.levelRank()) n -= state.wilds;
+        state.counts[r] = static_cast<quint8>(n);
+    }
+    return solve(state);
+}
+
+quint64 HandPlanner::keyOf(const State& state)
+{
+    // 每个点数4位(两副牌同点数最多8张)，癞子数放在最高的几位
+    quint64 key = 0;
+    for (int r = 0; r < CardSet::RANK_COUNT; ++r) {
+        key |= static_cast<quint64>(state.counts[r]) << (4 * r);
+    }
+    key |= static_cast<quint64>(state.wilds) << 60;
+    return key;
+}
+
+int HandPlanner::estimate(const State& state) const
+{
+    // 每个点数单独出一手；癞子并入任一非王点数，只剩王时癞子单独出一手
+    int hands = 0;
+    bool hasNonJoker = false;
+    for (int r = 0; r < CardSet::RANK_COUNT; ++r) {
+        if (!state.counts[r]) continue;
+        ++hands;
+        if (!isJokerIndex(r)) hasNonJoker = true;
+    }
+    if (state.wilds > 0 && !hasNonJoker) ++hands;
+    return hands;
+}
+
+void HandPlanner::consider(State& state, int& best)
+{
+    const int hands = 1 + solve(state);
+    if (hands < best) best = hands;
+}
+
+int HandPlanner::solve(State& state)
+{
+    // 最小的有牌点数，没有普通牌时只剩癞子(一手打完)
+    int low = 0;
+    while (low < CardSet::RANK_COUNT && state.counts[low] == 0) ++low;
+    if (low == CardSet::RANK_COUNT) return state.wilds > 0 ? 1 : 0;
+
+    const quint64 key = keyOf(state);
+    auto cached = m_memo.constFind(key);
+    if (cached != m_memo.constEnd()) return cached.value();
+
+    // 超出上限后不再展开，直接返回估计值
+    if (!m_timedOut && ++m_expanded > m_maxStates) {
+        m_timedOut = true;
+    }
+    int best = estimate(state);
+    if (m_timedOut || best <= 1) return best;
+
+    const int c = state.counts[low];
+    const bool joker = isJokerIndex(low);
+
+    // 1. 最小点数整组打出(单张/对子/三条/炸弹)，可并入癞子
+    for (int w = 0; w <= (joker ? 0 : state.wilds); ++w) {
+        State next = state;
+        next.counts[low] = 0;
+        next.wilds -= w;
+        consider(next, best);
+    }
+
+    // 天王炸
+    if (low == kLJIndex && state.counts[kLJIndex] == 2 && state.counts[kBJIndex] == 2) {
+        State next = state;
+        next.counts[kLJIndex] = 0;
+        next.counts[kBJIndex] = 0;
+        consider(next, best);
+    }
+
+    // 2. 三带二：最小点数作三条(可用癞子补)，或作对子(可用癞子补)
+    // 为控制分支数，另一部分只取恰好成对/成三条的点数(或差一张由癞子补)，不拆更大的组
+    if (!joker) {
+        for (int tw = 0; tw <= qMin(2, state.wilds); ++tw) {
+            const int take = 3 - tw;
+            if (take < 1 || c != take) continue;
+            for (int p = low + 1; p < CardSet::RANK_COUNT; ++p) {
+                for (int pw = 0; pw <= qMin(1, state.wilds - tw); ++pw) {
+                    if (state.counts[p] != 2 - pw || (pw > 0 && isJokerIndex(p))) continue;
+                    State next = state;
+                    next.counts[low] = static_cast<quint8>(c - take);
+                    next.counts[p] = static_cast<quint8>(next.counts[p] - (2 - pw));
+                    next.wilds -= tw + pw;
+                    consider(next, best);
+                }
+            }
+        }
+    }
+    for (int pw = 0; pw <= qMin(1, state.wilds); ++pw) {
+        const int take = 2 - pw;
+        if (c != take || (pw > 0 && joker)) continue;
+        for (int t = low + 1; t <= kAceIndex; ++t) {
+            for (int tw = 0; tw <= qMin(2, state.wilds - pw); ++tw) {
+                if (state.counts[t] != 3 - tw || 3 - tw < 1) continue;
+                State next = state;
+                next.counts[low] = static_cast<quint8>(c - take);
+                next.counts[t] = static_cast<quint8>(next.counts[t] - (3 - tw));
+                next.wilds -= tw + pw;
+                consider(next, best);
+            }
+        }
+    }
+
+    // 3. 包含最小点数的顺子、连对、钢板，缺口用癞子补齐
+    if (!joker) {
+        const int orders[2] = { low == kAceIndex ? 1 : low + 2, low == kAceIndex ? 14 : -1 };
+        for (int shape = 0; shape < 3; ++shape) {
+            const int width = kSequenceShapes[shape][0];
+            const int length = kSequenceShapes[shape][1];
+            for (int order : orders) {
+                if (order < 0) continue;
+                for (int top = qMax(order, length); top <= qMin(14, order + length - 1); ++top) {
+                    State next = state;
+                    int wildsNeeded = 0;
+                    for (int o = top - length + 1; o <= top; ++o) {
+                        const int r = rankIndexFromOrder(o);
+                        const int take = qMin(width, static_cast<int>(next.counts[r]));
+                        next.counts[r] = static_cast<quint8>(next.counts[r] - take);
+                        wildsNeeded += width - take;
+                    }
+                    if (wildsNeeded > state.wilds) continue;
+                    next.wilds -= wildsNeeded;
+                    consider(next, best);
+                }
+            }
+        }
+    }
+
+    if (!m_timedOut) m_memo.insert(key, best);
+    return best;
+}
@@ -0,0 +1,47 @@
+#ifndef HANDPLANNER_H
+#define HANDPLANNER_H
+
+// HandPlanner: 计算把一手牌出完最少需要几手(不考虑对手)，供AI领出时评估"出哪手牌后剩余的牌最好走"
+// 状态为各点数的普通牌张数加癞子数，打包成64位键做记忆化；花色不参与(同花顺按普通顺子计)
+// 每次递归只枚举包含最小点数的出法，避免同一组拆分以不同顺序被重复搜索
+// 设有展开状态数的上限，超出后剩余状态改用只按点数分组的快速估计，保证每回合都能很快返回
+// 上限按状态数而不按时间计：结果与机器快慢和负载无关，同一局面总是得到同样的规划(对局可以重放)
+
+#include <QHash>
+#include <QtGlobal>
+
+#include "CardSet.h"
+#include "LevelContext.h"
+
+class HandPlanner
+{
+public:
+    // maxStates: 本次决策最多展开的状态数，多次调用 minimumHands 共用同一计数和记忆表
+    explicit HandPlanner(const LevelContext& ctx, int maxStates = 8192);
+
+    // 出完该手牌最少需要的手数(空手牌为0)
+    int minimumHands(const CardSet& hand);
+
+    // 是否已超出状态数上限(此后的结果为估计值)
+    bool timedOut() const { return m_timedOut; }
+    int expandedStates() const { return m_expanded; }
+
+private:
+    struct State {
+        quint8 counts[CardSet::RANK_COUNT]; // 各点数的普通牌张数(不含癞子)
+        int wilds;                          // 癞子张数
+    };
+
+    static quint64 keyOf(const State& state);
+    int solve(State& state);
+    int estimate(const State& state) const; // 只按点数分组的快速估计(不小于真实值)
+    void consider(State& state, int& best);  // 在state上继续搜索并更新best(调用前已出掉一手)
+
+    LevelContext m_ctx;
+    int m_maxStates;
+    bool m_timedOut;
+    int m_expanded;
+    QHash<quint64, int> m_memo;
+};
+
+#endif // HANDPLANNER_H
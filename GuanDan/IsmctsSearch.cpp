@@ -0,0 +1,284 @@
+#include "IsmctsSearch.h"
+
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QDebug>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+#include "RngStream.h"
+
+namespace {
+
+    const int kMaxChildren = 24;       // 每个节点最多的子节点数(各次确定化中出现过的走法)
+    const int kMaxPathLength = 128;    // 单次迭代在树中最多下降的层数
+    const int kPassMove = -1;          // 过牌的走法编号(根以下各层)
+    const double kExploration = 0.7;   // UCB探索系数(得分已归一化到[0,1])
+    const qint64 kScoreScale = 1000;   // 累计得分按千分之一升级数存放为整数
+    const qint64 kVirtualLoss = 3 * kScoreScale; // 虚拟损失：下降时先按最差结果计入，回传时补回
+
+    // 树节点：统计量均为原子量，子节点只追加不删除
+    struct Node {
+        int move = 0;                          // 根的子节点为候选下标，其余为目录项下标或kPassMove
+        int seat = -1;                         // 走这一步的座位，得分从该座位所在队伍看
+        std::atomic<int> visits{ 0 };
+        std::atomic<int> availability{ 0 };    // 该走法合法并参与选择的次数
+        std::atomic<qint64> reward{ 0 };
+        std::atomic<int> childCount{ 0 };
+        std::atomic_flag expanding = ATOMIC_FLAG_INIT;
+        Node* children[kMaxChildren];
+    };
+
+    // 所有工作线程共享的搜索数据
+    struct SearchShared {
+        SearchShared(Card::CardPoint levelRank, int budgetMs) : ctx(levelRank), budget(budgetMs) {}
+
+        const Rollout::Situation* situation;
+        const QVector<Rollout::Candidate>* candidates;
+        const ComboCatalog* catalog;
+        LevelContext ctx;
+        Rollout::SimState base;
+        QVector<Card> unseen;
+        QVector<ComboCatalog::HandCounts> handsAfter;  // 每个候选出牌后决策者的手牌
+        Rollout::SearchBudget budget;
+        const std::atomic<bool>* cancel;               // 调用者的取消标志，可为空
+
+        Node root;
+        std::vector<std::deque<Node>> arenas;          // 每个线程各自分配节点，搜索结束后统一释放
+        std::atomic<int> nodeCount{ 1 };
+        std::atomic<int> playouts{ 0 };
+    };
+
+    // 当前局面下需要考虑的走法：领出时为每种非炸弹牌型最便宜的一项和最小的炸弹；
+    // 跟牌时为同牌型最便宜的压牌、最小的能压的炸弹和过牌
+    int legalMoves(const ComboCatalog& catalog, const Rollout::SimState& st, int (&moves)[CardComboType::Bomb + 2])
+    {
+        const ComboCatalog::HandCounts& hand = st.hands[st.toMove];
+        const ComboCatalog::Entry* first = catalog.entries().constData();
+        int count = 0;
+        int wilds = 0;
+        if (st.tableType == CardComboType::Invalid) {
+            for (int type = CardComboType::Single; type < CardComboType::Bomb; ++type) {
+                if (const ComboCatalog::Entry* e = catalog.cheapestOfType(type, -1, hand, wilds)) moves[count++] = int(e - first);
+            }
+            if (const ComboCatalog::Entry* e = catalog.cheapestOfType(CardComboType::Bomb, -1, hand, wilds)) moves[count++] = int(e - first);
+            return count;
+        }
+
+        moves[count++] = kPassMove;
+        if (st.tableType != CardComboType::Bomb) {
+            if (const ComboCatalog::Entry* e = catalog.cheapestOfType(st.tableType, st.tableLevel, hand, wilds)) moves[count++] = int(e - first);
+        }
+        const int bombFloor = st.tableType == CardComboType::Bomb ? st.tableLevel : -1;
+        if (const ComboCatalog::Entry* e = catalog.cheapestOfType(CardComboType::Bomb, bombFloor, hand, wilds)) moves[count++] = int(e - first);
+        return count;
+    }
+
+    // 在模拟局面上执行一个走法
+    void applyMove(const SearchShared& shared, Rollout::SimState& st, bool atRoot, int move)
+    {
+        if (atRoot) {
+            const Rollout::Candidate& cand = (*shared.candidates)[move];
+            st.hands[st.toMove] = shared.handsAfter[move];
+            if (cand.cards.isEmpty()) Rollout::pass(st);
+            else Rollout::play(st, cand.type, cand.level, cand.cards.size());
+            return;
+        }
+        if (move == kPassMove) {
+            Rollout::pass(st);
+            return;
+        }
+        const ComboCatalog::Entry& entry = shared.catalog->entries()[move];
+        shared.catalog->consume(entry, st.hands[st.toMove]);
+        Rollout::play(st, entry.type, entry.level, entry.cardCount);
+    }
+
+    double ucbValue(const Node* child, double logAvailability)
+    {
+        const int visits = child->visits.load(std::memory_order_relaxed);
+        if (visits == 0) return 1e9;
+        const double mean = double(child->reward.load(std::memory_order_relaxed)) / (kScoreScale * visits);
+        return (mean + 3.0) / 6.0 + kExploration * std::sqrt(logAvailability / visits);
+    }
+
+    // 尝试为node添加走法为move的子节点，其他线程正在添加或子节点已满时返回nullptr
+    Node* expand(SearchShared& shared, std::deque<Node>& arena, Node* node, int move, int seat)
+    {
+        if (shared.nodeCount.load(std::memory_order_relaxed) >= IsmctsSearch::kMaxTreeNodes) return nullptr;
+        if (node->expanding.test_and_set(std::memory_order_acquire)) return nullptr;
+
+        Node* child = nullptr;
+        const int count = node->childCount.load(std::memory_order_relaxed);
+        bool exists = false;
+        for (int i = 0; i < count; ++i) {
+            if (node->children[i]->move == move) exists = true;
+        }
+        if (!exists && count < kMaxChildren) {
+            arena.emplace_back();
+            child = &arena.back();
+            child->move = move;
+            child->seat = seat;
+            node->children[count] = child;
+            node->childCount.store(count + 1, std::memory_order_release);
+            shared.nodeCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        node->expanding.clear(std::memory_order_release);
+        return child;
+    }
+
+    void addVisit(Node* node)
+    {
+        node->visits.fetch_add(1, std::memory_order_relaxed);
+        node->reward.fetch_sub(kVirtualLoss, std::memory_order_relaxed);
+    }
+
+    // 一次迭代：确定化、沿树选择和扩展、快速策略模拟、回传得分
+    void iterate(SearchShared& shared, std::deque<Node>& arena, Rollout::SimState& st, RngStream& rng)
+    {
+        Node* path[kMaxPathLength];
+        int depth = 0;
+        Node* node = &shared.root;
+        int moves[CardComboType::Bomb + 2];
+        const int rootMoves = qMin(static_cast<int>(shared.candidates->size()), kMaxChildren);
+
+        while (depth < kMaxPathLength && !Rollout::isSettled(st)) {
+            const bool atRoot = (node == &shared.root);
+            const int moveCount = atRoot ? rootMoves : legalMoves(*shared.catalog, st, moves);
+            if (moveCount == 0) break;
+
+            // 统计本次确定化中合法的子节点，并找出尚未扩展的走法
+            const int childCount = node->childCount.load(std::memory_order_acquire);
+            Node* legalChildren[kMaxChildren];
+            int legalCount = 0;
+            int untried[kMaxChildren];
+            int untriedCount = 0;
+            for (int m = 0; m < moveCount; ++m) {
+                const int move = atRoot ? m : moves[m];
+                bool found = false;
+                for (int c = 0; c < childCount; ++c) {
+                    if (node->children[c]->move == move) {
+                        legalChildren[legalCount++] = node->children[c];
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) untried[untriedCount++] = move;
+            }
+
+            if (untriedCount > 0) {
+                const int move = untried[rng.bounded(untriedCount)];
+                if (Node* child = expand(shared, arena, node, move, st.toMove)) {
+                    addVisit(child);
+                    path[depth++] = child;
+                    applyMove(shared, st, atRoot, move);
+                    break;
+                }
+            }
+            if (legalCount == 0) break;
+
+            Node* best = nullptr;
+            double bestValue = -1e18;
+            for (int i = 0; i < legalCount; ++i) {
+                const int availability = legalChildren[i]->availability.fetch_add(1, std::memory_order_relaxed) + 1;
+                const double value = ucbValue(legalChildren[i], std::log(double(availability)));
+                if (value > bestValue) {
+                    bestValue = value;
+                    best = legalChildren[i];
+                }
+            }
+            addVisit(best);
+            path[depth++] = best;
+            applyMove(shared, st, atRoot, best->move);
+            node = best;
+        }
+
+        Rollout::playOut(*shared.catalog, st);
+
+        for (int i = 0; i < depth; ++i) {
+            const qint64 score = qint64(Rollout::outcomeScore(st, path[i]->seat) * kScoreScale);
+            path[i]->reward.fetch_add(score + kVirtualLoss, std::memory_order_relaxed);
+        }
+        shared.playouts.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void runWorker(SearchShared& shared, int index, RngStream rng)
+    {
+        QVector<Card> deck = shared.unseen;
+        std::deque<Node>& arena = shared.arenas[index];
+        shared.budget.begin();
+        do {
+            Rollout::SimState st = shared.base;
+            Rollout::deal(st, deck, *shared.situation, shared.ctx, rng);
+            iterate(shared, arena, st, rng);
+        } while (!shared.budget.expired()
+            && !(shared.cancel && shared.cancel->load(std::memory_order_relaxed)));
+    }
+
+} // namespace
+
+IsmctsSearch::Result IsmctsSearch::search(const Rollout::Situation& situation, const QVector<Rollout::Candidate>& candidates,
+    int budgetMs, int threadCount, quint64 seed, const std::atomic<bool>* cancel)
+{
+    Result result;
+    if (candidates.isEmpty()) return result;
+    result.visits.fill(0, candidates.size());
+    result.meanScores.fill(0.0, candidates.size());
+    if (candidates.size() == 1) {
+        result.bestIndex = 0;
+        return result;
+    }
+
+    SearchShared shared(situation.levelRank, budgetMs);
+    shared.situation = &situation;
+    shared.candidates = &candidates;
+    shared.catalog = &ComboCatalog::forLevel(situation.levelRank);
+    shared.base = Rollout::fromSituation(situation, shared.ctx);
+    shared.unseen = Rollout::unseenCards(situation);
+    shared.cancel = cancel;
+    for (const Rollout::Candidate& cand : candidates) {
+        CardSet after = situation.hand;
+        for (const Card& card : cand.cards) after.remove(card);
+        shared.handsAfter.append(ComboCatalog::HandCounts::fromHand(after, shared.ctx));
+    }
+
+    const int threads = threadCount > 0 ? threadCount : qMax(1, QThread::idealThreadCount());
+    shared.arenas.resize(threads);
+    QThreadPool& pool = Rollout::threadPool();
+    if (pool.maxThreadCount() < threads) pool.setMaxThreadCount(threads);
+
+    const RngStream rng(seed); // 每个线程取一条子流
+    QSemaphore done;
+    for (int t = 0; t < threads; ++t) {
+        pool.start([&shared, &done, &rng, t]() {
+            runWorker(shared, t, rng.split(static_cast<quint64>(t)));
+            done.release();
+        });
+    }
+    done.acquire(threads);
+    const qint64 elapsedMs = qMax<qint64>(1, shared.budget.elapsedMs());
+
+    // 选访问次数最多的候选(比平均得分更稳定)
+    const int childCount = shared.root.childCount.load();
+    for (int c = 0; c < childCount; ++c) {
+        const Node* child = shared.root.children[c];
+        const int visits = child->visits.load();
+        result.visits[child->move] = visits;
+        result.meanScores[child->move] = visits > 0 ? double(child->reward.load()) / (kScoreScale * visits) : 0.0;
+    }
+    result.bestIndex = 0;
+    for (int i = 1; i < candidates.size(); ++i) {
+        if (result.visits[i] > result.visits[result.bestIndex]) result.bestIndex = i;
+    }
+    result.playouts = shared.playouts.load();
+    result.playoutsPerSecond = result.playouts * 1000.0 / elapsedMs;
+    result.treeNodes = shared.nodeCount.load();
+    result.treeFull = result.treeNodes >= kMaxTreeNodes;
+    result.threads = threads;
+
+    qDebug() << "IsmctsSearch::search:" << result.playouts << "playouts in" << elapsedMs << "ms ("
+        << qRound(result.playoutsPerSecond) << "/s), tree" << result.treeNodes << "nodes on" << threads << "threads.";
+    return result;
+}
@@ -0,0 +1,38 @@
+#ifndef ISMCTSSEARCH_H
+#define ISMCTSSEARCH_H
+
+// IsmctsSearch: 信息集蒙特卡洛树搜索(SO-ISMCTS)，供专家难度的AI使用
+// 与PimcSearch每次确定化各自模拟不同，所有确定化共用同一棵树：每次迭代先随机补全其他三家的手牌，
+// 再沿树按UCB选择在本次确定化中合法的走法(可用次数只统计合法时)，扩展一个新走法后用快速策略打完本局并回传得分
+// 根节点的走法为调用者给出的候选出牌，其余层的走法为牌型目录项(每种牌型最便宜的一项、最小的炸弹和过牌)
+// 多线程共用一棵树(树并行)：节点统计为原子量，选择时先加访问次数作为虚拟损失，只有添加子节点时短暂加锁
+
+#include <QVector>
+#include <atomic>
+
+#include "Rollout.h"
+
+class IsmctsSearch
+{
+public:
+    static const int kMaxTreeNodes = 400000; // 树的节点总数上限，超过后不再扩展
+
+    struct Result {
+        int bestIndex = -1;          // 根节点访问次数最多的候选，候选为空时为-1
+        QVector<int> visits;         // 各候选的访问次数
+        QVector<double> meanScores;  // 各候选的平均得分(升级数，对方得分为负)
+        int playouts = 0;            // 完成的迭代次数
+        double playoutsPerSecond = 0;
+        int treeNodes = 0;           // 树的节点数(含根)
+        bool treeFull = false;       // 树达到kMaxTreeNodes，之后的迭代只做模拟、不再扩展
+        int threads = 0;
+    };
+
+    // budgetMs: 本步的时间预算(毫秒)；threadCount: 搜索线程数，<=0时按CPU核数
+    // seed: 随机数种子，各线程由它分出子流
+    // cancel: 取消标志，置位后各线程完成当前迭代即停止，按已有的统计给出结果
+    static Result search(const Rollout::Situation& situation, const QVector<Rollout::Candidate>& candidates,
+        int budgetMs, int threadCount, quint64 seed, const std::atomic<bool>* cancel = nullptr);
+};
+
+#endif // ISMCTSSEARCH_H
@@ -0,0 +1,89 @@
+#ifndef LEVELCONTEXT_H
+#define LEVELCONTEXT_H
+
+// LevelContext: 显式携带当前级牌的比较上下文
+// 卡牌的大小取决于级牌，原先每次比较都要经过 owner->getTeam()->getCurrentLevelRank()
+// 这里为2~A共13种级牌各预先生成一张比较值表，排序和牌型判断只需查表
+
+#include "Card.h"
+
+namespace LevelTables {
+
+    const int LEVEL_COUNT = 13;  // 级牌 2 ~ A
+    const int POINT_SLOTS = 17;  // 以 CardPoint 数值直接作为下标 (最大为 Card_BJ = 16)
+
+    struct ComparisonTables {
+        signed char values[LEVEL_COUNT][POINT_SLOTS];
+    };
+
+    // 与 Card::getComparisonValue 的规则一致:
+    // 大王16 > 小王15 > 级牌14 > A13 > K12 > ... > 3为2 > 2为1
+    constexpr ComparisonTables makeComparisonTables()
+    {
+        ComparisonTables tables{};
+        for (int level = 0; level < LEVEL_COUNT; ++level) {
+            const int levelPoint = level + Card::Card_2;
+            for (int point = 0; point < POINT_SLOTS; ++point) {
+                signed char value = -1;
+                if (point == Card::Card_BJ) value = 16;
+                else if (point == Card::Card_LJ) value = 15;
+                else if (point == levelPoint) value = 14;
+                else if (point >= Card::Card_2 && point <= Card::Card_A) value = static_cast<signed char>(point - 1);
+                tables.values[level][point] = value;
+            }
+        }
+        return tables;
+    }
+
+    inline constexpr ComparisonTables kComparisonTables = makeComparisonTables();
+
+} // namespace LevelTables
+
+class LevelContext
+{
+public:
+    constexpr explicit LevelContext(Card::CardPoint levelRank = Card::Card_2)
+        : m_levelRank(isValidLevel(levelRank) ? levelRank : Card::Card_2)
+        , m_table(LevelTables::kComparisonTables.values[(isValidLevel(levelRank) ? levelRank : Card::Card_2) - Card::Card_2])
+    {
+    }
+
+    constexpr Card::CardPoint levelRank() const { return m_levelRank; }
+
+    // 点数的比较值(与花色无关)
+    constexpr int comparisonValue(Card::CardPoint point) const { return m_table[point]; }
+    int comparisonValue(const Card& card) const { return m_table[card.point()]; }
+
+    // 红桃级牌为癞子
+    bool isWildCard(const Card& card) const
+    {
+        return card.point() == m_levelRank && card.suit() == Card::Heart;
+    }
+
+    // 排序键：比较值在高位，花色在低位，与 operator< 的顺序一致
+    int sortKey(const Card& card) const { return (m_table[card.point()] << 3) | card.suit(); }
+
+    bool lessThan(const Card& a, const Card& b) const { return sortKey(a) < sortKey(b); }
+    bool greaterThan(const Card& a, const Card& b) const { return sortKey(a) > sortKey(b); }
+
+    // 供 std::sort 使用的比较器
+    struct Less {
+        const signed char* table;
+        bool operator()(const Card& a, const Card& b) const
+        {
+            return ((table[a.point()] << 3) | a.suit()) < ((table[b.point()] << 3) | b.suit());
+        }
+    };
+    Less less() const { return Less{ m_table }; }
+
+private:
+    static constexpr bool isValidLevel(Card::CardPoint rank)
+    {
+        return rank >= Card::Card_2 && rank <= Card::Card_A;
+    }
+
+    Card::CardPoint m_levelRank;
+    const signed char* m_table;
+};
+
+#endif // LEVELCONTEXT_H
@@ -1,10 +1,24 @@
 #include "NPCPlayer.h"
 #include "Cardcombo.h"
-#include "GD_Controller.h"
+#include "CardSet.h"
+#include "ComboCatalog.h"
+#include "ComboKey.h"
+#include "EndgameSolver.h"
+#include "HandPlanner.h"
+#include "IsmctsSearch.h"
+#include "PimcSearch.h"
 #include <algorithm>
-#include <QTimer>
+#include <numeric>
 #include <QDebug>
-#include <QSet>
+
+namespace {
+    // 领出时拆牌规划最多展开的状态数(约为1~3毫秒)，提示和超时代打也使用普通难度的选牌，需保证很快返回
+    // 按状态数而不按时间限制，同一局面的选牌与机器快慢无关
+    const int kLeadPlanMaxStates = 8192;
+
+    // 蒙特卡洛搜索最多比较的候选出牌数(按启发式顺序取前若干个)
+    const int kMaxSearchCandidates = 12;
+}
 
 // 构造函数
 NPCPlayer::NPCPlayer(const QString& name, int id)
@@ -13,17 +27,26 @@ NPCPlayer::NPCPlayer(const QString& name, int id)
 // 获取(AI认为的)当前玩家的最佳出牌组合
 QVector<Card> NPCPlayer::getBestPlay(const CardCombo::ComboInfo& currentTableCombo)
 {
-    // 获取当前手牌
-    QVector<Card> hand = getHandCards();
-
     // 如果手牌为空，直接返回空列表
-    if (hand.isEmpty()) {
+    if (getHandSet().isEmpty()) {
         qDebug() << "NPCPlayer::getBestPlay: Hand is empty, cannot play.";
         return {};
     }
 
-    // 调用内部的 findValidPlays 方法来找出所有能打的牌
-    QVector<CardCombo::ComboInfo> validPlays = findValidPlays(hand, currentTableCombo);
+    // 跟牌时先查牌型目录：直接得到最便宜的压牌，不必枚举全部出牌
+    if (currentTableCombo.type != CardComboType::Invalid) {
+        bool catalogAnswered = false;
+        QVector<Card> catalogPlay = findCheapestPlay(currentTableCombo, catalogAnswered);
+        if (catalogAnswered) {
+            if (catalogPlay.isEmpty()) {
+                qDebug() << "NPCPlayer::getBestPlay: No valid plays found.";
+            }
+            return catalogPlay;
+        }
+    }
+
+    // 领出，或目录给出的牌组未通过校验时，枚举所有能打的牌
+    QVector<CardCombo::ComboInfo> validPlays = findValidPlays(currentTableCombo);
 
     // 如果找不到任何可以出的牌
     if (validPlays.isEmpty()) {
@@ -35,25 +58,137 @@ QVector<Card> NPCPlayer::getBestPlay(const CardCombo::ComboInfo& currentTableCom
         }
         // 如果是自由出牌阶段,返回最小的一张单牌
         else {
-            QVector<Card> sortedHand = hand;
-            // Card类已重载<运算符，可以直接排序
-            std::sort(sortedHand.begin(), sortedHand.end());
-            if (!sortedHand.isEmpty()) {
-                qDebug() << "NPCPlayer::getBestPlay: Forcing smallest single card play.";
-                return { sortedHand.first() };
-            }
-            return {}; // 极端情况，手牌排序后还是空的
+            // 手牌索引直接给出最小的牌，无需排序
+            qDebug() << "NPCPlayer::getBestPlay: Forcing smallest single card play.";
+            return { getSmallestCard() };
         }
     }
 
+    // 领出时用拆牌规划评估每种出法：出牌后剩余手牌最少还要几手才能出完
+    QVector<int> remainingHands(validPlays.size(), 0);
+    if (currentTableCombo.type == CardComboType::Invalid) {
+        remainingHands = planRemainingHands(validPlays);
+    }
+
     // --- AI 决策核心：对所有可行的出牌组合进行排序，选出最优解 ---
+    const QVector<int> order = rankPlays(validPlays, remainingHands);
+
+    // 排序后，第一个元素就是最优选择
+    const CardCombo::ComboInfo& bestPlay = validPlays[order.first()];
+
+    qDebug() << "NPCPlayer::getBestPlay: Found" << validPlays.size() << "valid plays. Best choice:" << bestPlay.getDescription();
+
+    // 返回最优组合的原始卡牌（包含癞子）
+    return bestPlay.original_cards;
+}
+
+// 困难/专家难度：用确定化蒙特卡洛搜索(treeSearch为true时用信息集蒙特卡洛树搜索)在启发式排名靠前的出牌(以及过牌)中选择
+// 其他玩家的手牌由公开的出牌历史和剩余张数随机补全，不读取其真实手牌
+QVector<Card> NPCPlayer::getSearchPlay(const CardCombo::ComboInfo& currentTableCombo, const Rollout::Situation& publicInfo, bool treeSearch,
+    int budgetMs, int threadCount, quint64 seed, const std::atomic<bool>* cancel, Rollout::SearchStats* stats)
+{
+    Rollout::SearchStats local;
+    Rollout::SearchStats& searchStats = stats ? *stats : local;
+    searchStats = Rollout::SearchStats(); // 没有需要比较的出牌时，启发式选牌就是结果
+    if (getHandSet().isEmpty()) return getBestPlay(currentTableCombo);
+
+    QVector<CardCombo::ComboInfo> validPlays = findValidPlays(currentTableCombo);
+    if (validPlays.isEmpty()) return getBestPlay(currentTableCombo);
+
+    const bool leading = currentTableCombo.type == CardComboType::Invalid;
+    Rollout::Situation situation = publicInfo;
+    situation.seat = getID();
+    situation.levelRank = getLevelContext().levelRank();
+    situation.hand = getHandSet();
+    situation.handCounts[situation.seat] = getHandSet().size();
+    situation.tableType = currentTableCombo.type;
+    situation.tableLevel = currentTableCombo.level;
+    if (leading) situation.tableOwner = -1;
+
+    // 残局精确搜索比较全部出牌(牌型、点数和所用的牌都相同的出法只保留一种)，其他情况只比较启发式排名靠前的出牌
+    // 所用的牌按ComboKey::cardId(点数+花色)区分：癞子与本色级牌、不同花色的牌不会被合并
+    const bool endgame = EndgameSolver::applies(situation);
+
+    QVector<int> remainingHands(validPlays.size(), 0);
+    if (leading) {
+        remainingHands = planRemainingHands(validPlays);
+    }
+    const QVector<int> order = rankPlays(validPlays, remainingHands);
+
+    QVector<Rollout::Candidate> candidates;
+    QVector<QVector<int>> seenPlays;
+    for (int i = 0; i < order.size() && (endgame || i < kMaxSearchCandidates); ++i) {
+        const CardCombo::ComboInfo& play = validPlays[order[i]];
+        if (endgame) {
+            QVector<int> signature = { play.type, play.level };
+            for (const Card& card : play.original_cards) signature.append(ComboKey::cardId(card));
+            std::sort(signature.begin() + 2, signature.end());
+            if (seenPlays.contains(signature)) continue;
+            seenPlays.append(signature);
+        }
+        Rollout::Candidate cand;
+        cand.cards = play.original_cards;
+        cand.type = play.type;
+        cand.level = play.level;
+        candidates.append(cand);
+    }
+    if (!leading) {
+        candidates.append(Rollout::Candidate()); // 跟牌时可以过牌
+    }
+
+    // 预算内连一次模拟或求解都没有完成时(如被取消)，搜索的结果没有依据，退回启发式选牌
+    int bestIndex = -1;
+    if (candidates.size() == 1) {
+        bestIndex = 0;
+    } else if (endgame) {
+        const EndgameSolver::Result result = EndgameSolver::search(situation, candidates, budgetMs, threadCount, seed, cancel);
+        searchStats.kind = Rollout::SearchStats::Endgame;
+        searchStats.nodesPerSecond = result.nodesPerSecond;
+        searchStats.solveMs = result.solveMs;
+        searchStats.exact = result.exact;
+        bestIndex = result.bestIndex;
+    } else if (treeSearch) {
+        const IsmctsSearch::Result result = IsmctsSearch::search(situation, candidates, budgetMs, threadCount, seed, cancel);
+        searchStats.kind = Rollout::SearchStats::Ismcts;
+        searchStats.playoutsPerSecond = result.playoutsPerSecond;
+        searchStats.treeNodes = result.treeNodes;
+        searchStats.treeFull = result.treeFull;
+        if (result.playouts > 0) bestIndex = result.bestIndex;
+    } else {
+        const PimcSearch::Result result = PimcSearch::search(situation, candidates, budgetMs, threadCount, seed, cancel);
+        searchStats.kind = Rollout::SearchStats::Pimc;
+        if (result.samples > 0) bestIndex = result.bestIndex;
+    }
+    if (bestIndex < 0) {
+        searchStats.searched = false;
+        return getBestPlay(currentTableCombo);
+    }
+
+    qDebug() << "NPCPlayer::getSearchPlay: best candidate" << bestIndex << "of" << candidates.size();
+    return candidates[bestIndex].cards;
+}
+
+// 辅助函数：按启发式规则对出牌排序，返回排序后的下标(第一个为最优)
+QVector<int> NPCPlayer::rankPlays(const QVector<CardCombo::ComboInfo>& plays, const QVector<int>& remainingHands)
+{
     // 排序策略：
+    // 0. (领出时)剩余手牌所需手数少的 优先于 多的（按最少手数的拆法出牌）
     // 1. 非炸弹 优先于 炸弹（避免轻易浪费炸弹）
     // 2. 牌力等级（level）低的 优先于 等级高的（先出小牌）
     // 3. 使用癞子（wild_cards_used）少的 优先于 多的（节省万能牌）
     // 4. 牌数（original_cards.size()）少的 优先于 多的（保留大牌型）
-    std::sort(validPlays.begin(), validPlays.end(),
-        [](const CardCombo::ComboInfo& a, const CardCombo::ComboInfo& b) {
+    QVector<int> order(plays.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+        [&](int i, int j) {
+            const CardCombo::ComboInfo& a = plays[i];
+            const CardCombo::ComboInfo& b = plays[j];
+
+            // 规则0：剩余手数少的优先
+            if (remainingHands[i] != remainingHands[j]) {
+                return remainingHands[i] < remainingHands[j];
+            }
+
             bool a_is_bomb = (a.type == CardComboType::Bomb);
             bool b_is_bomb = (b.type == CardComboType::Bomb);
 
@@ -80,413 +215,355 @@ QVector<Card> NPCPlayer::getBestPlay(const CardCombo::ComboInfo& currentTableCom
             // 如果所有条件都相同，保持原有顺序
             return false;
         });
+    return order;
+}
 
-    // 排序后，第一个元素就是最优选择
-    CardCombo::ComboInfo bestPlay = validPlays.first();
-
-    qDebug() << "NPCPlayer::getBestPlay: Found" << validPlays.size() << "valid plays. Best choice:" << bestPlay.getDescription();
-
-    // 返回最优组合的原始卡牌（包含癞子）
-    return bestPlay.original_cards;
+// 辅助函数：对每种领出方式，计算出牌后剩余手牌最少还需要几手
+// 所有出法共用一个规划器(记忆表和状态数上限)，超出上限后的结果为估计值
+QVector<int> NPCPlayer::planRemainingHands(const QVector<CardCombo::ComboInfo>& plays)
+{
+    HandPlanner planner(getLevelContext(), kLeadPlanMaxStates);
+    QVector<int> hands;
+    hands.reserve(plays.size());
+    for (const CardCombo::ComboInfo& play : plays) {
+        CardSet rest = getHandSet();
+        rest.remove(CardSet(play.original_cards));
+        hands.append(planner.minimumHands(rest));
+    }
+    if (planner.timedOut()) {
+        qDebug() << "NPCPlayer::planRemainingHands: planner hit the" << kLeadPlanMaxStates << "state budget after"
+            << planner.expandedStates() << "states.";
+    }
+    return hands;
 }
 
 // 辅助函数：按点数对手牌进行分类，返回QMap
-QMap<Card::CardPoint, QVector<Card>> NPCPlayer::classifyHandByPoint(const QVector<Card>& hand) {
+// 直接由手牌索引的点数位掩码生成，不再遍历手牌；excludeWilds不为空时不包含癞子
+QMap<Card::CardPoint, QVector<Card>> NPCPlayer::classifyHandByPoint(const CardSet& handSet, Player* owner, const LevelContext* excludeWilds) {
     QMap<Card::CardPoint, QVector<Card>> pointGroups;
-    for (const Card& card : hand) {
-        pointGroups[card.point()].append(card);
+    for (int r = 0; r < CardSet::RANK_COUNT; ++r) {
+        if (!(handSet.rankMask() & (1u << r))) continue;
+        QVector<Card> cards = handSet.cardsOfRank(CardSet::rankAt(r), owner, excludeWilds);
+        if (!cards.isEmpty()) {
+            pointGroups.insert(CardSet::rankAt(r), cards);
+        }
     }
     return pointGroups;
 }
 
-// 辅助函数：找出所有可能的炸弹
-QVector<QVector<Card>> NPCPlayer::findBombs(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const QVector<Card>& wild_cards) {
-    QVector<QVector<Card>> candidates;
-    int wild_count = wild_cards.size();
+// 辅助函数：把一种已确定牌型和等级的出牌加入结果，压不过桌面牌型时直接丢弃
+// naturals 为使用的普通牌，wildPoints 为每张癞子代替的点数，癞子以wildSuit花色计入cards_in_combo
+void NPCPlayer::addPlay(QVector<CardCombo::ComboInfo>& plays, const MoveContext& mc, int type, int level,
+    const QVector<Card>& naturals, const QVector<Card::CardPoint>& wildPoints, Card::CardSuit wildSuit) {
+    if (!CardCombo::canBeat(type, level, mc.tableType, mc.tableLevel)) return;
+
+    CardCombo::ComboInfo info;
+    info.type = type;
+    info.level = level;
+    info.original_cards = naturals;
+    info.cards_in_combo = naturals;
+    for (Card::CardPoint p : wildPoints) {
+        info.original_cards.append(Card(mc.levelCtx.levelRank(), Card::Heart, mc.owner));
+        info.cards_in_combo.append(Card(p, wildSuit, mc.owner));
+    }
+    info.wild_cards_used = wildPoints.size();
+    info.is_flush_straight_bomb = (type == CardComboType::Bomb && level >= 200000 && level < 300000);
+    std::sort(info.cards_in_combo.begin(), info.cards_in_combo.end(), mc.levelCtx.less());
+    plays.append(info);
+}
 
+// 辅助函数：找出所有可能的炸弹
+void NPCPlayer::findBombs(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const MoveContext& mc, QVector<CardCombo::ComboInfo>& plays) {
     // 遍历每种点数的普通牌，尝试与癞子组合成炸弹
     for (auto it = pointGroups.constBegin(); it != pointGroups.constEnd(); ++it) {
         const QVector<Card>& cards_of_point = it.value();
-        int normal_count = cards_of_point.size();
+        const int normal_count = cards_of_point.size();
+        if (it.key() == Card::Card_LJ || it.key() == Card::Card_BJ) continue; // 大小王只能组成天王炸
+        const int value = qMax(0, mc.levelCtx.comparisonValue(it.key()));
 
         // 遍历所有可能的癞子使用数量
-        for (int w = 0; w <= wild_count; ++w) {
+        QVector<Card::CardPoint> wildPoints;
+        for (int w = 0; w <= mc.wildCount; ++w) {
             if (normal_count + w >= 4) { // 只要总数能构成炸弹
-                QVector<Card> play = cards_of_point;
-                // 从癞子牌池中取出 w 张加入
-                for (int i = 0; i < w; ++i) {
-                    play.append(wild_cards[i]);
-                }
-                candidates.append(play);
+                const int size = normal_count + w;
+                addPlay(plays, mc, CardComboType::Bomb, 100000 + size * 1000 + value, cards_of_point, wildPoints);
             }
+            wildPoints.append(it.key());
         }
     }
 
-    // 单独考虑纯癞子构成的炸弹
-    if (wild_count >= 4) {
-        candidates.append(wild_cards);
+    // 天王炸
+    if (pointGroups.value(Card::Card_LJ).size() == 2 && pointGroups.value(Card::Card_BJ).size() == 2) {
+        QVector<Card> kings = pointGroups.value(Card::Card_LJ) + pointGroups.value(Card::Card_BJ);
+        addPlay(plays, mc, CardComboType::Bomb, 300000 + 4 * 1000 + mc.levelCtx.comparisonValue(Card::Card_BJ), kings, {});
     }
 
-    return candidates;
+    // 同花顺炸弹
+    findStraightFlushes(pointGroups, mc, plays);
 }
 
-// 辅助函数：找出所有可能的三条
-QVector<QVector<Card>> NPCPlayer::findTriples(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const QVector<Card>& wild_cards) {
-    QVector<QVector<Card>> candidates;
-    int wild_count = wild_cards.size();
-
-    // 1. 寻找纯普通牌构成的三条
+// 辅助函数：找出所有可能的同花顺炸弹(含癞子补缺)
+// 每种花色按顺序值建立点数位掩码(A同时占第1位和第14位)，长度为5的窗口中缺少的点数不超过癞子数即可组成
+void NPCPlayer::findStraightFlushes(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const MoveContext& mc, QVector<CardCombo::ComboInfo>& plays) {
+    quint16 suitMasks[4] = { 0, 0, 0, 0 };
+    Card suitCards[4][15]; // 每种花色在各顺序值上的一张普通牌
     for (auto it = pointGroups.constBegin(); it != pointGroups.constEnd(); ++it) {
-        if (it.value().size() >= 3) {
-            candidates.append({ it.value()[0], it.value()[1], it.value()[2] });
+        if (it.key() == Card::Card_LJ || it.key() == Card::Card_BJ) continue;
+        const int order = CardCombo::getSequentialOrder(it.key(), true);
+        for (const Card& card : it.value()) {
+            const int suit = card.suit();
+            suitMasks[suit] |= static_cast<quint16>(1u << order);
+            suitCards[suit][order] = card;
+            if (it.key() == Card::Card_A) {
+                suitMasks[suit] |= 1u << 1;
+                suitCards[suit][1] = card;
+            }
         }
     }
 
-    // 2. 寻找 "对子 + 1个癞子" 构成的三条
-    if (wild_count >= 1) {
-        for (auto it = pointGroups.constBegin(); it != pointGroups.constEnd(); ++it) {
-            if (it.value().size() >= 2) {
-                candidates.append({ it.value()[0], it.value()[1], wild_cards[0] });
+    const quint16 window = 0x1F; // 连续5个点数
+    for (int suit = 0; suit < 4; ++suit) {
+        // 该花色的点数加上癞子也凑不出5张时跳过
+        if (CardSet::bitCount(suitMasks[suit]) + mc.wildCount < 5) continue;
+
+        for (int top = 5; top <= 14; ++top) {
+            const quint16 windowMask = static_cast<quint16>(window << (top - 4));
+            const int present = CardSet::bitCount(suitMasks[suit] & windowMask);
+            if (5 - present > mc.wildCount) continue;
+
+            const Card::CardPoint lead = (top == 14) ? Card::Card_A : static_cast<Card::CardPoint>(top);
+            const int level = 200000 + 5 * 1000 + qMax(0, mc.levelCtx.comparisonValue(lead));
+            if (!CardCombo::canBeat(CardComboType::Bomb, level, mc.tableType, mc.tableLevel)) continue;
+
+            QVector<Card> naturals;
+            QVector<Card::CardPoint> wildPoints;
+            for (int o = top - 4; o <= top; ++o) {
+                if (suitMasks[suit] & (1u << o)) naturals.append(suitCards[suit][o]);
+                else wildPoints.append((o == 1 || o == 14) ? Card::Card_A : static_cast<Card::CardPoint>(o));
             }
+            addPlay(plays, mc, CardComboType::Bomb, level, naturals, wildPoints, static_cast<Card::CardSuit>(suit));
         }
     }
+}
 
-    // 3. 寻找 "单张 + 2个癞子" 构成的三条
-    if (wild_count >= 2) {
+// 辅助函数：找出所有可能的三条
+void NPCPlayer::findTriples(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const MoveContext& mc, QVector<CardCombo::ComboInfo>& plays) {
+    // 依次为 纯普通牌、"对子 + 1个癞子"、"单张 + 2个癞子" 构成的三条
+    for (int w = 0; w <= qMin(2, mc.wildCount); ++w) {
         for (auto it = pointGroups.constBegin(); it != pointGroups.constEnd(); ++it) {
-            if (!it.value().isEmpty()) {
-                candidates.append({ it.value()[0], wild_cards[0], wild_cards[1] });
-            }
+            if (it.value().size() < 3 - w) continue;
+            if (w > 0 && (it.key() == Card::Card_LJ || it.key() == Card::Card_BJ)) continue; // 癞子不能当大小王
+            addPlay(plays, mc, CardComboType::Triple, mc.levelCtx.comparisonValue(it.key()),
+                it.value().mid(0, 3 - w), QVector<Card::CardPoint>(w, it.key()));
         }
     }
-
-    return candidates;
 }
 
 // 辅助函数：找出所有可能的对子
-QVector<QVector<Card>> NPCPlayer::findPairs(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const QVector<Card>& wild_cards) {
-    QVector<QVector<Card>> candidates;
-
-    // 1. 寻找纯普通牌构成的对子
-    for (auto it = pointGroups.constBegin(); it != pointGroups.constEnd(); ++it) {
-        if (it.value().size() >= 2) {
-            candidates.append({ it.value()[0], it.value()[1] });
-        }
-    }
-
-    // 2. 寻找 "单张 + 1个癞子" 构成的对子
-    if (!wild_cards.isEmpty()) {
+void NPCPlayer::findPairs(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const MoveContext& mc, QVector<CardCombo::ComboInfo>& plays) {
+    // 依次为 纯普通牌、"单张 + 1个癞子" 构成的对子
+    for (int w = 0; w <= qMin(1, mc.wildCount); ++w) {
         for (auto it = pointGroups.constBegin(); it != pointGroups.constEnd(); ++it) {
-            // 任何一张普通牌都可以和一张癞子组成对子
-            if (!it.value().isEmpty()) {
-                candidates.append({ it.value()[0], wild_cards[0] });
-            }
+            if (it.value().size() < 2 - w) continue;
+            if (w > 0 && (it.key() == Card::Card_LJ || it.key() == Card::Card_BJ)) continue; // 癞子不能当大小王
+            addPlay(plays, mc, CardComboType::Pair, mc.levelCtx.comparisonValue(it.key()),
+                it.value().mid(0, 2 - w), QVector<Card::CardPoint>(w, it.key()));
         }
     }
-
-    return candidates;
 }
 
 // 辅助函数：找出所有单牌
-QVector<QVector<Card>> NPCPlayer::findSingles(const QMap<Card::CardPoint, QVector<Card>>& pointGroups) {
-    QVector<QVector<Card>> singles;
+void NPCPlayer::findSingles(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const MoveContext& mc, QVector<CardCombo::ComboInfo>& plays) {
 	// 遍历点数QMap，取出每个点数的第一张牌作为单牌
     for (auto it = pointGroups.constBegin(); it != pointGroups.constEnd(); ++it) {
-        singles.append(QVector<Card>{it.value().first()});
+        addPlay(plays, mc, CardComboType::Single, mc.levelCtx.comparisonValue(it.key()), { it.value().first() }, {});
     }
-    return singles;
 }
 
-// 辅助函数：找出所有可能的顺子
-QVector<QVector<Card>> NPCPlayer::findStraights(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, int requiredLength) {
-    QVector<QVector<Card>> straights;
-    QVector<Card::CardPoint> availablePoints = pointGroups.keys().toVector(); // 生成可用点数数组
-
-    // 如果可用点数少于顺子所需长度，直接返回
-    if (availablePoints.size() < requiredLength) {
-        return straights;
+// 辅助函数：一次滑窗找出所有顺子、连对和钢板(含癞子补缺)
+// 点数按顺序值排列(A同时位于最低位1和最高位14)，窗口每右移一格只更新进出两个点数的缺口，
+// 窗口内缺口总数不超过癞子数即可组成对应牌型；等级为窗口顶张的顺序值
+void NPCPlayer::findSequences(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const MoveContext& mc, QVector<CardCombo::ComboInfo>& plays,
+    bool straights, bool doubleSequences, bool tripleSequences) {
+    // 每种牌型的 (牌型, 每个点数的张数, 连续点数个数)
+    const int shapes[3][3] = {
+        { CardComboType::Straight, 1, 5 },
+        { CardComboType::DoubleSequence, 2, 3 },
+        { CardComboType::TripleSequence, 3, 2 } };
+    const bool wanted[3] = { straights, doubleSequences, tripleSequences };
+
+    // 顺序值1~14上的普通牌张数及点数位掩码
+    int counts[15] = { 0 };
+    quint16 orderMask = 0;
+    for (auto it = pointGroups.constBegin(); it != pointGroups.constEnd(); ++it) {
+        if (it.key() == Card::Card_LJ || it.key() == Card::Card_BJ) continue;
+        const int order = CardCombo::getSequentialOrder(it.key(), true);
+        counts[order] = it.value().size();
+        orderMask |= static_cast<quint16>(1u << order);
+        if (it.key() == Card::Card_A) {
+            counts[1] = counts[order];
+            orderMask |= 1u << 1;
+        }
     }
 
-    // --- 采用“枚举子集 + 规则验证”的思路 ---
-    // 1. 生成所有长度为 requiredLength 的点数子集
-    std::function<void(int, QVector<Card::CardPoint>)> findSubsets =
-        [&](int start_index, QVector<Card::CardPoint> current_subset)
-        {
-            // 当子集达到所需长度时，进行验证
-            if (current_subset.size() == requiredLength) {
-                Card::CardPoint leading_point; // 用于接收顺子的最大点，这里我们不关心它的值
-                // 2. 使用 CardCombo::checkConsecutive 进行权威验证
-                if (CardCombo::checkConsecutive(current_subset, leading_point)) {
-                    // 如果验证通过，说明这是一个有效的顺子点数组合
-                    QVector<Card> straight_cards;
-                    // 从手牌中取出对应的牌来构成顺子
-                    for (Card::CardPoint p : current_subset) {
-                        if (!pointGroups[p].isEmpty()) {
-                            straight_cards.append(pointGroups[p].first());
-                        }
-                    }
-                    // 确保我们真的找到了所有需要的牌
-                    if (straight_cards.size() == requiredLength) {
-                        straights.append(straight_cards);
+    for (int shape = 0; shape < 3; ++shape) {
+        if (!wanted[shape]) continue;
+        const int type = shapes[shape][0];
+        const int width = shapes[shape][1];
+        const int length = shapes[shape][2];
+
+        // 拥有的点数加上癞子也凑不出窗口长度时直接跳过
+        if (CardSet::bitCount(orderMask) + mc.wildCount < length) continue;
+
+        int deficit = 0;
+        for (int order = 1; order <= 14; ++order) {
+            deficit += qMax(0, width - counts[order]);
+            if (order > length) deficit -= qMax(0, width - counts[order - length]);
+            if (order < length || deficit > mc.wildCount) continue;
+
+            // 窗口 [order-length+1, order] 可以组成：取普通牌，缺口用癞子补齐
+            QVector<Card> naturals;
+            QVector<Card::CardPoint> wildPoints;
+            int suitMask = 0;
+            for (int o = order - length + 1; o <= order; ++o) {
+                const Card::CardPoint p = (o == 1 || o == 14) ? Card::Card_A : static_cast<Card::CardPoint>(o);
+                const int take = qMin(width, counts[o]);
+                if (take > 0) {
+                    const QVector<Card>& cards = pointGroups[p];
+                    for (int i = 0; i < take; ++i) {
+                        naturals.append(cards[i]);
+                        suitMask |= 1 << cards[i].suit();
                     }
                 }
-                return;
+                for (int i = take; i < width; ++i) wildPoints.append(p);
             }
 
-            // 递归地构建子集
-            if (start_index >= availablePoints.size()) {
-                return;
+            // 顺子的普通牌都取成了同一花色时，与ComboCatalog::materialize一样把一个点数换成其他花色，作为普通顺子
+            if (type == CardComboType::Straight && CardSet::bitCount(static_cast<quint16>(suitMask)) == 1) {
+                for (Card& card : naturals) {
+                    for (const Card& alt : pointGroups[card.point()]) {
+                        if (alt.suit() != card.suit()) { card = alt; suitMask |= 1 << alt.suit(); break; }
+                    }
+                    if (CardSet::bitCount(static_cast<quint16>(suitMask)) > 1) break;
+                }
             }
 
-            for (int i = start_index; i < availablePoints.size(); ++i) {
-                current_subset.push_back(availablePoints[i]);
-                findSubsets(i + 1, current_subset);
-                current_subset.pop_back(); // 回溯
+            // 没有其他花色可换时，癞子补成同一花色，按同花顺炸弹计
+            if (type == CardComboType::Straight && CardSet::bitCount(static_cast<quint16>(suitMask)) == 1) {
+                const Card::CardSuit suit = naturals.first().suit();
+                const Card::CardPoint lead = (order == 14) ? Card::Card_A : static_cast<Card::CardPoint>(order);
+                addPlay(plays, mc, CardComboType::Bomb, 200000 + 5 * 1000 + qMax(0, mc.levelCtx.comparisonValue(lead)),
+                    naturals, wildPoints, suit);
+                continue;
             }
-        };
-
-    // 从索引0开始，用一个空子集启动递归搜索
-    findSubsets(0, {});
-
-    return straights;
-}
-
-// 辅助函数：找出所有可能的连对
-QVector<QVector<Card>> NPCPlayer::findDoubleSequences(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, int requiredLength) {
-    QVector<QVector<Card>> sequences;
-    QVector<Card::CardPoint> validPoints;
-    for (auto it = pointGroups.constBegin(); it != pointGroups.constEnd(); ++it) {
-        if (it.value().size() >= 2) {
-            validPoints.append(it.key());
-        }
-    }
-    std::sort(validPoints.begin(), validPoints.end());
-
-    if (validPoints.size() < requiredLength) return sequences;
-
-    for (int i = 0; i <= validPoints.size() - requiredLength; ++i) {
-        bool isConsecutive = true;
-        for (int j = 0; j < requiredLength - 1; ++j) {
-            if (static_cast<int>(validPoints[i + j + 1]) != static_cast<int>(validPoints[i + j]) + 1) {
-                isConsecutive = false;
-                break;
-            }
-        }
-        if (isConsecutive) {
-            QVector<Card> sequence;
-            for (int j = 0; j < requiredLength; ++j) {
-                sequence.append(pointGroups[validPoints[i + j]][0]);
-                sequence.append(pointGroups[validPoints[i + j]][1]);
-            }
-            sequences.append(sequence);
+            addPlay(plays, mc, type, order, naturals, wildPoints);
         }
     }
-    return sequences;
 }
 
 // 辅助函数：找出所有可能的三带二
-QVector<QVector<Card>> NPCPlayer::findTripleWithPairs(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const QVector<Card>& wild_cards) {
-    QVector<QVector<Card>> result;
-    auto triples = findTriples(pointGroups,wild_cards);
-    auto pairs = findPairs(pointGroups,wild_cards);
-
-    if (triples.isEmpty() || pairs.isEmpty()) return result;
-
-    for (const auto& triple : triples) {
-        Card::CardPoint triplePoint = triple[0].point();
-        for (const auto& pair : pairs) {
-            if (pair[0].point() != triplePoint) {
-                QVector<Card> combined = triple;
-                combined.append(pair);
-                result.append(combined);
+// 三条部分和对子部分分别可以用癞子补齐，但两部分合计不能超过手中的癞子数
+void NPCPlayer::findTripleWithPairs(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const MoveContext& mc, QVector<CardCombo::ComboInfo>& plays) {
+    for (int tw = 0; tw <= qMin(2, mc.wildCount); ++tw) {
+        for (auto t = pointGroups.constBegin(); t != pointGroups.constEnd(); ++t) {
+            if (t.value().size() < 3 - tw) continue;
+            if (t.key() == Card::Card_LJ || t.key() == Card::Card_BJ) continue;
+            const int level = mc.levelCtx.comparisonValue(t.key());
+            if (!CardCombo::canBeat(CardComboType::TripleWithPair, level, mc.tableType, mc.tableLevel)) continue;
+
+            for (int pw = 0; pw <= qMin(1, mc.wildCount - tw); ++pw) {
+                for (auto p = pointGroups.constBegin(); p != pointGroups.constEnd(); ++p) {
+                    if (p.key() == t.key() || p.value().size() < 2 - pw) continue;
+                    if (pw > 0 && (p.key() == Card::Card_LJ || p.key() == Card::Card_BJ)) continue;
+
+                    QVector<Card> naturals = t.value().mid(0, 3 - tw) + p.value().mid(0, 2 - pw);
+                    QVector<Card::CardPoint> wildPoints = QVector<Card::CardPoint>(tw, t.key()) + QVector<Card::CardPoint>(pw, p.key());
+                    addPlay(plays, mc, CardComboType::TripleWithPair, level, naturals, wildPoints);
+                }
             }
         }
     }
-    return result;
-}
-
-// 辅助函数：找出所有可能的钢板 (TripleSequence)
-QVector<QVector<Card>> NPCPlayer::findTripleSequences(const QMap<Card::CardPoint, QVector<Card>>& pointGroups) {
-    QVector<QVector<Card>> sequences;
-
-    // 1. 筛选出所有手牌中天然形成的三条
-    QVector<Card::CardPoint> availableTriples;
-    for (auto it = pointGroups.constBegin(); it != pointGroups.constEnd(); ++it) {
-        if (it.value().size() >= 3) {
-            availableTriples.append(it.key());
-        }
-    }
-
-    // 如果三条的数量少于2，不可能组成钢板
-    if (availableTriples.size() < 2) {
-        return sequences;
-    }
-
-    // 2. 对这些三条的点数进行排序，以便查找连续对
-    std::sort(availableTriples.begin(), availableTriples.end());
-
-    // 3. 遍历所有三条，寻找连续的两组
-    // Part 1: 寻找标准连续的钢板 (222-333, ..., KKK-AAA)
-    for (int i = 0; i < availableTriples.size() - 1; ++i) {
-        Card::CardPoint p1 = availableTriples[i];
-        Card::CardPoint p2 = availableTriples[i + 1];
-
-        // 检查点数值是否连续 (例如，点数3和点数4)
-        if (static_cast<int>(p2) == static_cast<int>(p1) + 1) {
-            QVector<Card> sequence;
-            // 添加第一组三条
-            sequence.append(pointGroups[p1][0]);
-            sequence.append(pointGroups[p1][1]);
-            sequence.append(pointGroups[p1][2]);
-            // 添加第二组三条
-            sequence.append(pointGroups[p2][0]);
-            sequence.append(pointGroups[p2][1]);
-            sequence.append(pointGroups[p2][2]);
-
-            sequences.append(sequence);
-        }
-    }
-
-    // Part 2: 单独检查特殊的 A-2 钢板
-    // 检查手中是否同时有A的三条和2的三条
-    bool hasAceTriple = false;
-    bool hasTwoTriple = false;
-    for (const auto& point : availableTriples) {
-        if (point == Card::Card_A) hasAceTriple = true;
-        if (point == Card::Card_2) hasTwoTriple = true;
-    }
-
-    if (hasAceTriple && hasTwoTriple) {
-        QVector<Card> sequence;
-        // 添加A的三条
-        sequence.append(pointGroups[Card::Card_A][0]);
-        sequence.append(pointGroups[Card::Card_A][1]);
-        sequence.append(pointGroups[Card::Card_A][2]);
-        // 添加2的三条
-        sequence.append(pointGroups[Card::Card_2][0]);
-        sequence.append(pointGroups[Card::Card_2][1]);
-        sequence.append(pointGroups[Card::Card_2][2]);
-
-        sequences.append(sequence);
-    }
-
-    return sequences;
 }
 
 // 核心算法函数：找出所有可能的合法出牌组合
-QVector<CardCombo::ComboInfo> NPCPlayer::findValidPlays(const QVector<Card>& hand, const CardCombo::ComboInfo& tableCombo)
+// 各生成器直接给出牌型、等级和癞子用法，并在生成时按桌面牌型过滤，不再把候选牌组交给规则引擎重新评估
+QVector<CardCombo::ComboInfo> NPCPlayer::findValidPlays(const CardCombo::ComboInfo& tableCombo)
 {
-	// 初始化结果容器
-    QVector<CardCombo::ComboInfo> allValidPlays;
-    QVector<QVector<Card>> potentialPlays;
-
-    // 分离癞子和普通牌
-    QVector<Card> wild_cards;
-    QVector<Card> normal_cards;
-    for (const Card& card : hand) {
-        if (card.isWildCard()) {
-            wild_cards.append(card);
-        }
-        else {
-            normal_cards.append(card);
-        }
-    }
+    // 直接使用Player维护的手牌索引，不再重新统计手牌
+    const CardSet& handSet = getHandSet();
+    const MoveContext mc{ getLevelContext(), this, tableCombo.type, tableCombo.level, handSet.wildCount(getLevelContext()) };
 
-    // 对所有牌分类
-	auto pointGroups = classifyHandByPoint(hand);
-    // 按点数对普通牌进行分类
-    auto normal_pointGroups = classifyHandByPoint(normal_cards);
+    // 按点数对普通牌进行分类(癞子单独处理)
+    auto normal_pointGroups = classifyHandByPoint(handSet, this, &mc.levelCtx);
 
+    QVector<CardCombo::ComboInfo> generated;
     // 如果是自由出牌阶段
     if (tableCombo.type == CardComboType::Invalid) {
-        potentialPlays.append(findSingles(normal_pointGroups));
-        potentialPlays.append(findPairs(normal_pointGroups,wild_cards));
-        potentialPlays.append(findTriples(normal_pointGroups,wild_cards));
-        potentialPlays.append(findStraights(pointGroups));
-        potentialPlays.append(findDoubleSequences(pointGroups));
-        potentialPlays.append(findTripleWithPairs(normal_pointGroups, wild_cards));
-        potentialPlays.append(findTripleSequences(pointGroups));
-        potentialPlays.append(findBombs(normal_pointGroups,wild_cards));
+        findSingles(normal_pointGroups, mc, generated);
+        findPairs(normal_pointGroups, mc, generated);
+        findTriples(normal_pointGroups, mc, generated);
+        findSequences(normal_pointGroups, mc, generated, true, true, true);
+        findTripleWithPairs(normal_pointGroups, mc, generated);
+        findBombs(normal_pointGroups, mc, generated);
     }
 	// 如果是跟牌阶段，根据场上牌型找牌
 	else {
 
         if (tableCombo.type == CardComboType::Single) {
-            potentialPlays.append(findSingles(normal_pointGroups));
+            findSingles(normal_pointGroups, mc, generated);
         } else if (tableCombo.type == CardComboType::Pair) {
-            potentialPlays.append(findPairs(normal_pointGroups, wild_cards));
+            findPairs(normal_pointGroups, mc, generated);
         } else if (tableCombo.type == CardComboType::Triple) {
-            potentialPlays.append(findTriples(normal_pointGroups, wild_cards));
-                 } else if (tableCombo.type == CardComboType::Straight) {
-             potentialPlays.append(findStraights(pointGroups, tableCombo.cards_in_combo.size()));
+            findTriples(normal_pointGroups, mc, generated);
+        } else if (tableCombo.type == CardComboType::Straight) {
+            findSequences(normal_pointGroups, mc, generated, true, false, false);
         } else if (tableCombo.type == CardComboType::DoubleSequence) {
-            potentialPlays.append(findDoubleSequences(pointGroups, tableCombo.cards_in_combo.size() / 2));
+            findSequences(normal_pointGroups, mc, generated, false, true, false);
         } else if (tableCombo.type == CardComboType::TripleWithPair) {
-            potentialPlays.append(findTripleWithPairs(normal_pointGroups, wild_cards));
+            findTripleWithPairs(normal_pointGroups, mc, generated);
         } else if (tableCombo.type == CardComboType::TripleSequence){
-            potentialPlays.append(findTripleSequences(pointGroups));
+            findSequences(normal_pointGroups, mc, generated, false, false, true);
         }
         // 任何情况下都可以出炸弹来压
-        potentialPlays.append(findBombs(normal_pointGroups, wild_cards));
+        findBombs(normal_pointGroups, mc, generated);
     }
 
-    QSet<QString> foundSignatures; // 用于防止重复添加完全相同的牌组
-	// 遍历所有可能的出牌组合，筛选生成合法的CardCombo::ComboInfo对象
-    for (const auto& play : potentialPlays) {
-        QVector<CardCombo::ComboInfo> combos = CardCombo::getAllPossibleValidPlays(
-            play, this, tableCombo.type, tableCombo.level);
-        
-        for(const auto& combo : combos) {
-            if(combo.isValid()) {
-                QString signature = CardCombo::generateComboFingerprint(combo.original_cards);
-                if (!foundSignatures.contains(signature)) {
-                    allValidPlays.append(combo);
-                    foundSignatures.insert(signature);
-                }
-            }
+    // 同一组牌只保留第一次生成的解释
+    QVector<CardCombo::ComboInfo> allValidPlays;
+    allValidPlays.reserve(generated.size());
+    ComboKeySet foundSignatures(generated.size());
+    for (const CardCombo::ComboInfo& play : generated) {
+        if (foundSignatures.insert(ComboKey::fromCards(play.original_cards))) {
+            allValidPlays.append(play);
         }
     }
     return allValidPlays;
 }
 
-// AI玩家自动行为：在回合开始时由控制器调用
-void NPCPlayer::autoPlay(GD_Controller* controller, const CardCombo::ComboInfo& currentTableCombo) {
-    // 延迟执行以模拟思考，并避免UI卡顿
-    QTimer::singleShot(500, [this, controller, currentTableCombo]() {
-        QVector<Card> hand = getHandCards();
-        if (hand.isEmpty()) {
-            if (controller && currentTableCombo.type != CardComboType::Invalid) {
-                 controller->onPlayerPass(getID());
-            }
-            return;
-        }
+// 由牌型目录找出最便宜的出牌：跟牌时为能压过上家的最小牌型，领出时为最小的牌型
+// answered为false表示目录给出的牌组未通过规则校验，调用者应改用 findValidPlays
+QVector<Card> NPCPlayer::findCheapestPlay(const CardCombo::ComboInfo& tableCombo, bool& answered)
+{
+    answered = false;
+    const CardSet& handSet = getHandSet();
+    const LevelContext levelCtx = getLevelContext();
+    const ComboCatalog& catalog = ComboCatalog::forLevel(levelCtx.levelRank());
+    const ComboCatalog::HandCounts counts = ComboCatalog::HandCounts::fromHand(handSet, levelCtx);
+
+    const ComboCatalog::Entry* entry = catalog.cheapestBeat(counts, tableCombo.type, tableCombo.level);
+    if (!entry) {
+        // 目录覆盖了所有抽象牌型，找不到即为"要不起"；领出时交给调用者处理
+        answered = tableCombo.type != CardComboType::Invalid;
+        return {};
+    }
 
-        QVector<CardCombo::ComboInfo> validPlays = findValidPlays(hand, currentTableCombo);
+    QVector<Card> cards = catalog.materialize(*entry, handSet, this);
+    if (cards.isEmpty()) return {};
 
-        if (validPlays.isEmpty()) {
-            if (controller && currentTableCombo.type != CardComboType::Invalid) {
-                controller->onPlayerPass(getID());
-            } else if (controller) {
-                // 如果是自己领出，但找不到任何牌（极端情况），打出最小的单张
-                QVector<Card> sortedHand = hand;
-                std::sort(sortedHand.begin(), sortedHand.end());
-                controller->onPlayerPlay(getID(), {sortedHand.first()});
-            }
-            return;
-        }
+    // 用规则引擎校验：牌型必须与目录项一致(避免顺子被判为同花顺炸弹)，且能压过上家
+    CardCombo::BatchResult result = CardCombo::evaluateBatch({ cards }, this, tableCombo.type, tableCombo.level);
+    if (result.size() != 1 || !result.can_beat[0] || result.types[0] != entry->type) return {};
 
-        // 策略排序
-        std::sort(validPlays.begin(), validPlays.end(), 
-            [](const CardCombo::ComboInfo& a, const CardCombo::ComboInfo& b) {
-                bool a_is_bomb = (a.type == CardComboType::Bomb);
-                bool b_is_bomb = (b.type == CardComboType::Bomb);
-                if (a_is_bomb != b_is_bomb) return !a_is_bomb; // 非炸弹优先
-                if (a.level != b.level) return a.level < b.level; // level低的优先
-                if (a.wild_cards_used != b.wild_cards_used) return a.wild_cards_used < b.wild_cards_used; // 癞子少的优先
-                return a.original_cards.size() < b.original_cards.size(); // 牌数少的优先
-            });
-
-        CardCombo::ComboInfo bestPlay = validPlays.first();
-        controller->onPlayerPlay(getID(), bestPlay.original_cards);
-    });
+    answered = true;
+    return cards;
 }
@@ -4,10 +4,9 @@
 
 #include "Player.h"
 #include "Cardcombo.h"
+#include "Rollout.h"
 #include <QMap> 
-
-// 前向声明
-class GD_Controller;
+#include <atomic>
 
 // NPCPlayer 继承自 Player，用于实现AI出牌逻辑
 class NPCPlayer : public Player
@@ -20,40 +19,65 @@ public:
     // 通过AI的出牌逻辑返回可出牌型
     QVector<Card> getBestPlay(const CardCombo::ComboInfo& currentTableCombo);
 
-    // 重写玩家回合行为，实现AI自动出牌
-    void autoPlay(GD_Controller* controller, const CardCombo::ComboInfo& currentTableCombo) override;
+    // 困难/专家难度：用蒙特卡洛搜索选牌，publicInfo为对局的公开信息(出牌历史、各家张数等)
+    // treeSearch为false时用PimcSearch，为true时用IsmctsSearch；剩余总张数很少时改用EndgameSolver精确求解
+    // budgetMs为时间预算，seed为搜索的随机数种子，cancel置位后搜索提前结束
+    // stats不为空时写入本次搜索的统计(见Rollout::SearchStats)
+    QVector<Card> getSearchPlay(const CardCombo::ComboInfo& currentTableCombo, const Rollout::Situation& publicInfo, bool treeSearch,
+        int budgetMs, int threadCount, quint64 seed, const std::atomic<bool>* cancel = nullptr, Rollout::SearchStats* stats = nullptr);
 
 private:
     // 将辅助函数声明为静态(static)，因为它们不依赖于特定NPCPlayer实例的状态，只是对传入的参数进行处理
     
-    // 辅助函数：按点数对手牌进行分类
-    static QMap<Card::CardPoint, QVector<Card>> classifyHandByPoint(const QVector<Card>& hand);
+    // 辅助函数：由手牌索引按点数分类，excludeWilds不为空时不包含该级牌下的癞子
+    static QMap<Card::CardPoint, QVector<Card>> classifyHandByPoint(const CardSet& handSet, Player* owner, const LevelContext* excludeWilds = nullptr);
     
-    // 辅助函数：找出所有可能的炸弹
-    static QVector<QVector<Card>> findBombs(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const QVector<Card>& wild_cards);
+    // 出牌生成的上下文：级牌、出牌者、手中癞子数和需要压过的桌面牌型
+    // 生成器据此直接给出分类好的出牌(牌型、等级、癞子用法)，并在生成时过滤压不过的出牌
+    struct MoveContext {
+        LevelContext levelCtx;
+        Player* owner;
+        int tableType;
+        int tableLevel;
+        int wildCount;
+    };
+
+    // 辅助函数：加入一种已确定牌型和等级的出牌，压不过桌面牌型时丢弃
+    static void addPlay(QVector<CardCombo::ComboInfo>& plays, const MoveContext& mc, int type, int level,
+        const QVector<Card>& naturals, const QVector<Card::CardPoint>& wildPoints, Card::CardSuit wildSuit = Card::Heart);
+
+    // 辅助函数：找出所有可能的炸弹(同点数炸弹、天王炸和同花顺)
+    static void findBombs(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const MoveContext& mc, QVector<CardCombo::ComboInfo>& plays);
     
+    // 辅助函数：按花色位掩码找出所有可能的同花顺炸弹，缺口用癞子补齐
+    static void findStraightFlushes(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const MoveContext& mc, QVector<CardCombo::ComboInfo>& plays);
+
     // 辅助函数：找出所有可能的三条
-    static QVector<QVector<Card>> findTriples(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const QVector<Card>& wild_cards);
+    static void findTriples(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const MoveContext& mc, QVector<CardCombo::ComboInfo>& plays);
 
 	// 辅助函数：找出所有可能的对子
-    static QVector<QVector<Card>> findPairs(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const QVector<Card>& wild_cards);
+    static void findPairs(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const MoveContext& mc, QVector<CardCombo::ComboInfo>& plays);
 
 	// 辅助函数：找出所有单牌
-    static QVector<QVector<Card>> findSingles(const QMap<Card::CardPoint, QVector<Card>>& pointGroups);
+    static void findSingles(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const MoveContext& mc, QVector<CardCombo::ComboInfo>& plays);
     
-    // 辅助函数：找出所有可能的顺子
-    static QVector<QVector<Card>> findStraights(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, int requiredLength = 5);
-    
-    // 辅助函数：找出所有可能的连对 (DoubleSequence)
-    static QVector<QVector<Card>> findDoubleSequences(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, int requiredLength = 3);
+    // 辅助函数：滑窗找出所有可能的顺子、连对和钢板，缺口用癞子补齐
+    static void findSequences(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const MoveContext& mc, QVector<CardCombo::ComboInfo>& plays,
+        bool straights, bool doubleSequences, bool tripleSequences);
     
     // 辅助函数：找出所有可能的三带二 (TripleWithPair)
-    static QVector<QVector<Card>> findTripleWithPairs(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const QVector<Card>& wild_cards);
+    static void findTripleWithPairs(const QMap<Card::CardPoint, QVector<Card>>& pointGroups, const MoveContext& mc, QVector<CardCombo::ComboInfo>& plays);
+
+    // 辅助函数：按启发式规则对出牌排序，返回排序后的下标(第一个为最优)
+    static QVector<int> rankPlays(const QVector<CardCombo::ComboInfo>& plays, const QVector<int>& remainingHands);
+
+	// 领出时评估每种出法：出牌后剩余手牌最少还需要几手(见HandPlanner)
+    QVector<int> planRemainingHands(const QVector<CardCombo::ComboInfo>& plays);
 
-	// 辅助函数：找出所有可能的钢板 (TripleSequence)
-    static QVector<QVector<Card>> findTripleSequences(const QMap<Card::CardPoint, QVector<Card>>& pointGroups);
+	// 由牌型目录直接找出最便宜的出牌，answered为false时需改用findValidPlays
+    QVector<Card> findCheapestPlay(const CardCombo::ComboInfo& tableCombo, bool& answered);
 
-	// 核心算法函数：找出所有可能的合法出牌组合
-    QVector<CardCombo::ComboInfo> findValidPlays(const QVector<Card>& hand, const CardCombo::ComboInfo& tableCombo);
+	// 核心算法函数：根据当前手牌索引找出所有可能的合法出牌组合
+    QVector<CardCombo::ComboInfo> findValidPlays(const CardCombo::ComboInfo& tableCombo);
 };
 
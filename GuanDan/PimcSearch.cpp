@@ -0,0 +1,119 @@
+#include "PimcSearch.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QDebug>
+
+#include "RngStream.h"
+
+namespace {
+
+    // 所有工作线程共享的搜索数据
+    struct SearchShared {
+        SearchShared(Card::CardPoint levelRank, int budgetMs) : ctx(levelRank), budget(budgetMs) {}
+
+        const Rollout::Situation* situation;
+        const QVector<Rollout::Candidate>* candidates;
+        const ComboCatalog* catalog;
+        LevelContext ctx;
+        Rollout::SimState base;                            // 决策者出牌前的局面(其他三家手牌待补全)
+        QVector<Card> unseen;                              // 其他三家手牌的并集
+        QVector<ComboCatalog::HandCounts> handsAfter;      // 每个候选出牌后决策者的手牌
+        Rollout::SearchBudget budget;
+        const std::atomic<bool>* cancel;                   // 调用者的取消标志，可为空
+
+        QMutex mutex;
+        QVector<double> totals;
+        int samples = 0;
+    };
+
+    // 工作线程：在时间预算内反复确定化，每次对所有候选各模拟一局
+    void runWorker(SearchShared& shared, RngStream rng)
+    {
+        const Rollout::Situation& sit = *shared.situation;
+        const QVector<Rollout::Candidate>& candidates = *shared.candidates;
+        QVector<Card> deck = shared.unseen;
+        QVector<double> totals(candidates.size(), 0.0);
+        int samples = 0;
+        Rollout::SimState dealt = shared.base;
+
+        shared.budget.begin();
+        do {
+            Rollout::deal(dealt, deck, sit, shared.ctx, rng);
+            for (int i = 0; i < candidates.size(); ++i) {
+                const Rollout::Candidate& cand = candidates[i];
+                Rollout::SimState st = dealt;
+                st.hands[sit.seat] = shared.handsAfter[i];
+                if (cand.cards.isEmpty()) {
+                    Rollout::pass(st);
+                } else {
+                    Rollout::play(st, cand.type, cand.level, cand.cards.size());
+                }
+                Rollout::playOut(*shared.catalog, st);
+                totals[i] += Rollout::outcomeScore(st, sit.seat);
+            }
+            ++samples;
+        } while (!shared.budget.expired()
+            && !(shared.cancel && shared.cancel->load(std::memory_order_relaxed)));
+
+        QMutexLocker locker(&shared.mutex);
+        for (int i = 0; i < totals.size(); ++i) shared.totals[i] += totals[i];
+        shared.samples += samples;
+    }
+
+} // namespace
+
+PimcSearch::Result PimcSearch::search(const Rollout::Situation& situation, const QVector<Rollout::Candidate>& candidates,
+    int budgetMs, int threadCount, quint64 seed, const std::atomic<bool>* cancel)
+{
+    Result result;
+    if (candidates.isEmpty()) return result;
+    result.meanScores.fill(0.0, candidates.size());
+    if (candidates.size() == 1) {
+        result.bestIndex = 0;
+        return result;
+    }
+
+    SearchShared shared(situation.levelRank, budgetMs);
+    shared.situation = &situation;
+    shared.candidates = &candidates;
+    shared.catalog = &ComboCatalog::forLevel(situation.levelRank);
+    shared.base = Rollout::fromSituation(situation, shared.ctx);
+    shared.unseen = Rollout::unseenCards(situation);
+    shared.cancel = cancel;
+    shared.totals.fill(0.0, candidates.size());
+
+    // 每个候选出牌后的手牌只需计算一次
+    for (const Rollout::Candidate& cand : candidates) {
+        CardSet after = situation.hand;
+        for (const Card& card : cand.cards) after.remove(card);
+        shared.handsAfter.append(ComboCatalog::HandCounts::fromHand(after, shared.ctx));
+    }
+
+    const int threads = threadCount > 0 ? threadCount : qMax(1, QThread::idealThreadCount());
+    QThreadPool& pool = Rollout::threadPool();
+    if (pool.maxThreadCount() < threads) pool.setMaxThreadCount(threads);
+
+    const RngStream rng(seed); // 每个线程取一条子流
+    QSemaphore done;
+    for (int t = 0; t < threads; ++t) {
+        pool.start([&shared, &done, &rng, t]() {
+            runWorker(shared, rng.split(static_cast<quint64>(t)));
+            done.release();
+        });
+    }
+    done.acquire(threads);
+
+    result.samples = shared.samples;
+    result.bestIndex = 0;
+    for (int i = 0; i < candidates.size(); ++i) {
+        result.meanScores[i] = shared.samples > 0 ? shared.totals[i] / shared.samples : 0.0;
+        if (result.meanScores[i] > result.meanScores[result.bestIndex]) result.bestIndex = i;
+    }
+    qDebug() << "PimcSearch::search:" << candidates.size() << "candidates," << shared.samples << "samples in"
+        << shared.budget.elapsedMs() << "ms on" << threads << "threads.";
+    return result;
+}
@@ -0,0 +1,31 @@
+#ifndef PIMCSEARCH_H
+#define PIMCSEARCH_H
+
+// PimcSearch: 确定化蒙特卡洛(PIMC)出牌搜索，供困难难度的AI使用
+// 由本局已打出的牌和各家剩余张数随机补全其他三家的手牌(一次确定化)，
+// 在同一组确定化手牌上对每个候选出牌用快速策略(牌型目录的最便宜压牌)把本局模拟打完，
+// 按名次得分取平均结果最好的候选；模拟在线程池中并行进行，总耗时由每步的时间预算决定
+
+#include <QVector>
+#include <atomic>
+
+#include "Rollout.h"
+
+class PimcSearch
+{
+public:
+    struct Result {
+        int bestIndex = -1;         // 平均得分最高的候选，候选为空时为-1
+        QVector<double> meanScores; // 各候选的平均得分(升级数，对方得分为负)
+        int samples = 0;            // 完成的确定化次数
+    };
+
+    // budgetMs: 本步的时间预算(毫秒)；threadCount: 并行模拟的线程数，<=0时按CPU核数
+    // seed: 随机数种子，各线程由它分出子流(模拟次数相同时结果可以重现)
+    // cancel: 取消标志，置位后各线程完成当前确定化即停止
+    // 平均得分相同时取下标小的候选，调用者应按启发式顺序排列候选
+    static Result search(const Rollout::Situation& situation, const QVector<Rollout::Candidate>& candidates,
+        int budgetMs, int threadCount, quint64 seed, const std::atomic<bool>* cancel = nullptr);
+};
+
+#endif // PIMCSEARCH_H
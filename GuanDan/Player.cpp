@@ -1,5 +1,6 @@
 #include "Player.h"
 #include "Cardcombo.h"
+#include "Team.h"
 
 void Player::setName(QString name)
 {
@@ -35,8 +36,9 @@ void Player::addCards(const QVector<Card>& cards)
 {
     // 在手牌数组中加入cards
     m_handCards.append(cards);
-    // 整理手牌
-    std::sort(m_handCards.begin(), m_handCards.end());
+    m_handSet.add(cards);
+    // 整理手牌(按级牌查表排序)
+    std::sort(m_handCards.begin(), m_handCards.end(), getLevelContext().less());
     // 发送手牌更新信号
     emit cardsUpdated();
 }
@@ -46,28 +48,62 @@ void Player::removeCards(const QVector<Card>& cards)
     for (const auto& card : cards) {
         // 将 removeAll 修改为 removeOne
         // 这样每次循环只会从手牌中移除一张匹配的牌
-        m_handCards.removeOne(card);
+        // 先在计数矩阵中O(1)判断，手牌中没有的牌不必扫描数组
+        if (m_handSet.remove(card)) {
+            m_handCards.removeOne(card);
+        }
     }
     // 原本就是有序的，不需要整理
     // 发出手牌更新信号
     emit cardsUpdated();
 }
 
-QVector<Card> Player::getHandCards() const
+const QVector<Card>& Player::getHandCards() const
 {
     return m_handCards;
 }
 
+const CardSet& Player::getHandSet() const
+{
+    return m_handSet;
+}
+
+bool Player::hasCards(const QVector<Card>& cards) const
+{
+    return m_handSet.containsAll(CardSet(cards));
+}
+
+int Player::getWildCardCount() const
+{
+    return m_handSet.wildCount(getLevelContext());
+}
+
+Card Player::getLargestCard() const
+{
+    Card card;
+    m_handSet.highestCard(getLevelContext(), card, const_cast<Player*>(this));
+    return card;
+}
+
+Card Player::getSmallestCard() const
+{
+    Card card;
+    m_handSet.lowestCard(getLevelContext(), card, const_cast<Player*>(this));
+    return card;
+}
+
 void Player::setHandCards(const QVector<Card>& cards)
 {
     m_handCards = cards;
-    // 整理手牌
-    std::sort(m_handCards.begin(), m_handCards.end());
+    m_handSet = CardSet(cards);
+    // 整理手牌(按级牌查表排序)
+    std::sort(m_handCards.begin(), m_handCards.end(), getLevelContext().less());
 }
 
 void Player::clearHandCards()
 {
     m_handCards.clear();
+    m_handSet.clear();
     emit cardsUpdated();
 }
 
@@ -81,6 +117,12 @@ Team* Player::getTeam() const
     return m_team;
 }
 
+LevelContext Player::getLevelContext() const
+{
+    // 没有队伍时按2级处理(与Card::getCurrentOwnerLevelRank的回退值一致)，但不打印警告
+    return LevelContext(m_team ? m_team->getCurrentLevelRank() : Card::Card_2);
+}
+
 void Player::setReady(bool ready)
 {
     m_isReady = ready;
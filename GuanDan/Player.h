@@ -4,10 +4,11 @@
 #include <QObject>
 #include <QVector>
 #include "Card.h"
+#include "CardSet.h"
+#include "LevelContext.h"
 #include "Cardcombo.h"
 
 class Team;
-class GD_Controller;
 
 class Player : public QObject
 {
@@ -33,12 +34,18 @@ public:
     void addCards(const QVector<Card>& cards);
     void removeCards(const QVector<Card>& cards);
     void clearHandCards(); // 清空所有手牌
-    QVector<Card> getHandCards() const;
+    const QVector<Card>& getHandCards() const; // 只读引用，不复制手牌
     void setHandCards(const QVector<Card>& cards);  // 设置手牌
+    const CardSet& getHandSet() const; // 手牌的计数矩阵表示，随手牌同步更新
+    bool hasCards(const QVector<Card>& cards) const; // 判断手牌是否包含这些牌(按张数计)
+    int getWildCardCount() const; // 手牌中的癞子数，O(1)
+    Card getLargestCard() const;  // 按当前级牌顺序最大的手牌，O(1)，手牌为空时返回默认牌
+    Card getSmallestCard() const; // 按当前级牌顺序最小的手牌，O(1)，手牌为空时返回默认牌
 
     // 所属队伍
     void setTeam(Team* team);
     Team* getTeam() const;
+    LevelContext getLevelContext() const; // 所属队伍当前级牌的比较上下文
 
     // 游戏状态
     void setReady(bool ready);
@@ -47,9 +54,6 @@ public:
     // 出牌验证（调用CardCombo类）
     bool canPlayCards(const QVector<Card>& cards, CardCombo::ComboInfo& current_table) const;
 
-    // 玩家回合自动行为：默认无操作，人类等待UI，AI在子类中重写出牌逻辑
-    virtual void autoPlay(GD_Controller* controller, const CardCombo::ComboInfo& currentTableCombo) { }
-
 signals:
     void cardsUpdated(); // 手牌变化信号
     void playerReady(bool isReady); // 准备状态变化信号
@@ -60,6 +64,7 @@ private:
     int m_id; // 玩家id
 
     QVector<Card> m_handCards;    // 手牌
+    CardSet m_handSet;            // 手牌计数矩阵，与m_handCards保持一致
     Team* m_team = nullptr;       // 所属队伍
     bool m_isReady = false;       // 是否准备就绪
 };
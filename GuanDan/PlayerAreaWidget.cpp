@@ -196,9 +196,9 @@ void PlayerAreaWidget::updateHandDisplay(const QVector<Card>& cards, bool showFr
     m_playerWidget->updateHandDisplay(cards, showFront);
 }
 
-void PlayerAreaWidget::updateHandDisplayNoAnimation(const QVector<Card>& cards, bool showFront)
+void PlayerAreaWidget::applyHandDelta(const QVector<Card>& added, const QVector<Card>& removed, bool showFront)
 {
-    m_playerWidget->updateHandDisplayNoAnimation(cards, showFront);
+    m_playerWidget->applyHandDelta(added, removed, showFront);
 }
 
 void PlayerAreaWidget::selectCards(const QVector<Card>& cardsToSelect)
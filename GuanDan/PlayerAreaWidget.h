@@ -36,7 +36,7 @@ public:
     
     // 手牌显示更新方法
     void updateHandDisplay(const QVector<Card>& cards, bool showFront);
-    void updateHandDisplayNoAnimation(const QVector<Card>& cards, bool showFront);
+    void applyHandDelta(const QVector<Card>& added, const QVector<Card>& removed, bool showFront);
     void selectCards(const QVector<Card>& cardsToSelect);
 
     // 获取内部控件
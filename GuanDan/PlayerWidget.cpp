@@ -603,33 +603,49 @@ void PlayerWidget::updateHandDisplay(const QVector<Card>& handCards, bool showCa
     qDebug() << "手牌显示更新完成 - 创建了" << m_cardWidgets.size() << "个卡片控件";
 }
 
-void PlayerWidget::updateHandDisplayNoAnimation(const QVector<Card>& handCards, bool showCardFronts)
+// 按增量更新手牌显示：只删除和创建变化的卡片控件，其余控件保持不变
+void PlayerWidget::applyHandDelta(const QVector<Card>& added, const QVector<Card>& removed, bool showCardFronts)
 {
-    qDebug() << "PlayerWidget::updateHandDisplayNoAnimation - 玩家:" << (m_player ? m_player->getName() : "无名")
-             << "卡牌数量:" << handCards.size()
-             << "显示正面:" << showCardFronts;
+    qDebug() << "PlayerWidget::applyHandDelta - 玩家:" << (m_player ? m_player->getName() : "无名")
+             << "新增:" << added.size() << "移除:" << removed.size();
     // 停止所有动画
     stopAllAnimations();
 
-    // 清理现有卡片
-    qDeleteAll(m_cardWidgets);
-    m_cardWidgets.clear();
-    m_cardStacks.clear();
+    // 移除卡片：只在同点数的堆叠中查找
+    for (const Card& card : removed) {
+        auto stackIt = m_cardStacks.find(card.point());
+        if (stackIt == m_cardStacks.end()) continue;
+        QVector<CardWidget*>& stack = stackIt.value();
+        for (int i = 0; i < stack.size(); ++i) {
+            if (stack[i]->getCard() == card) {
+                CardWidget* widget = stack[i];
+                stack.removeAt(i);
+                if (stack.isEmpty()) {
+                    m_cardStacks.erase(stackIt);
+                }
+                m_cardWidgets.removeOne(widget);
+                delete widget;
+                break;
+            }
+        }
+    }
 
-    // 创建新的卡片视图
-    for (const Card& card : handCards) {
+    // 新增卡片
+    for (const Card& card : added) {
         CardWidget* cardWidget = createCardWidget(card);
         cardWidget->setFrontSide(showCardFronts);
         cardWidget->setEnabled(m_isEnabled && showCardFronts);
         m_cardWidgets.append(cardWidget);
         m_cardStacks[card.point()].append(cardWidget);
     }
+    if (!added.isEmpty()) {
+        sortCards();
+    }
 
-    // 对卡片进行排序并静态布局
-    sortCards();
+    // 与整体刷新一致，更新后不保留选中状态
+    clearSelection();
     relayoutCardsStatic();
-
-    qDebug() << "手牌静态更新完成 - 总计:" << m_cardWidgets.size() << "张牌";
+    updatePlayerInfo();
 }
 
 // 添加静态布局函数，无动画
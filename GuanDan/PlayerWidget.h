@@ -66,7 +66,7 @@ public:
 
     // 显示更新
     void updateHandDisplay(const QVector<Card>& cards, bool showFront);
-    void updateHandDisplayNoAnimation(const QVector<Card>& cards, bool showFront);
+    void applyHandDelta(const QVector<Card>& added, const QVector<Card>& removed, bool showFront); // 只增删变化的卡片控件
     void displayPlayedCombo(const QVector<Card>& cards);
     void clearPlayedCardsArea();
 
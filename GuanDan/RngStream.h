@@ -0,0 +1,102 @@
+#ifndef RNGSTREAM_H
+#define RNGSTREAM_H
+
+// RngStream: 可设种子、可分流的随机数流，发牌、首出和AI搜索都从这里取随机数
+// 生成器为xoshiro256**，种子经SplitMix64展开为状态
+// split(key)由本流的种子和key派生出一条独立的子流，不消耗本流的状态：子流只取决于(种子, key)，
+// 因此每场比赛、每局、每个搜索线程各取一条子流时，取用的先后和线程调度都不影响结果，同一种子可以逐位重放整场比赛
+// bounded和shuffle不经过std::的分布和std::shuffle(其结果随标准库实现而不同)，不同编译器下结果一致
+
+#include <QtGlobal>
+#include <utility>
+
+class RngStream
+{
+public:
+    using result_type = quint64;
+
+    explicit RngStream(quint64 seed = 0)
+        : m_seed(seed)
+    {
+        quint64 x = seed;
+        for (quint64& word : m_state) {
+            word = splitMix64(x);
+        }
+    }
+
+    quint64 seed() const { return m_seed; }
+
+    // 由(种子, key)派生的子流
+    // 种子和key各自混合后再整体混合一次：若只把key的散列异或到种子上，split(a).split(b)与split(b).split(a)
+    // 会是同一条流，不同比赛的子流之间会出现相关
+    RngStream split(quint64 key) const
+    {
+        quint64 x = m_seed;
+        quint64 y = key ^ 0x6A09E667F3BCC909ULL;
+        quint64 z = splitMix64(x) ^ rotl(splitMix64(y), 23);
+        return RngStream(splitMix64(z));
+    }
+
+    quint64 next()
+    {
+        const quint64 result = rotl(m_state[1] * 5, 7) * 9;
+        const quint64 t = m_state[1] << 17;
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotl(m_state[3], 45);
+        return result;
+    }
+
+    quint32 next32() { return static_cast<quint32>(next() >> 32); }
+
+    // [0, bound)内均匀分布的整数(Lemire的乘法取高位，拒绝采样消除偏差)，bound<=0时返回0
+    int bounded(int bound)
+    {
+        if (bound <= 0) return 0;
+        const quint32 range = static_cast<quint32>(bound);
+        quint64 product = static_cast<quint64>(next32()) * range;
+        quint32 low = static_cast<quint32>(product);
+        if (low < range) {
+            const quint32 threshold = (0u - range) % range;
+            while (low < threshold) {
+                product = static_cast<quint64>(next32()) * range;
+                low = static_cast<quint32>(product);
+            }
+        }
+        return static_cast<int>(product >> 32);
+    }
+
+    // Fisher-Yates洗牌
+    template <typename Iterator>
+    void shuffle(Iterator first, Iterator last)
+    {
+        const int count = static_cast<int>(last - first);
+        for (int i = count - 1; i > 0; --i) {
+            std::swap(first[i], first[bounded(i + 1)]);
+        }
+    }
+
+    // 满足UniformRandomBitGenerator，可直接交给std::的算法(结果随标准库实现而不同)
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+    result_type operator()() { return next(); }
+
+private:
+    static quint64 rotl(quint64 x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    static quint64 splitMix64(quint64& x)
+    {
+        quint64 z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    quint64 m_seed;
+    quint64 m_state[4];
+};
+
+#endif // RNGSTREAM_H
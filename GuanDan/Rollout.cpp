@@ -0,0 +1,157 @@
+#include "Rollout.h"
+
+#include <algorithm>
+
+namespace {
+
+    const int kMaxRolloutSteps = 400; // 单次模拟的出牌步数上限(防止异常局面死循环)
+    const int kBombThreshold = 8;     // 桌面牌的出牌者剩余张数不超过该值时，模拟中才用炸弹去压
+
+    void clearTable(Rollout::SimState& st)
+    {
+        st.tableType = CardComboType::Invalid;
+        st.tableLevel = -1;
+        st.tableOwner = -1;
+    }
+
+    // 轮到下一位仍在打牌的玩家；其他人都没有压过、轮回到出牌者时开始新的一圈
+    void advance(Rollout::SimState& st)
+    {
+        for (int i = 0; i < Rollout::SEAT_COUNT; ++i) {
+            st.toMove = (st.toMove + 1) % Rollout::SEAT_COUNT;
+            if (st.left[st.toMove] > 0) break;
+        }
+        if (st.toMove == st.tableOwner) clearTable(st);
+    }
+
+} // namespace
+
+namespace Rollout {
+
+    SimState fromSituation(const Situation& situation, const LevelContext& ctx)
+    {
+        SimState st;
+        st.finished = 0;
+        for (int seat : situation.finishOrder) {
+            if (st.finished < SEAT_COUNT) st.finishOrder[st.finished++] = seat;
+        }
+        for (int s = 0; s < SEAT_COUNT; ++s) {
+            st.hands[s] = ComboCatalog::HandCounts();
+            st.left[s] = situation.handCounts[s];
+        }
+        st.hands[situation.seat] = ComboCatalog::HandCounts::fromHand(situation.hand, ctx);
+        st.left[situation.seat] = situation.hand.size();
+        st.toMove = situation.seat;
+        st.tableType = situation.tableType;
+        st.tableLevel = situation.tableLevel;
+        st.tableOwner = situation.tableType == CardComboType::Invalid ? -1 : situation.tableOwner;
+        return st;
+    }
+
+    QVector<Card> unseenCards(const Situation& situation)
+    {
+        CardSet unseen;
+        for (int deck = 0; deck < 2; ++deck) {
+            for (int r = 0; r < CardSet::RANK_COUNT - 2; ++r) {
+                for (int s = Card::Diamond; s <= Card::Spade; ++s) {
+                    unseen.add(Card(CardSet::rankAt(r), static_cast<Card::CardSuit>(s)));
+                }
+            }
+            unseen.add(Card(Card::Card_LJ, Card::Joker));
+            unseen.add(Card(Card::Card_BJ, Card::Joker));
+        }
+        unseen.remove(situation.hand);
+        for (const Card& card : situation.playedCards) unseen.remove(card);
+        return unseen.toCards();
+    }
+
+    void deal(SimState& st, QVector<Card>& deck, const Situation& situation, const LevelContext& ctx, RngStream& rng)
+    {
+        rng.shuffle(deck.begin(), deck.end());
+
+        int next = 0;
+        for (int s = 0; s < SEAT_COUNT; ++s) {
+            if (s == situation.seat) continue;
+            const int n = qMin(situation.handCounts[s], static_cast<int>(deck.size()) - next);
+            st.hands[s] = ComboCatalog::HandCounts::fromHand(CardSet(deck.mid(next, n)), ctx);
+            st.left[s] = n;
+            next += n;
+        }
+    }
+
+    bool isSettled(const SimState& st)
+    {
+        if (st.finished >= SEAT_COUNT - 1) return true;
+        return st.finished == 2 && st.finishOrder[1] == partnerOf(st.finishOrder[0]);
+    }
+
+    double outcomeScore(const SimState& st, int seat)
+    {
+        if (st.finished == 0) return 0.0;
+        const int first = st.finishOrder[0];
+        int partnerPlace = SEAT_COUNT - 1;
+        for (int i = 1; i < st.finished; ++i) {
+            if (st.finishOrder[i] == partnerOf(first)) partnerPlace = i;
+        }
+        const double score = 4 - partnerPlace;
+        return (first == seat || first == partnerOf(seat)) ? score : -score;
+    }
+
+    void play(SimState& st, int type, int level, int cardCount)
+    {
+        const int seat = st.toMove;
+        st.left[seat] = qMax(0, st.left[seat] - cardCount);
+        st.tableType = type;
+        st.tableLevel = level;
+        st.tableOwner = seat;
+
+        // 出完牌后本圈立即结束，由下家开始新的一圈
+        if (st.left[seat] == 0) {
+            st.finishOrder[st.finished++] = seat;
+            clearTable(st);
+        }
+        advance(st);
+    }
+
+    void pass(SimState& st)
+    {
+        advance(st);
+    }
+
+    const ComboCatalog::Entry* fastPolicy(const ComboCatalog& catalog, const SimState& st)
+    {
+        const int seat = st.toMove;
+        if (st.tableType == CardComboType::Invalid) {
+            return catalog.cheapestBeat(st.hands[seat], CardComboType::Invalid, -1);
+        }
+        if (st.tableOwner == partnerOf(seat)) return nullptr;
+
+        const ComboCatalog::Entry* entry = catalog.cheapestBeat(st.hands[seat], st.tableType, st.tableLevel);
+        if (entry && entry->type == CardComboType::Bomb && st.tableType != CardComboType::Bomb) {
+            const bool urgent = st.tableOwner >= 0 && st.left[st.tableOwner] <= kBombThreshold;
+            if (!urgent && entry->cardCount != st.left[seat]) return nullptr;
+        }
+        return entry;
+    }
+
+    void playOut(const ComboCatalog& catalog, SimState& st)
+    {
+        for (int step = 0; step < kMaxRolloutSteps && !isSettled(st); ++step) {
+            const ComboCatalog::Entry* entry = fastPolicy(catalog, st);
+            if (!entry) {
+                if (st.tableType == CardComboType::Invalid) break; // 领出却无牌可出，手牌计数异常
+                pass(st);
+                continue;
+            }
+            catalog.consume(*entry, st.hands[st.toMove]);
+            play(st, entry->type, entry->level, entry->cardCount);
+        }
+    }
+
+    QThreadPool& threadPool()
+    {
+        static QThreadPool pool;
+        return pool;
+    }
+
+} // namespace Rollout
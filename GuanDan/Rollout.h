@@ -0,0 +1,136 @@
+#ifndef ROLLOUT_H
+#define ROLLOUT_H
+
+// Rollout: 搜索AI(PimcSearch、IsmctsSearch)共用的局面表示和快速对局模拟
+// 各家手牌用牌型目录的计数视图表示，出牌为目录项；模拟规则与GD_Controller一致：
+// 出完牌后本圈立即结束并由下家领出，其他人都不压时由出牌者开始新的一圈
+
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QVector>
+#include <QtGlobal>
+#include <atomic>
+
+#include "Card.h"
+#include "CardSet.h"
+#include "ComboCatalog.h"
+#include "LevelContext.h"
+#include "RngStream.h"
+
+namespace Rollout {
+
+    const int SEAT_COUNT = 4; // 座位0~3按出牌顺序排列，对家为(seat+2)%4
+
+    inline int partnerOf(int seat) { return (seat + 2) % SEAT_COUNT; }
+
+    // 决策者可见的局面(不包含其他玩家的手牌)
+    struct Situation {
+        int seat = 0;                          // 决策者座位
+        Card::CardPoint levelRank = Card::Card_2;
+        CardSet hand;                          // 决策者手牌
+        QVector<Card> playedCards;             // 本局已打出的所有牌
+        int handCounts[SEAT_COUNT] = { 0, 0, 0, 0 }; // 各座位剩余手牌张数
+        QVector<int> finishOrder;              // 本局已出完牌的座位，按名次排列
+        int tableType = -1;                    // 桌面牌型，领出时为Invalid
+        int tableLevel = -1;
+        int tableOwner = -1;                   // 桌面牌的出牌者，领出时为-1
+    };
+
+    // 一次搜索选牌的统计，由NPCPlayer::getSearchPlay填写，自对弈按策略汇总后报告，用于确定搜索的线程数
+    struct SearchStats {
+        enum Kind { None, Pimc, Ismcts, Endgame };
+        Kind kind = None;              // 实际使用的搜索，不需要比较出牌时为None
+        bool searched = true;          // 预算内一次模拟都没有完成、退回启发式选牌时为false
+        double playoutsPerSecond = 0;  // 以下为IsmctsSearch的统计
+        int treeNodes = 0;
+        bool treeFull = false;
+        double nodesPerSecond = 0;     // 以下为EndgameSolver的统计
+        double solveMs = 0;            // 平均每次确定化的求解耗时(毫秒)
+        bool exact = false;
+    };
+
+    // 决策者的候选出牌：cards为空表示过牌
+    struct Candidate {
+        QVector<Card> cards;
+        int type = -1;
+        int level = -1;
+    };
+
+    // 一次模拟中的完整局面
+    struct SimState {
+        ComboCatalog::HandCounts hands[SEAT_COUNT];
+        int left[SEAT_COUNT];                  // 各家剩余张数
+        int finishOrder[SEAT_COUNT];
+        int finished;
+        int toMove;                            // 轮到出牌的座位
+        int tableType;
+        int tableLevel;
+        int tableOwner;
+    };
+
+    // 由可见局面建立模拟局面(其他三家的手牌留空，由deal补全)
+    SimState fromSituation(const Situation& situation, const LevelContext& ctx);
+
+    // 其他三家手牌的并集：两副牌 - 决策者手牌 - 已打出的牌
+    QVector<Card> unseenCards(const Situation& situation);
+
+    // 一次确定化：打乱deck后按剩余张数分给决策者以外仍在打牌的玩家
+    void deal(SimState& st, QVector<Card>& deck, const Situation& situation, const LevelContext& ctx, RngStream& rng);
+
+    // 名次已经能确定得分：三家出完，或头游的对家已经出完
+    bool isSettled(const SimState& st);
+
+    // 名次得分(与升级数一致)：头游和对家为一、二名得3，一、三名得2，一、四名得1；对方头游时取负
+    double outcomeScore(const SimState& st, int seat);
+
+    // 轮到toMove的玩家出牌：扣除张数、更新桌面并轮到下家(手牌计数由调用者扣除)
+    void play(SimState& st, int type, int level, int cardCount);
+    // 轮到toMove的玩家过牌
+    void pass(SimState& st);
+
+    // 快速策略：领出时出最便宜的牌型；跟牌时不压对家，用最便宜的牌压对手，
+    // 只有对手快出完或自己能一手出完时才动用炸弹；返回nullptr表示过牌
+    const ComboCatalog::Entry* fastPolicy(const ComboCatalog& catalog, const SimState& st);
+
+    // 从当前局面用快速策略打到名次确定为止
+    void playOut(const ComboCatalog& catalog, SimState& st);
+
+    // 搜索专用的线程池，与Qt全局线程池分开，避免被其他任务占满
+    QThreadPool& threadPool();
+
+    // 一次搜索的时间预算：从第一个工作线程实际开始运行时计时，而不是从提交时计时，
+    // 线程池正被其他搜索占用时，任务在队列中等待的时间不计入预算
+    class SearchBudget
+    {
+    public:
+        explicit SearchBudget(int budgetMs)
+            : m_budgetNs(qint64(qMax(1, budgetMs)) * 1000000)
+        {
+            m_clock.start();
+        }
+
+        // 工作线程开始运行时调用，只有第一次调用开始计时
+        void begin()
+        {
+            qint64 expected = -1;
+            m_startNs.compare_exchange_strong(expected, m_clock.nsecsElapsed());
+        }
+
+        // 开始计时后经过的时间(纳秒)，尚未开始时为0
+        qint64 elapsedNs() const
+        {
+            const qint64 start = m_startNs.load();
+            return start < 0 ? 0 : m_clock.nsecsElapsed() - start;
+        }
+        qint64 elapsedMs() const { return elapsedNs() / 1000000; }
+        bool expired() const { return elapsedNs() >= m_budgetNs; }
+
+    private:
+        QElapsedTimer m_clock;
+        std::atomic<qint64> m_startNs{ -1 };
+        const qint64 m_budgetNs;
+    };
+
+} // namespace Rollout
+
+#endif // ROLLOUT_H
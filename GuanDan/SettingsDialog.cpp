@@ -10,7 +10,7 @@ SettingsDialog::SettingsDialog(QWidget* parent)
     , m_currentVolume(SoundManager::instance().getVolume())
 {
     setWindowTitle(tr("游戏设置"));
-    setFixedSize(300, 250);  // 增加高度以容纳新设置
+    setFixedSize(300, 310);  // 增加高度以容纳新设置
 
     // 移除窗口标题栏的问号（帮助）按钮
     setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
@@ -32,6 +32,20 @@ SettingsDialog::SettingsDialog(QWidget* parent)
     m_durationSpinBox->setSingleStep(5);
     m_durationSpinBox->setValue(SettingsManager::loadTurnDuration());
 
+    // 创建AI难度设置
+    m_difficultyComboBox = new QComboBox(this);
+    m_difficultyComboBox->addItem(tr("普通"), SettingsManager::AiNormal);
+    m_difficultyComboBox->addItem(tr("困难"), SettingsManager::AiHard);
+    m_difficultyComboBox->addItem(tr("专家"), SettingsManager::AiExpert);
+    m_difficultyComboBox->setCurrentIndex(m_difficultyComboBox->findData(SettingsManager::loadAiDifficulty()));
+
+    // 创建AI思考时间设置(只对困难和专家AI生效)
+    m_thinkTimeSpinBox = new QSpinBox(this);
+    m_thinkTimeSpinBox->setRange(50, 5000);
+    m_thinkTimeSpinBox->setSuffix(" 毫秒");
+    m_thinkTimeSpinBox->setSingleStep(50);
+    m_thinkTimeSpinBox->setValue(SettingsManager::loadAiThinkTime());
+
     // 创建按钮
     m_confirmButton = new QPushButton(tr("确认"), this);
     m_confirmButton->setFixedSize(80, 30);
@@ -44,6 +58,8 @@ SettingsDialog::SettingsDialog(QWidget* parent)
     QVBoxLayout* mainLayout = new QVBoxLayout(this);
     QHBoxLayout* volumeLayout = new QHBoxLayout();
     QHBoxLayout* durationLayout = new QHBoxLayout();
+    QHBoxLayout* difficultyLayout = new QHBoxLayout();
+    QHBoxLayout* thinkTimeLayout = new QHBoxLayout();
     QHBoxLayout* buttonLayout = new QHBoxLayout(); // 新增按钮布局
     
     volumeLayout->addWidget(new QLabel(tr("音量："), this));
@@ -52,6 +68,12 @@ SettingsDialog::SettingsDialog(QWidget* parent)
 
     durationLayout->addWidget(new QLabel(tr("出牌时间："), this));
     durationLayout->addWidget(m_durationSpinBox);
+
+    difficultyLayout->addWidget(new QLabel(tr("AI难度："), this));
+    difficultyLayout->addWidget(m_difficultyComboBox);
+
+    thinkTimeLayout->addWidget(new QLabel(tr("AI思考时间："), this));
+    thinkTimeLayout->addWidget(m_thinkTimeSpinBox);
     
     // 将按钮添加到按钮布局
     buttonLayout->addStretch();
@@ -61,6 +83,8 @@ SettingsDialog::SettingsDialog(QWidget* parent)
 
     mainLayout->addLayout(volumeLayout);
     mainLayout->addLayout(durationLayout);
+    mainLayout->addLayout(difficultyLayout);
+    mainLayout->addLayout(thinkTimeLayout);
     mainLayout->addStretch(); // 添加弹性空间
     mainLayout->addLayout(buttonLayout); // 添加按钮布局
 
@@ -81,6 +105,8 @@ void SettingsDialog::onConfirmClicked()
 {
     SettingsManager::saveVolume(m_currentVolume);
     SettingsManager::saveTurnDuration(m_durationSpinBox->value());
+    SettingsManager::saveAiDifficulty(m_difficultyComboBox->currentData().toInt());
+    SettingsManager::saveAiThinkTime(m_thinkTimeSpinBox->value());
     accept();
 }
 
@@ -5,6 +5,7 @@
 #include <QLabel>
 #include <QPushButton>
 #include <QSpinBox>
+#include <QComboBox>
 
 class SettingsDialog : public QDialog
 {
@@ -25,5 +26,7 @@ private:
     QPushButton* m_rulesButton;
     int m_currentVolume;
     QSpinBox* m_durationSpinBox;
+    QComboBox* m_difficultyComboBox;
+    QSpinBox* m_thinkTimeSpinBox;
 };
 
@@ -43,3 +43,60 @@ int SettingsManager::loadTurnDuration()
     delete settings;
     return duration;
 }
+
+void SettingsManager::saveAiDifficulty(int difficulty)
+{
+    QSettings* settings = createSettings();
+    settings->setValue("AI/Difficulty", difficulty);
+    delete settings;
+}
+
+int SettingsManager::loadAiDifficulty()
+{
+    QSettings* settings = createSettings();
+    int difficulty = settings->value("AI/Difficulty", AiNormal).toInt(); // 默认普通难度
+    delete settings;
+    return difficulty;
+}
+
+void SettingsManager::saveAiThinkTime(int milliseconds)
+{
+    QSettings* settings = createSettings();
+    settings->setValue("AI/ThinkTimeMs", milliseconds);
+    delete settings;
+}
+
+int SettingsManager::loadAiThinkTime()
+{
+    QSettings* settings = createSettings();
+    // 默认每步300毫秒
+    int milliseconds = settings->value("AI/ThinkTimeMs", 300).toInt();
+    delete settings;
+    return milliseconds;
+}
+
+int SettingsManager::loadAiThreadCount()
+{
+    QSettings* settings = createSettings();
+    int threads = settings->value("AI/Threads", 0).toInt();
+    delete settings;
+    return threads;
+}
+
+int SettingsManager::loadAiHashSize()
+{
+    QSettings* settings = createSettings();
+    // 默认16MB
+    int megabytes = settings->value("AI/HashMB", 16).toInt();
+    delete settings;
+    return megabytes;
+}
+
+bool SettingsManager::loadAiPonder()
+{
+    QSettings* settings = createSettings();
+    // 默认开启
+    bool ponder = settings->value("AI/Ponder", true).toBool();
+    delete settings;
+    return ponder;
+}
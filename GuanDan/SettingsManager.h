@@ -12,6 +12,16 @@ public:
     static void saveTurnDuration(int seconds);
     static int loadTurnDuration();
 
+    // AI难度：普通为启发式选牌，困难为确定化蒙特卡洛搜索，专家为信息集蒙特卡洛树搜索
+    enum AiDifficulty { AiNormal = 0, AiHard = 1, AiExpert = 2 };
+    static void saveAiDifficulty(int difficulty);
+    static int loadAiDifficulty();
+    static void saveAiThinkTime(int milliseconds); // 困难AI每步的搜索时间
+    static int loadAiThinkTime();
+    static int loadAiThreadCount(); // 搜索线程数，只在配置文件中设置，0表示按CPU核数
+    static int loadAiHashSize();    // 搜索置换表的大小(MB)，只在配置文件中设置，启动时生效
+    static bool loadAiPonder();     // 是否在其他玩家的回合预先思考，只在配置文件中设置
+
 private:
     SettingsManager() = delete; // 禁止实例化
     static QSettings* createSettings();
@@ -10,6 +10,11 @@ Team::Team(int id)
 {
 }
 
+Team::~Team()
+{
+    // 玩家由外部管理，这里不释放
+}
+
 void Team::addPlayer(Player* player)
 {
     if (player && !m_players.contains(player)) {
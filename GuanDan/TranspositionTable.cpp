@@ -0,0 +1,106 @@
+#include "TranspositionTable.h"
+
+namespace {
+
+    const int kDefaultSizeMb = 16;
+    const quint64 kValidBit = 1ULL << 40; // 区分有效数据和全零的空槽
+    const quint64 kFillSample = 65536;     // 估计填充率时检查的槽数(键的低位均匀分布，取表头即可)
+
+    std::atomic<int> g_sharedSizeMb{ kDefaultSizeMb };
+
+    // 数据字：value(8位) | bound(8位) | bestMove(16位) | 有效位
+    quint64 pack(const TranspositionTable::Entry& entry)
+    {
+        return static_cast<quint64>(static_cast<quint8>(entry.value))
+            | (static_cast<quint64>(entry.bound & 0xFF) << 8)
+            | (static_cast<quint64>(static_cast<quint16>(entry.bestMove)) << 16)
+            | kValidBit;
+    }
+
+    TranspositionTable::Entry unpack(quint64 data)
+    {
+        TranspositionTable::Entry entry;
+        entry.value = static_cast<qint8>(data & 0xFF);
+        entry.bound = static_cast<int>((data >> 8) & 0xFF);
+        entry.bestMove = static_cast<qint16>((data >> 16) & 0xFFFF);
+        return entry;
+    }
+
+} // namespace
+
+TranspositionTable::TranspositionTable(int sizeMb)
+{
+    const quint64 bytes = static_cast<quint64>(qMax(1, sizeMb)) << 20;
+    quint64 slotCount = 1;
+    while (slotCount * 2 * sizeof(Slot) <= bytes) slotCount *= 2;
+    m_slots.reset(new Slot[slotCount]()); // 值初始化，所有槽为零
+    m_mask = slotCount - 1;
+    m_sizeMb = static_cast<int>((slotCount * sizeof(Slot)) >> 20);
+}
+
+bool TranspositionTable::probe(quint64 key, Entry& out) const
+{
+    const Slot& slot = m_slots[key & m_mask];
+    const quint64 data = slot.data.load(std::memory_order_relaxed);
+    const quint64 check = slot.check.load(std::memory_order_relaxed);
+    if (!(data & kValidBit) || (check ^ data) != key) return false;
+    out = unpack(data);
+    return true;
+}
+
+void TranspositionTable::store(quint64 key, const Entry& entry)
+{
+    Slot& slot = m_slots[key & m_mask];
+    const quint64 data = pack(entry);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear()
+{
+    for (quint64 i = 0; i <= m_mask; ++i) {
+        m_slots[i].check.store(0, std::memory_order_relaxed);
+        m_slots[i].data.store(0, std::memory_order_relaxed);
+    }
+    resetStats();
+}
+
+void TranspositionTable::recordProbes(qint64 probes, qint64 hits)
+{
+    m_probes.fetch_add(probes, std::memory_order_relaxed);
+    m_hits.fetch_add(hits, std::memory_order_relaxed);
+}
+
+TranspositionTable::Stats TranspositionTable::stats() const
+{
+    Stats stats;
+    stats.probes = m_probes.load(std::memory_order_relaxed);
+    stats.hits = m_hits.load(std::memory_order_relaxed);
+    stats.hitRate = stats.probes > 0 ? double(stats.hits) / stats.probes : 0.0;
+    stats.slotCount = static_cast<qint64>(m_mask + 1);
+    stats.sizeMb = m_sizeMb;
+    const quint64 sample = qMin(kFillSample, m_mask + 1);
+    quint64 used = 0;
+    for (quint64 i = 0; i < sample; ++i) {
+        if (m_slots[i].data.load(std::memory_order_relaxed) & kValidBit) ++used;
+    }
+    stats.fillRate = double(used) / sample;
+    return stats;
+}
+
+void TranspositionTable::resetStats()
+{
+    m_probes.store(0, std::memory_order_relaxed);
+    m_hits.store(0, std::memory_order_relaxed);
+}
+
+void TranspositionTable::configureShared(int sizeMb)
+{
+    g_sharedSizeMb.store(qMax(1, sizeMb));
+}
+
+TranspositionTable& TranspositionTable::shared()
+{
+    static TranspositionTable table(g_sharedSizeMb.load());
+    return table;
+}
@@ -0,0 +1,62 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+// TranspositionTable: 搜索共用的置换表，大小固定，多线程无锁读写
+// 按Zobrist键(见Zobrist.h)的低位定位槽，每槽两个64位字：数据和"键^数据"；
+// 读出时用键^数据还原键来校验，两个线程同时写同一槽造成的撕裂写入会因校验不通过而当作未命中
+// 新结果总是覆盖旧结果；键包含全部手牌、得分视角和级牌，不同确定化、不同决策以及各局、各场比赛之间可以放心共用
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+class TranspositionTable
+{
+public:
+    enum Bound { Exact = 0, Lower = 1, Upper = 2 }; // 得分为精确值/下界/上界
+
+    struct Entry {
+        int value = 0;
+        int bound = Exact;
+        int bestMove = -1;   // 搜索者自定义的走法编号(-32768~32767)
+    };
+
+    struct Stats {
+        qint64 probes = 0;
+        qint64 hits = 0;
+        double hitRate = 0;  // hits / probes
+        qint64 slotCount = 0;
+        int sizeMb = 0;
+        double fillRate = 0; // 已写入的槽所占比例，按表头部的若干槽估计
+    };
+
+    // sizeMb: 占用内存(MB)，按不超过该值的2的幂个槽分配
+    explicit TranspositionTable(int sizeMb);
+
+    bool probe(quint64 key, Entry& out) const;
+    void store(quint64 key, const Entry& entry);
+    void clear();
+
+    // 搜索者在本地计数后批量登记查询次数，避免每次查询都争用共享的计数器
+    void recordProbes(qint64 probes, qint64 hits);
+    Stats stats() const;
+    void resetStats();
+
+    // 所有搜索共用的表：大小在首次使用前由configureShared设置(程序启动时读取设置)，之后不再改变
+    static void configureShared(int sizeMb);
+    static TranspositionTable& shared();
+
+private:
+    struct Slot {
+        std::atomic<quint64> check; // key ^ data
+        std::atomic<quint64> data;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    quint64 m_mask = 0;
+    int m_sizeMb = 0;
+    std::atomic<qint64> m_probes{ 0 };
+    std::atomic<qint64> m_hits{ 0 };
+};
+
+#endif // TRANSPOSITIONTABLE_H
@@ -0,0 +1,125 @@
+#include "Zobrist.h"
+
+namespace {
+
+    const int kSeats = Rollout::SEAT_COUNT;
+    const int kRanks = 16;          // 与RankVector的长度一致
+    const int kMaxNatural = 8;      // 两副牌中一种点数最多8张
+    const int kMaxPerSuit = 2;      // 一种点数、花色最多2张
+    const int kMaxWilds = 2;        // 癞子(红桃级牌)最多2张
+    const int kTypeSlots = CardComboType::Bomb + 2; // 牌型Invalid(-1)~Bomb
+
+    quint64 splitMix(quint64& state)
+    {
+        quint64 z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    struct Keys {
+        quint64 natural[kSeats][kRanks][kMaxNatural + 1];
+        quint64 bySuit[kSeats][4][kRanks][kMaxPerSuit + 1];
+        quint64 wilds[kSeats][kMaxWilds + 1];
+        quint64 tableType[kTypeSlots];
+        quint64 leader[kSeats + 1];       // 下标0为没有圈首
+        quint64 passed[1 << kSeats];
+        quint64 toMove[kSeats];
+        quint64 finish[kSeats][kSeats];   // [名次][座位]
+        quint64 perspective[2];
+        quint64 levelSeed;
+        quint64 level[kRanks];            // 本局级牌
+
+        Keys()
+        {
+            quint64 state = 0x5EED0F6A0DA11ULL;
+            for (auto& seat : natural) for (auto& rank : seat) for (quint64& k : rank) k = splitMix(state);
+            for (auto& seat : bySuit) for (auto& suit : seat) for (auto& rank : suit) for (quint64& k : rank) k = splitMix(state);
+            for (auto& seat : wilds) for (quint64& k : seat) k = splitMix(state);
+            for (quint64& k : tableType) k = splitMix(state);
+            for (quint64& k : leader) k = splitMix(state);
+            for (quint64& k : passed) k = splitMix(state);
+            for (quint64& k : toMove) k = splitMix(state);
+            for (auto& place : finish) for (quint64& k : place) k = splitMix(state);
+            for (quint64& k : perspective) k = splitMix(state);
+            levelSeed = splitMix(state);
+            for (quint64& k : level) k = splitMix(state);
+        }
+    };
+
+    const Keys kKeys;
+
+} // namespace
+
+namespace Zobrist {
+
+    quint64 handKey(int seat, const ComboCatalog::HandCounts& hand)
+    {
+        quint64 key = kKeys.wilds[seat][qMin(hand.wildCount, kMaxWilds)];
+        for (int r = 0; r < CardSet::RANK_COUNT; ++r) {
+            key ^= kKeys.natural[seat][r][hand.natural.counts[r]];
+            for (int s = 0; s < 4; ++s) key ^= kKeys.bySuit[seat][s][r][hand.bySuit[s].counts[r]];
+        }
+        return key;
+    }
+
+    quint64 handDelta(int seat, const ComboCatalog::HandCounts& before, const ComboCatalog::HandCounts& after,
+        const ComboCatalog::Entry& entry)
+    {
+        quint64 delta = 0;
+        if (before.wildCount != after.wildCount) {
+            delta ^= kKeys.wilds[seat][qMin(before.wildCount, kMaxWilds)] ^ kKeys.wilds[seat][qMin(after.wildCount, kMaxWilds)];
+        }
+        for (int r = 0; r < CardSet::RANK_COUNT; ++r) {
+            if (entry.need.counts[r] == 0) continue;
+            delta ^= kKeys.natural[seat][r][before.natural.counts[r]] ^ kKeys.natural[seat][r][after.natural.counts[r]];
+            for (int s = 0; s < 4; ++s) {
+                delta ^= kKeys.bySuit[seat][s][r][before.bySuit[s].counts[r]] ^ kKeys.bySuit[seat][s][r][after.bySuit[s].counts[r]];
+            }
+        }
+        return delta;
+    }
+
+    quint64 circleKey(int tableType, int tableLevel, int leaderId, int passedMask, int toMove)
+    {
+        quint64 key = kKeys.tableType[qBound(0, tableType + 1, kTypeSlots - 1)];
+        if (tableType != CardComboType::Invalid) {
+            quint64 state = kKeys.levelSeed ^ static_cast<quint64>(tableLevel);
+            key ^= splitMix(state);
+        }
+        key ^= kKeys.leader[leaderId >= 0 && leaderId < kSeats ? leaderId + 1 : 0];
+        key ^= kKeys.passed[passedMask & ((1 << kSeats) - 1)];
+        if (toMove >= 0 && toMove < kSeats) key ^= kKeys.toMove[toMove];
+        return key;
+    }
+
+    quint64 finishKey(const int* finishOrder, int finished)
+    {
+        quint64 key = 0;
+        for (int place = 0; place < finished && place < kSeats; ++place) key ^= kKeys.finish[place][finishOrder[place]];
+        return key;
+    }
+
+    quint64 perspectiveKey(int seat, Card::CardPoint levelRank)
+    {
+        return kKeys.perspective[seat % 2] ^ kKeys.level[qBound(0, static_cast<int>(levelRank), kRanks - 1)];
+    }
+
+    int passedMask(const Rollout::SimState& st)
+    {
+        if (st.tableOwner < 0) return 0;
+        int mask = 0;
+        for (int seat = (st.tableOwner + 1) % kSeats; seat != st.toMove && seat != st.tableOwner; seat = (seat + 1) % kSeats) {
+            if (st.left[seat] > 0) mask |= 1 << seat;
+        }
+        return mask;
+    }
+
+    quint64 positionKey(const Rollout::SimState& st, quint64 handKeys)
+    {
+        return handKeys
+            ^ circleKey(st.tableType, st.tableLevel, st.tableOwner, passedMask(st), st.toMove)
+            ^ finishKey(st.finishOrder, st.finished);
+    }
+
+} // namespace Zobrist
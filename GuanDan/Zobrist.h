@@ -0,0 +1,43 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+// Zobrist: 搜索局面的Zobrist键，供TranspositionTable使用
+// 手牌部分按(座位, 点数, 张数)、(座位, 花色, 点数, 张数)和(座位, 癞子数)各取一个随机数异或而成，
+// 打出一手牌后只需对涉及的点数做增量更新；一圈的状态(桌面牌型、圈首、已过牌的玩家、轮到的座位)和名次每步整体重算
+// 键的起点为得分视角和级牌(perspectiveKey)；随机数由固定种子生成，同一程序中各线程、各次搜索得到的键一致
+
+#include <QtGlobal>
+
+#include "ComboCatalog.h"
+#include "Rollout.h"
+
+namespace Zobrist {
+
+    // 一家手牌的键
+    quint64 handKey(int seat, const ComboCatalog::HandCounts& hand);
+
+    // seat打出entry后手牌键的增量(异或到原键上)：只比较entry涉及的点数和癞子数
+    quint64 handDelta(int seat, const ComboCatalog::HandCounts& before, const ComboCatalog::HandCounts& after,
+        const ComboCatalog::Entry& entry);
+
+    // 一圈的状态：桌面牌型和等级(领出时为Invalid)、圈首(桌面牌的出牌者，没有时为-1)、
+    // 本圈已过牌的玩家(按座位的位掩码)和轮到的座位；与GD_Controller的
+    // m_currentTableCombo、m_circleLeaderId、m_passedPlayersInCircle、m_currentPlayerId一一对应
+    quint64 circleKey(int tableType, int tableLevel, int leaderId, int passedMask, int toMove);
+
+    // 已出完牌的座位(按名次)
+    quint64 finishKey(const int* finishOrder, int finished);
+
+    // 得分视角和级牌：搜索得分从seat所在队伍看，两队的同一局面不能共用结果；
+    // 级牌不同时同样的手牌有不同的癞子和大小，置换表在各局、各场比赛之间共用，不同级牌的局面也不能共用结果
+    quint64 perspectiveKey(int seat, Card::CardPoint levelRank);
+
+    // 模拟局面中本圈已过牌的玩家：圈首之后、轮到的座位之前仍在打牌的座位
+    int passedMask(const Rollout::SimState& st);
+
+    // 由各家手牌键的异或handKeys(可增量维护)加上一圈的状态和名次得到完整键
+    quint64 positionKey(const Rollout::SimState& st, quint64 handKeys);
+
+} // namespace Zobrist
+
+#endif // ZOBRIST_H
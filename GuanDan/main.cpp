@@ -1,6 +1,7 @@
 #include "GuanDan.h"
 #include "SettingsManager.h"
 #include "SoundManager.h"
+#include "TranspositionTable.h"
 #include <QApplication>
 #include <QtCore>
 #include <QIcon>
@@ -17,6 +18,9 @@ int main(int argc, char *argv[])
     // 加载音量设置
     int volume = SettingsManager::loadVolume();
     SoundManager::instance().setVolume(volume);
+
+    // 设置AI搜索共用的置换表大小
+    TranspositionTable::configureShared(SettingsManager::loadAiHashSize());
     
     GuanDan w;
     w.show();
@@ -0,0 +1,389 @@
+#include "Replay.h"
+
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+
+#include "Cardcombo.h"
+#include "GameEngine.h"
+#include "GameRecord.h"
+#include "Player.h"
+#include "Team.h"
+
+namespace {
+
+    // 逐条执行记录的重放状态：一套引擎、玩家和队伍在各场比赛之间复用
+    class MatchReplayer
+    {
+    public:
+        MatchReplayer(const Replay::Config& config, Replay::Report& report)
+            : m_config(config)
+            , m_report(report)
+        {
+            for (int id = 0; id < GameEngine::PLAYER_COUNT; ++id) {
+                m_players.append(new Player(QString("Replay%1").arg(id), id));
+            }
+            for (int teamId = 0; teamId < 2; ++teamId) {
+                Team* team = new Team(teamId);
+                // 与界面中相同的座位：0、2号为0队，1、3号为1队
+                for (int id = teamId; id < GameEngine::PLAYER_COUNT; id += 2) {
+                    team->addPlayer(m_players[id]);
+                    m_players[id]->setTeam(team);
+                }
+                m_teams.append(team);
+            }
+            m_engine.setup(m_players, m_teams);
+            m_dealtHands.resize(GameEngine::PLAYER_COUNT);
+            m_evalTimer.start();
+        }
+
+        ~MatchReplayer()
+        {
+            qDeleteAll(m_players);
+            qDeleteAll(m_teams);
+        }
+
+        void apply(const GameRecordReader::Record& record)
+        {
+            using namespace GameRecord;
+            m_offset = record.offset;
+            // 损坏已计入corruptSegments，这里放弃受影响的比赛：进行中的一场，
+            // 或开头落在损坏段中、其余记录紧随其后的一场
+            if (record.afterGap && (m_active || record.type != MatchStart)) {
+                addMismatch("数据段校验失败，比赛记录不完整");
+                ++m_report.abortedMatches;
+                m_active = false;
+            }
+            if (record.type == MatchStart) {
+                startMatch(record);
+                return;
+            }
+            if (!m_active) return;
+
+            switch (record.type) {
+            case RoundStart: startRound(record.payload); break;
+            case Deal: deal(record.payload); break;
+            case Tribute: tribute(record.payload); break;
+            case Play: play(record.payload); break;
+            case Pass: pass(record.payload); break;
+            case RoundEnd: endRound(record.payload); break;
+            case MatchEnd: endMatch(record.payload); break;
+            default:
+                abortMatch(QString("未知的记录类型%1").arg(record.type));
+                break;
+            }
+        }
+
+        void finish()
+        {
+            if (m_active) endUnfinished();
+        }
+
+    private:
+        void startMatch(const GameRecordReader::Record& record)
+        {
+            using namespace GameRecord;
+            if (m_active) endUnfinished();
+            ++m_matchIndex;
+            if (record.size < 14 || getU32(record.payload) != kMagic || record.payload[4] != kVersion) {
+                ++m_report.abortedMatches;
+                addMismatch("不支持的记录格式或版本");
+                return;
+            }
+            m_engine.setSeed(getU64(record.payload + 5));
+            m_engine.setCardsPerPlayer(record.payload[13]);
+            m_engine.startGame();
+            m_engine.takeEvents();
+            m_winner = -1;
+            m_active = true;
+        }
+
+        void startRound(const uchar* p)
+        {
+            const int round = GameRecord::getU16(p);
+            if (m_engine.phase() != GameEngine::Phase::Dealing || m_engine.roundNumber() != round) {
+                abortMatch(QString("记录第%1局开始，引擎在第%2局、阶段%3").arg(round)
+                    .arg(m_engine.roundNumber()).arg(static_cast<int>(m_engine.phase())));
+                return;
+            }
+            for (int teamId = 0; teamId < 2; ++teamId) {
+                if (m_engine.levelStatus().getTeamPlayingLevel(teamId) != p[2 + teamId]) {
+                    stateMismatch(QString("%1队级牌为%2，记录为%3").arg(teamId)
+                        .arg(m_engine.levelStatus().getTeamPlayingLevel(teamId)).arg(p[2 + teamId]));
+                }
+            }
+            m_dealtPlayers = 0;
+        }
+
+        void deal(const uchar* p)
+        {
+            using namespace GameRecord;
+            const int playerId = p[0] & 3;
+            const int count = p[1];
+            QVector<Card>& hand = m_dealtHands[playerId];
+            hand.clear();
+            m_handSizes[playerId] = 0;
+            for (int i = 0; i < count; ++i) {
+                const quint8 id = unpackId(p + 2, i);
+                hand.append(cardOfFace(faceOfId(id)));
+                insertId(playerId, id);
+            }
+            // 四家的手牌都读到后按记录发牌
+            if (++m_dealtPlayers == GameEngine::PLAYER_COUNT) {
+                m_engine.presetDeal(m_dealtHands);
+                step(GameEngine::Action::proceed(), "发牌");
+            }
+        }
+
+        void tribute(const uchar* p)
+        {
+            using namespace GameRecord;
+            const int from = p[0] & 3;
+            const int to = p[0] >> 2 & 3;
+            const bool isReturn = (p[0] >> 4 & 1) != 0;
+            const quint8 id = p[1];
+            ++m_report.tributes;
+
+            const GameEngine::TributeInfo* expected = m_engine.currentTribute();
+            if (!expected || expected->fromPlayerId != from || expected->toPlayerId != to || expected->isReturn != isReturn) {
+                abortMatch(QString("记录%1号向%2号%3，引擎不在该项进贡").arg(from).arg(to).arg(isReturn ? "还贡" : "进贡"));
+                return;
+            }
+            const int index = indexOfId(from, id);
+            if (index < 0) {
+                abortMatch("贡牌不在记录的手牌中");
+                return;
+            }
+            if (!step(GameEngine::Action::tribute(from, cardOfFace(faceOfId(id))), "进贡")) return;
+            removeIds(from, 1u << index);
+            insertId(to, id);
+        }
+
+        void play(const uchar* p)
+        {
+            using namespace GameRecord;
+            const int playerId = p[0] & 3;
+            const int wilds = p[0] >> 2 & 3;
+            const int type = p[1];
+            const quint32 mask = getU32(p + 2);
+            const int level = static_cast<qint32>(getU32(p + 6));
+            ++m_report.plays;
+
+            if (!checkTurn(playerId)) return;
+            if (mask >> m_handSizes[playerId]) {
+                abortMatch("出牌的位掩码超出记录的手牌");
+                return;
+            }
+            m_cards.clear();
+            for (int i = 0; i < m_handSizes[playerId]; ++i) {
+                if (mask & (1u << i)) m_cards.append(cardOfFace(faceOfId(m_hands[playerId][i])));
+            }
+
+            // 只对牌型判断本身计时，出牌的其余步骤由下面的step完成
+            const CardCombo::ComboInfo& table = m_engine.tableCombo();
+            const qint64 begin = m_evalTimer.nsecsElapsed();
+            const QVector<CardCombo::ComboInfo> combos =
+                CardCombo::getAllPossibleValidPlays(m_cards, m_engine.player(playerId), table.type, table.level);
+            m_report.evalLatenciesNs.append(m_evalTimer.nsecsElapsed() - begin);
+
+            if (combos.isEmpty()) {
+                illegal(QString("%1号出牌%2张不再合法(记录为牌型%3、等级%4)").arg(playerId).arg(m_cards.size()).arg(type).arg(level));
+                return;
+            }
+            auto match = std::find_if(combos.begin(), combos.end(), [=](const CardCombo::ComboInfo& combo) {
+                return combo.type == type && combo.level == level && combo.wild_cards_used == wilds;
+            });
+            if (match == combos.end()) {
+                ++m_report.classificationMismatches;
+                addMismatch(QString("%1号出牌判断为%2(牌型%3、等级%4、癞子%5)，记录为牌型%6、等级%7、癞子%8")
+                    .arg(playerId).arg(combos.first().getDescription()).arg(combos.first().type)
+                    .arg(combos.first().level).arg(combos.first().wild_cards_used)
+                    .arg(type).arg(level).arg(wilds));
+                match = combos.begin(); // 按现在的判断继续，后续的动作仍能核对
+            }
+            if (!step(GameEngine::Action::play(playerId, m_cards, *match), "出牌")) return;
+            removeIds(playerId, mask);
+        }
+
+        void pass(const uchar* p)
+        {
+            const int playerId = p[0] & 3;
+            ++m_report.passes;
+            if (!checkTurn(playerId)) return;
+            step(GameEngine::Action::pass(playerId), "过牌");
+        }
+
+        void endRound(const uchar* p)
+        {
+            if (m_engine.phase() != GameEngine::Phase::RoundOver) {
+                abortMatch("记录一局结束，引擎中这一局还没有结束");
+                return;
+            }
+            const QVector<int>& order = m_engine.roundFinishOrder();
+            quint8 packed = 0;
+            for (int i = 0; i < order.size() && i < GameEngine::PLAYER_COUNT; ++i) {
+                packed |= quint8((order[i] & 3) << (2 * i));
+            }
+            if (packed != p[0]) {
+                stateMismatch(QString("名次编码为%1，记录为%2").arg(packed).arg(p[0]));
+            }
+            ++m_report.rounds;
+            step(GameEngine::Action::proceed(), "结算");
+        }
+
+        void endMatch(const uchar* p)
+        {
+            if (m_engine.phase() != GameEngine::Phase::GameOver) {
+                abortMatch("记录比赛结束，引擎中比赛还没有结束");
+                return;
+            }
+            if (m_winner != p[0]) {
+                stateMismatch(QString("%1队获胜，记录为%2队").arg(m_winner).arg(p[0]));
+            }
+            ++m_report.matches;
+            m_active = false;
+        }
+
+        // 记录在比赛中途结束(界面中途退出或重新开始)：已有的记录都核对过，不算不一致
+        void endUnfinished()
+        {
+            ++m_report.unfinishedMatches;
+            m_active = false;
+        }
+
+        // --- 辅助 ---
+
+        bool step(const GameEngine::Action& action, const char* what)
+        {
+            QString error;
+            if (!m_engine.step(action, &error)) {
+                illegal(QString("%1号%2被拒绝：%3").arg(action.playerId).arg(what).arg(error));
+                return false;
+            }
+            for (const GameEngine::Event& event : m_engine.takeEvents()) {
+                if (event.type == GameEngine::Event::GameOver) m_winner = event.value;
+            }
+            return true;
+        }
+
+        bool checkTurn(int playerId)
+        {
+            if (m_engine.phase() == GameEngine::Phase::Playing && m_engine.currentPlayerId() == playerId) return true;
+            abortMatch(QString("记录轮到%1号，引擎轮到%2号(阶段%3)").arg(playerId)
+                .arg(m_engine.currentPlayerId()).arg(static_cast<int>(m_engine.phase())));
+            return false;
+        }
+
+        void illegal(const QString& message)
+        {
+            ++m_report.illegalActions;
+            addMismatch(message);
+            abortMatch(QString());
+        }
+
+        void stateMismatch(const QString& message)
+        {
+            ++m_report.stateMismatches;
+            addMismatch(message);
+        }
+
+        // 之后的记录无法再与引擎对应，放弃本场，从下一条MatchStart重新开始
+        void abortMatch(const QString& message)
+        {
+            if (!message.isEmpty()) {
+                ++m_report.stateMismatches;
+                addMismatch(message);
+            }
+            ++m_report.abortedMatches;
+            m_active = false;
+        }
+
+        void addMismatch(const QString& message)
+        {
+            if (m_report.mismatches.size() >= m_config.maxReportedMismatches) return;
+            Replay::Mismatch mismatch;
+            mismatch.offset = m_offset;
+            mismatch.match = m_matchIndex;
+            mismatch.round = m_engine.roundNumber();
+            mismatch.message = message;
+            m_report.mismatches.append(mismatch);
+        }
+
+        // 记录中的手牌：各家牌的编号升序排列，与GameRecordWriter一致，出牌的位掩码按它解读
+        int indexOfId(int playerId, quint8 id) const
+        {
+            for (int i = 0; i < m_handSizes[playerId]; ++i) {
+                if (m_hands[playerId][i] == id) return i;
+            }
+            return -1;
+        }
+
+        void insertId(int playerId, quint8 id)
+        {
+            int& size = m_handSizes[playerId];
+            if (size >= GameRecord::kMaxHandCards) return;
+            int i = size++;
+            for (; i > 0 && m_hands[playerId][i - 1] > id; --i) {
+                m_hands[playerId][i] = m_hands[playerId][i - 1];
+            }
+            m_hands[playerId][i] = id;
+        }
+
+        void removeIds(int playerId, quint32 mask)
+        {
+            int kept = 0;
+            for (int i = 0; i < m_handSizes[playerId]; ++i) {
+                if (!(mask & (1u << i))) m_hands[playerId][kept++] = m_hands[playerId][i];
+            }
+            m_handSizes[playerId] = kept;
+        }
+
+        const Replay::Config& m_config;
+        Replay::Report& m_report;
+        GameEngine m_engine;
+        QVector<Player*> m_players;
+        QVector<Team*> m_teams;
+        QElapsedTimer m_evalTimer;
+
+        bool m_active = false;  // 正在重放一场比赛
+        int m_matchIndex = 0;
+        qint64 m_offset = 0;    // 当前记录的位置
+        int m_winner = -1;      // 引擎给出的获胜队伍
+        int m_dealtPlayers = 0;
+        QVector<QVector<Card>> m_dealtHands;
+        QVector<Card> m_cards;  // 当前出牌，复用以免每手分配
+        quint8 m_hands[GameEngine::PLAYER_COUNT][GameRecord::kMaxHandCards] = {};
+        int m_handSizes[GameEngine::PLAYER_COUNT] = {};
+    };
+
+} // namespace
+
+Replay::Report Replay::run(const QByteArray& data, const Config& config)
+{
+    Report report;
+    QElapsedTimer timer;
+    timer.start();
+
+    GameRecordReader reader(data);
+    MatchReplayer replayer(config, report);
+    GameRecordReader::Record record;
+    while (reader.next(record)) {
+        replayer.apply(record);
+    }
+    replayer.finish();
+
+    report.corruptSegments = reader.corruptSegments();
+    report.unverifiedBytes = reader.unverifiedBytes();
+    report.elapsedSeconds = timer.nsecsElapsed() / 1e9;
+    std::sort(report.evalLatenciesNs.begin(), report.evalLatenciesNs.end());
+    return report;
+}
+
+double Replay::percentileUs(const QVector<qint64>& sortedLatenciesNs, double percentile)
+{
+    if (sortedLatenciesNs.isEmpty()) return 0.0;
+    // 最近秩法
+    const int rank = static_cast<int>(std::ceil(percentile / 100.0 * sortedLatenciesNs.size()));
+    const int index = qBound(0, rank - 1, sortedLatenciesNs.size() - 1);
+    return sortedLatenciesNs[index] / 1e3;
+}
@@ -0,0 +1,62 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+// Replay: 无界面、无定时器地重放记录的对局(格式见GameRecord)，作为牌型判断的回归检查
+// 每场比赛用记录中的种子和发牌重建GameEngine，依次执行记录的进贡、出牌和过牌：
+// 动作须仍被引擎接受，每手出牌的牌型、等级和使用的癞子数须与记录时相同，级牌、名次和胜者也逐一核对
+// 每手出牌单独计时一次CardCombo::getAllPossibleValidPlays，报告牌型判断的延迟分布；
+// 优化牌型判断或癞子解析后，用同一批记录重放(也可与定义CARDCOMBO_REFERENCE_EVALUATOR的参考实现对比)
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+class Replay
+{
+public:
+    struct Config {
+        int maxReportedMismatches = 20; // 报告中保留的不一致明细条数
+    };
+
+    // 一处不一致的明细
+    struct Mismatch {
+        qint64 offset = 0;   // 记录在流中的位置
+        int match = 0;       // 第几场比赛(从1开始)
+        int round = 0;       // 第几局
+        QString message;
+    };
+
+    struct Report {
+        int matches = 0;                 // 完整重放的比赛
+        int abortedMatches = 0;          // 因动作不合法、状态不一致或数据损坏而中止的比赛
+        int unfinishedMatches = 0;       // 记录在比赛中途结束(界面中途退出)，已记录的部分照常核对
+        int rounds = 0;
+        qint64 plays = 0;
+        qint64 passes = 0;
+        qint64 tributes = 0;
+        qint64 illegalActions = 0;       // 引擎不再接受的动作
+        qint64 classificationMismatches = 0; // 牌型、等级或癞子数与记录不同的出牌
+        qint64 stateMismatches = 0;      // 级牌、轮到的玩家、名次或胜者与记录不同
+        int corruptSegments = 0;         // 校验失败而跳过的数据段
+        qint64 unverifiedBytes = 0;      // 末尾写入中断、没有校验的字节
+        double elapsedSeconds = 0.0;
+        QVector<qint64> evalLatenciesNs; // 每手出牌的牌型判断耗时(纳秒)，已排序
+        QVector<Mismatch> mismatches;    // 前maxReportedMismatches条不一致
+
+        qint64 moves() const { return plays + passes + tributes; }
+        // 没有任何不合法动作、不一致和损坏的数据
+        bool passed() const
+        {
+            return abortedMatches == 0 && illegalActions == 0 && classificationMismatches == 0
+                && stateMismatches == 0 && corruptSegments == 0;
+        }
+    };
+
+    static Report run(const QByteArray& data, const Config& config);
+
+    // 延迟百分位(0~100)，返回微秒；latenciesNs须已排序
+    static double percentileUs(const QVector<qint64>& sortedLatenciesNs, double percentile);
+};
+
+#endif // REPLAY_H
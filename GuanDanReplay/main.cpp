@@ -0,0 +1,87 @@
+// GuanDanReplay: 重放对局记录的命令行程序
+// 例：GuanDanReplay GuanDan.gdr selfplay.gdr
+// 核对每手出牌仍然合法、牌型判断与记录时相同，报告重放速度和牌型判断的延迟；有任何不一致时返回2
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+
+#include "Replay.h"
+
+namespace {
+    bool g_verbose = false;
+
+    // 规则引擎的调试输出在大量重放中会拖慢速度，默认只保留警告和错误
+    void messageHandler(QtMsgType type, const QMessageLogContext&, const QString& message)
+    {
+        if (!g_verbose && (type == QtDebugMsg || type == QtInfoMsg)) return;
+        QTextStream(stderr) << message << '\n';
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("GuanDanReplay");
+    qInstallMessageHandler(messageHandler);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("掼蛋对局记录重放：用规则引擎重新执行记录的对局，核对出牌的合法性和牌型判断");
+    parser.addHelpOption();
+    parser.addPositionalArgument("files", "对局记录文件(游戏目录下的GuanDan.gdr，或GuanDanSelfPlay --record的输出)", "file...");
+    QCommandLineOption mismatchesOption("mismatches", "列出的不一致明细条数(默认20)", "count", "20");
+    QCommandLineOption verboseOption(QStringList() << "v" << "verbose", "输出规则引擎的调试信息");
+    parser.addOptions({ mismatchesOption, verboseOption });
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    g_verbose = parser.isSet(verboseOption);
+
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty()) {
+        err << "须指定至少一个对局记录文件\n";
+        return 1;
+    }
+    Replay::Config config;
+    config.maxReportedMismatches = qMax(0, parser.value(mismatchesOption).toInt());
+
+    bool passed = true;
+    for (const QString& fileName : files) {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << QString("无法打开记录文件%1：%2\n").arg(fileName).arg(file.errorString());
+            return 1;
+        }
+        const QByteArray data = file.readAll();
+        const Replay::Report report = Replay::run(data, config);
+        passed = passed && report.passed();
+
+        const double seconds = qMax(1e-9, report.elapsedSeconds);
+        out << fileName << '\n';
+        out << QString("  比赛       %1场重放完成，%2场未打完，%3场中止，共%4局，%5字节，用时%6秒\n")
+            .arg(report.matches).arg(report.unfinishedMatches).arg(report.abortedMatches).arg(report.rounds)
+            .arg(data.size()).arg(report.elapsedSeconds, 0, 'f', 3);
+        out << QString("  动作       出牌%1，过牌%2，进贡/还贡%3，每秒%4个\n")
+            .arg(report.plays).arg(report.passes).arg(report.tributes)
+            .arg(report.moves() / seconds, 0, 'f', 0);
+        out << QString("  牌型判断(us) p50 %1  p90 %2  p99 %3  max %4\n")
+            .arg(Replay::percentileUs(report.evalLatenciesNs, 50), 0, 'f', 2)
+            .arg(Replay::percentileUs(report.evalLatenciesNs, 90), 0, 'f', 2)
+            .arg(Replay::percentileUs(report.evalLatenciesNs, 99), 0, 'f', 2)
+            .arg(Replay::percentileUs(report.evalLatenciesNs, 100), 0, 'f', 2);
+        out << QString("  不一致     不合法动作%1，牌型判断%2，对局状态%3，损坏数据段%4\n")
+            .arg(report.illegalActions).arg(report.classificationMismatches)
+            .arg(report.stateMismatches).arg(report.corruptSegments);
+        if (report.unverifiedBytes > 0) {
+            out << QString("  末尾有%1字节没有校验记录(写入中断)，未重放\n").arg(report.unverifiedBytes);
+        }
+        for (const Replay::Mismatch& mismatch : report.mismatches) {
+            out << QString("  [偏移%1 第%2场 第%3局] %4\n")
+                .arg(mismatch.offset).arg(mismatch.match).arg(mismatch.round).arg(mismatch.message);
+        }
+    }
+    out << (passed ? "通过\n" : "未通过\n");
+    return passed ? 0 : 2;
+}
@@ -0,0 +1,420 @@
+#include "SelfPlay.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include "AiTask.h"
+#include "GameEngine.h"
+#include "GameRecord.h"
+#include "NPCPlayer.h"
+#include "RngStream.h"
+#include "Rollout.h"
+#include "SettingsManager.h"
+#include "Team.h"
+
+namespace {
+
+    void recordSearch(SelfPlay::PolicyStats& stats, const Rollout::SearchStats& search)
+    {
+        switch (search.kind) {
+        case Rollout::SearchStats::Pimc:
+            ++stats.pimcSearches;
+            break;
+        case Rollout::SearchStats::Ismcts:
+            ++stats.ismctsSearches;
+            stats.playoutsPerSecond.append(search.playoutsPerSecond);
+            stats.treeNodes.append(search.treeNodes);
+            if (search.treeFull) ++stats.treeFullSearches;
+            break;
+        case Rollout::SearchStats::Endgame:
+            ++stats.endgameSearches;
+            if (search.searched) {          // 回退到PIMC的残局搜索不计入吞吐量
+                stats.endgameNodesPerSecond.append(search.nodesPerSecond);
+                stats.endgameSolveMs.append(search.solveMs);
+            }
+            if (search.exact) ++stats.exactEndgames;
+            break;
+        default:
+            return;
+        }
+        if (!search.searched) ++stats.searchFallbacks;
+    }
+
+    quint64 mixDigest(quint64 digest, quint64 value)
+    {
+        digest ^= value + 0x9E3779B97F4A7C15ULL + (digest << 6) + (digest >> 2);
+        return digest * 0xBF58476D1CE4E5B9ULL;
+    }
+
+    // 一个工作线程的对局环境：自己的引擎、玩家和队伍，依次进行分到的比赛
+    class MatchWorker
+    {
+    public:
+        MatchWorker(const SelfPlay::Config& config, QMutex& recordMutex)
+            : m_config(config)
+            , m_recordMutex(recordMutex)
+        {
+            for (int id = 0; id < GameEngine::PLAYER_COUNT; ++id) {
+                m_players.append(new NPCPlayer(QString("Bot%1").arg(id), id));
+            }
+            for (int teamId = 0; teamId < 2; ++teamId) {
+                Team* team = new Team(teamId);
+                // 与界面中相同的座位：0、2号为0队，1、3号为1队
+                for (int id = teamId; id < GameEngine::PLAYER_COUNT; id += 2) {
+                    team->addPlayer(m_players[id]);
+                    m_players[id]->setTeam(team);
+                }
+                m_teams.append(team);
+            }
+            m_engine.setup(m_players, m_teams);
+            m_engine.setCardsPerPlayer(config.cardsPerPlayer);
+
+            // 每场比赛先记录到本线程的缓冲中，完成后整场写入共用的输出设备，各场的记录不会交错
+            if (config.record) {
+                m_recordData.reserve(1 << 16);
+                m_recordBuffer.setBuffer(&m_recordData);
+                m_recordBuffer.open(QIODevice::WriteOnly);
+                m_recorder.setDevice(&m_recordBuffer);
+            }
+        }
+
+        ~MatchWorker()
+        {
+            qDeleteAll(m_players);
+            qDeleteAll(m_teams);
+        }
+
+        // 进行第match场比赛，policyOfTeam[t]为t队使用的策略下标；超过回合上限时返回false
+        bool playMatch(int match, const int policyOfTeam[2], SelfPlay::Report& report)
+        {
+            // 本场的随机数流：0号子流为引擎的比赛种子(发牌、首出、搜索)，1号子流给随机策略
+            const RngStream matchRng = RngStream(m_config.seed).split(static_cast<quint64>(match));
+            m_engine.setSeed(matchRng.split(0).next());
+            m_rng = matchRng.split(1);
+            quint64 digest = mixDigest(0, m_engine.seed());
+
+            m_engine.startGame();
+            m_recorder.flush(); // 上一场异常放弃时留在缓冲中的记录随之丢弃
+            m_recordData.resize(0);
+            m_recordBuffer.seek(0);
+            m_recorder.beginMatch(m_engine.seed(), m_config.cardsPerPlayer);
+            recordEvents(m_engine.takeEvents());
+
+            int turns = 0;
+            int rounds = 0;
+            while (m_engine.phase() != GameEngine::Phase::GameOver) {
+                if (turns > m_config.maxTurnsPerMatch) return false;
+
+                GameEngine::Action action;
+                int policyIndex = -1;
+                switch (m_engine.phase()) {
+                case GameEngine::Phase::Playing:
+                    policyIndex = policyOfTeam[m_engine.currentPlayerId() % 2];
+                    action = decidePlay(m_config.policies[policyIndex], report.policies[policyIndex]);
+                    ++turns;
+                    break;
+                case GameEngine::Phase::Tribute:
+                    policyIndex = policyOfTeam[m_engine.currentPlayerId() % 2];
+                    action = decideTribute(m_config.policies[policyIndex]);
+                    break;
+                default:
+                    action = GameEngine::Action::proceed();
+                    break;
+                }
+
+                if (!m_engine.step(action)) {
+                    // 选牌不合规则：记入统计，改用第一个合法动作使比赛继续
+                    const QVector<GameEngine::Action> legal = m_engine.legalActions();
+                    if (legal.isEmpty() || !m_engine.step(legal.first())) return false;
+                    if (policyIndex >= 0) ++report.policies[policyIndex].illegalDecisions;
+                    action = legal.first();
+                }
+                digest = mixDigest(digest, static_cast<quint64>(action.type) << 8 | static_cast<quint64>(action.playerId + 1));
+                for (const Card& card : action.cards) {
+                    digest = mixDigest(digest, static_cast<quint64>(card.point()) << 8 | static_cast<quint64>(card.suit()));
+                }
+
+                const QVector<GameEngine::Event> events = m_engine.takeEvents();
+                recordEvents(events);
+                for (const GameEngine::Event& event : events) {
+                    if (event.type == GameEngine::Event::RoundSettled) {
+                        ++rounds;
+                    }
+                    else if (event.type == GameEngine::Event::GameOver) {
+                        ++report.policies[policyOfTeam[event.value]].wins;
+                    }
+                }
+            }
+            report.rounds += rounds;
+            report.turns += turns;
+            report.digest += mixDigest(digest, static_cast<quint64>(match)); // 求和与完成的先后无关
+            if (m_config.record) {
+                QMutexLocker locker(&m_recordMutex);
+                m_config.record->write(m_recordData.constData(), m_recordData.size());
+                report.recordBytes += m_recordData.size();
+            }
+            return true;
+        }
+
+    private:
+        void recordEvents(const QVector<GameEngine::Event>& events)
+        {
+            if (!m_recorder.isRecording()) return;
+            using Event = GameEngine::Event;
+            for (const Event& event : events) {
+                switch (event.type) {
+                case Event::RoundStarted:
+                    m_recorder.beginRound(event.value, m_engine.levelStatus().getTeamPlayingLevel(0),
+                        m_engine.levelStatus().getTeamPlayingLevel(1));
+                    break;
+                case Event::CardsDealt:
+                    m_recorder.deal(event.playerId, event.cards);
+                    break;
+                case Event::TributeGiven:
+                    m_recorder.tribute(event.playerId, event.targetId, event.flag, event.cards.first());
+                    break;
+                case Event::Played:
+                    m_recorder.play(event.playerId, event.cards, event.combo);
+                    break;
+                case Event::Passed:
+                    m_recorder.pass(event.playerId);
+                    break;
+                case Event::RoundSettled:
+                    m_recorder.endRound(event.order);
+                    break;
+                case Event::GameOver:
+                    m_recorder.endMatch(event.value);
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+
+        GameEngine::Action decidePlay(const SelfPlay::Policy& policy, SelfPlay::PolicyStats& stats)
+        {
+            const int playerId = m_engine.currentPlayerId();
+            QElapsedTimer timer;
+            timer.start();
+
+            GameEngine::Action action;
+            if (policy.kind == SelfPlay::Policy::Random) {
+                action = randomAction();
+            }
+            else {
+                AiTask::Snapshot snapshot = AiTask::makeSnapshot(m_engine, playerId, policy.difficulty,
+                    m_engine.tableCombo(), m_engine.tableOwnerId());
+                snapshot.budgetMs = policy.budgetMs;
+                snapshot.threadCount = m_config.searchThreads;
+                Rollout::SearchStats search;
+                const QVector<Card> cards = AiTask::decide(snapshot, nullptr, &search);
+                recordSearch(stats, search);
+                action = cards.isEmpty() ? GameEngine::Action::pass(playerId) : GameEngine::Action::play(playerId, cards);
+            }
+
+            stats.latenciesNs.append(timer.nsecsElapsed());
+            ++stats.decisions;
+            return action;
+        }
+
+        GameEngine::Action decideTribute(const SelfPlay::Policy& policy)
+        {
+            if (policy.kind == SelfPlay::Policy::Random) return randomAction();
+
+            // 与游戏中的AI相同：进贡出最大的牌，还贡出最小的牌
+            const GameEngine::TributeInfo* tribute = m_engine.currentTribute();
+            Player* player = m_engine.player(tribute->fromPlayerId);
+            const Card card = tribute->isReturn ? player->getSmallestCard() : player->getLargestCard();
+            return GameEngine::Action::tribute(tribute->fromPlayerId, card);
+        }
+
+        GameEngine::Action randomAction()
+        {
+            const QVector<GameEngine::Action> legal = m_engine.legalActions();
+            if (legal.isEmpty()) return GameEngine::Action::proceed();
+            return legal[m_rng.bounded(legal.size())];
+        }
+
+        const SelfPlay::Config& m_config;
+        QMutex& m_recordMutex;
+        GameEngine m_engine;
+        QVector<Player*> m_players;
+        QVector<Team*> m_teams;
+        RngStream m_rng;
+
+        QByteArray m_recordData;
+        QBuffer m_recordBuffer;
+        GameRecordWriter m_recorder; // 在m_recordBuffer之后声明，先析构
+    };
+
+    void mergeReport(SelfPlay::Report& total, const SelfPlay::Report& part)
+    {
+        total.completedMatches += part.completedMatches;
+        total.abortedMatches += part.abortedMatches;
+        total.rounds += part.rounds;
+        total.turns += part.turns;
+        total.digest += part.digest;
+        total.recordBytes += part.recordBytes;
+        for (int i = 0; i < 2; ++i) {
+            total.policies[i].wins += part.policies[i].wins;
+            total.policies[i].decisions += part.policies[i].decisions;
+            total.policies[i].illegalDecisions += part.policies[i].illegalDecisions;
+            total.policies[i].latenciesNs += part.policies[i].latenciesNs;
+            total.policies[i].pimcSearches += part.policies[i].pimcSearches;
+            total.policies[i].ismctsSearches += part.policies[i].ismctsSearches;
+            total.policies[i].endgameSearches += part.policies[i].endgameSearches;
+            total.policies[i].searchFallbacks += part.policies[i].searchFallbacks;
+            total.policies[i].playoutsPerSecond += part.policies[i].playoutsPerSecond;
+            total.policies[i].treeNodes += part.policies[i].treeNodes;
+            total.policies[i].treeFullSearches += part.policies[i].treeFullSearches;
+            total.policies[i].endgameNodesPerSecond += part.policies[i].endgameNodesPerSecond;
+            total.policies[i].endgameSolveMs += part.policies[i].endgameSolveMs;
+            total.policies[i].exactEndgames += part.policies[i].exactEndgames;
+        }
+    }
+
+} // namespace
+
+bool SelfPlay::Policy::parse(const QString& text, Policy* policy, QString* error)
+{
+    const QStringList parts = text.trimmed().toLower().split(':');
+    const QString& name = parts.first();
+    Policy result;
+    if (name == "random") {
+        result.kind = Random;
+    }
+    else if (name == "normal") {
+        result.difficulty = SettingsManager::AiNormal;
+    }
+    else if (name == "hard" || name == "expert") {
+        result.difficulty = name == "hard" ? SettingsManager::AiHard : SettingsManager::AiExpert;
+        result.budgetMs = 200;
+    }
+    else {
+        if (error) *error = QString("未知的策略：%1").arg(text);
+        return false;
+    }
+
+    if (parts.size() > 2 || (parts.size() == 2 && result.difficulty < SettingsManager::AiHard)) {
+        if (error) *error = QString("只有hard和expert可以指定搜索时间：%1").arg(text);
+        return false;
+    }
+    if (parts.size() == 2) {
+        bool ok = false;
+        result.budgetMs = parts[1].toInt(&ok);
+        if (!ok || result.budgetMs <= 0) {
+            if (error) *error = QString("搜索时间须为正整数(毫秒)：%1").arg(text);
+            return false;
+        }
+    }
+    *policy = result;
+    return true;
+}
+
+QString SelfPlay::Policy::toString() const
+{
+    if (kind == Random) return "random";
+    switch (difficulty) {
+    case SettingsManager::AiHard: return QString("hard:%1").arg(budgetMs);
+    case SettingsManager::AiExpert: return QString("expert:%1").arg(budgetMs);
+    default: return "normal";
+    }
+}
+
+SelfPlay::Report SelfPlay::run(const Config& config)
+{
+    Report total;
+    total.threads = config.threads > 0 ? config.threads : qMax(1, QThread::idealThreadCount());
+    total.threads = qMin(total.threads, qMax(1, config.matches));
+
+    // 比赛不在Rollout的线程池中进行：工作线程会等待搜索任务，共用一个池可能互相占满
+    QThreadPool pool;
+    pool.setMaxThreadCount(total.threads);
+    std::atomic<int> nextMatch(0);
+    QMutex mutex;
+    QMutex recordMutex;
+
+    // 置换表在进程内一直保留，只统计本次运行的查询
+    TranspositionTable::shared().resetStats();
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int t = 0; t < total.threads; ++t) {
+        pool.start([&config, &nextMatch, &mutex, &recordMutex, &total]() {
+            MatchWorker worker(config, recordMutex);
+            Report part;
+            for (int match = nextMatch++; match < config.matches; match = nextMatch++) {
+                // 两种策略按场次轮换队伍
+                const int policyOfTeam[2] = { match % 2, 1 - match % 2 };
+                if (worker.playMatch(match, policyOfTeam, part)) {
+                    ++part.completedMatches;
+                }
+                else {
+                    ++part.abortedMatches;
+                }
+            }
+            QMutexLocker locker(&mutex);
+            mergeReport(total, part);
+        });
+    }
+    pool.waitForDone();
+    total.elapsedSeconds = timer.nsecsElapsed() / 1e9;
+    total.table = TranspositionTable::shared().stats();
+
+    for (PolicyStats& stats : total.policies) {
+        std::sort(stats.latenciesNs.begin(), stats.latenciesNs.end());
+        std::sort(stats.playoutsPerSecond.begin(), stats.playoutsPerSecond.end());
+        std::sort(stats.treeNodes.begin(), stats.treeNodes.end());
+        std::sort(stats.endgameNodesPerSecond.begin(), stats.endgameNodesPerSecond.end());
+        std::sort(stats.endgameSolveMs.begin(), stats.endgameSolveMs.end());
+    }
+    return total;
+}
+
+double SelfPlay::percentileMs(const QVector<qint64>& sortedLatenciesNs, double percentile)
+{
+    if (sortedLatenciesNs.isEmpty()) return 0.0;
+    // 最近秩法
+    const int rank = static_cast<int>(std::ceil(percentile / 100.0 * sortedLatenciesNs.size()));
+    const int index = qBound(0, rank - 1, sortedLatenciesNs.size() - 1);
+    return sortedLatenciesNs[index] / 1e6;
+}
+
+double SelfPlay::percentile(const QVector<double>& sortedValues, double percentile)
+{
+    if (sortedValues.isEmpty()) return 0.0;
+    const int rank = static_cast<int>(std::ceil(percentile / 100.0 * sortedValues.size()));
+    return sortedValues[qBound(0, rank - 1, sortedValues.size() - 1)];
+}
+
+double SelfPlay::mean(const QVector<double>& values)
+{
+    if (values.isEmpty()) return 0.0;
+    double sum = 0.0;
+    for (double value : values) sum += value;
+    return sum / values.size();
+}
+
+void SelfPlay::wilsonInterval(int wins, int games, double* low, double* high)
+{
+    if (games <= 0) {
+        *low = 0.0;
+        *high = 1.0;
+        return;
+    }
+    const double z = 1.96;
+    const double n = games;
+    const double p = wins / n;
+    const double denominator = 1.0 + z * z / n;
+    const double center = (p + z * z / (2.0 * n)) / denominator;
+    const double margin = z * std::sqrt(p * (1.0 - p) / n + z * z / (4.0 * n * n)) / denominator;
+    *low = qMax(0.0, center - margin);
+    *high = qMin(1.0, center + margin);
+}
@@ -0,0 +1,91 @@
+#ifndef SELFPLAY_H
+#define SELFPLAY_H
+
+// SelfPlay: 无界面的自对弈对战，在所有核心上并行进行整场比赛(两队从2打到过A)
+// 每个工作线程持有自己的GameEngine、玩家和队伍，对局之间不共享状态(搜索的置换表除外)
+// 两种策略轮流坐在0队和1队，抵消座位和首出的影响；结果用于比较AI强度和衡量引擎吞吐量
+// 每场比赛的随机数流由总种子和场次派生(见RngStream)，与线程数和调度无关：同一种子重跑时，
+// 随机和普通策略的每一步都逐位相同(摘要一致)；困难/专家的搜索按时间预算停止，模拟次数随机器负载变化
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include "TranspositionTable.h"
+
+class QIODevice;
+
+class SelfPlay
+{
+public:
+    // 一方AI的选牌策略
+    struct Policy {
+        enum Kind {
+            Random, // 从legalActions()中均匀随机选择，作为基准
+            Bot     // 与游戏中相同的AiTask::decide，按难度选牌
+        };
+        Kind kind = Bot;
+        int difficulty = 0; // SettingsManager::AiDifficulty
+        int budgetMs = 0;   // 困难/专家每步的搜索时间
+
+        // 解析"random"、"normal"、"hard[:毫秒]"、"expert[:毫秒]"，失败时返回false
+        static bool parse(const QString& text, Policy* policy, QString* error);
+        QString toString() const;
+    };
+
+    struct Config {
+        Policy policies[2];      // 对战的两种策略
+        int matches = 100;       // 整场比赛的场数
+        int threads = 0;         // 并行的比赛数，<=0时按CPU核数
+        int searchThreads = 1;   // 每次搜索的线程数(比赛已占满各核心，默认单线程)
+        int cardsPerPlayer = 27;
+        int maxTurnsPerMatch = 200000; // 超过后判为异常并放弃该场
+        quint64 seed = 0;        // 总种子
+        QIODevice* record = nullptr; // 对局记录的输出设备(格式见GameRecord)，为空时不记录；异常放弃的比赛不写入
+    };
+
+    // 一种策略的统计
+    struct PolicyStats {
+        int wins = 0;
+        qint64 decisions = 0;
+        qint64 illegalDecisions = 0;   // 选牌不合规则，改用第一个合法动作
+        QVector<qint64> latenciesNs;   // 每次选牌的耗时(纳秒)
+
+        // 搜索的统计(困难/专家)，用于确定搜索的线程数和时间预算
+        qint64 pimcSearches = 0;
+        qint64 ismctsSearches = 0;
+        qint64 endgameSearches = 0;
+        qint64 searchFallbacks = 0;        // 预算内没有完成任何模拟，退回启发式选牌
+        QVector<double> playoutsPerSecond; // 每次ISMCTS搜索的每秒迭代次数
+        QVector<double> treeNodes;         // 每次ISMCTS搜索结束时树的节点数
+        qint64 treeFullSearches = 0;       // 树达到IsmctsSearch::kMaxTreeNodes的ISMCTS搜索
+        QVector<double> endgameNodesPerSecond; // 每次残局搜索的每秒节点数
+        QVector<double> endgameSolveMs;    // 每次残局搜索中平均每次确定化的求解耗时(毫秒)，未完成求解的不计
+        qint64 exactEndgames = 0;          // 补全唯一、一次求解即为精确结果的残局搜索
+    };
+
+    struct Report {
+        int completedMatches = 0;
+        int abortedMatches = 0;
+        qint64 rounds = 0;
+        qint64 turns = 0;        // 出牌和过牌的总次数
+        double elapsedSeconds = 0.0;
+        int threads = 0;
+        quint64 digest = 0;      // 所有比赛的动作序列摘要，与比赛完成的先后无关，用于核对重放是否逐位一致
+        qint64 recordBytes = 0;  // 写入对局记录的字节数
+        PolicyStats policies[2];
+        TranspositionTable::Stats table; // 本次运行中残局搜索对共用置换表的查询统计
+    };
+
+    static Report run(const Config& config);
+
+    // 延迟百分位(0~100)，返回毫秒；latenciesNs须已排序
+    static double percentileMs(const QVector<qint64>& sortedLatenciesNs, double percentile);
+    // 一般数值的百分位(0~100)和平均值；values须已排序，为空时返回0
+    static double percentile(const QVector<double>& sortedValues, double percentile);
+    static double mean(const QVector<double>& values);
+    // 胜率的95% Wilson置信区间
+    static void wilsonInterval(int wins, int games, double* low, double* high);
+};
+
+#endif // SELFPLAY_H
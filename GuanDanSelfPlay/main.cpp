@@ -0,0 +1,158 @@
+// GuanDanSelfPlay: 自对弈对战的命令行程序
+// 例：GuanDanSelfPlay -n 1000 -a hard:100 -b normal --seed 42
+// 在所有核心上进行整场比赛，报告吞吐量、平均回合数、每次选牌的延迟和双方胜率(95%置信区间)
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QThread>
+
+#include "IsmctsSearch.h"
+#include "SelfPlay.h"
+#include "TranspositionTable.h"
+
+namespace {
+    bool g_verbose = false;
+
+    // 规则引擎和AI的调试输出在大量对局中会拖慢速度，默认只保留警告和错误
+    void messageHandler(QtMsgType type, const QMessageLogContext&, const QString& message)
+    {
+        if (!g_verbose && (type == QtDebugMsg || type == QtInfoMsg)) return;
+        QTextStream(stderr) << message << '\n';
+    }
+
+    void printPolicy(QTextStream& out, const QString& label, const SelfPlay::Policy& policy,
+        const SelfPlay::PolicyStats& stats, int games)
+    {
+        double low = 0.0, high = 0.0;
+        SelfPlay::wilsonInterval(stats.wins, games, &low, &high);
+        const double rate = games > 0 ? 100.0 * stats.wins / games : 0.0;
+        out << QString("%1 %2\n").arg(label).arg(policy.toString());
+        out << QString("  胜率     %1%  (%2/%3, 95%置信区间 %4% ~ %5%)\n")
+            .arg(rate, 0, 'f', 1).arg(stats.wins).arg(games)
+            .arg(100.0 * low, 0, 'f', 1).arg(100.0 * high, 0, 'f', 1);
+        out << QString("  选牌     %1次，不合规则%2次\n").arg(stats.decisions).arg(stats.illegalDecisions);
+        out << QString("  延迟(ms) p50 %1  p90 %2  p99 %3  max %4\n")
+            .arg(SelfPlay::percentileMs(stats.latenciesNs, 50), 0, 'f', 3)
+            .arg(SelfPlay::percentileMs(stats.latenciesNs, 90), 0, 'f', 3)
+            .arg(SelfPlay::percentileMs(stats.latenciesNs, 99), 0, 'f', 3)
+            .arg(SelfPlay::percentileMs(stats.latenciesNs, 100), 0, 'f', 3);
+        if (stats.pimcSearches + stats.ismctsSearches + stats.endgameSearches > 0) {
+            out << QString("  搜索     PIMC %1次，ISMCTS %2次，残局%3次，未完成模拟而退回启发式%4次\n")
+                .arg(stats.pimcSearches).arg(stats.ismctsSearches).arg(stats.endgameSearches).arg(stats.searchFallbacks);
+        }
+        if (stats.ismctsSearches > 0) {
+            out << QString("  ISMCTS   每秒迭代 平均%1 p50 %2；树节点 平均%3 p50 %4 max %5，%6次达到上限%7\n")
+                .arg(SelfPlay::mean(stats.playoutsPerSecond), 0, 'f', 0)
+                .arg(SelfPlay::percentile(stats.playoutsPerSecond, 50), 0, 'f', 0)
+                .arg(SelfPlay::mean(stats.treeNodes), 0, 'f', 0)
+                .arg(SelfPlay::percentile(stats.treeNodes, 50), 0, 'f', 0)
+                .arg(SelfPlay::percentile(stats.treeNodes, 100), 0, 'f', 0)
+                .arg(stats.treeFullSearches).arg(IsmctsSearch::kMaxTreeNodes);
+        }
+        if (stats.endgameSearches > 0) {
+            out << QString("  残局     每秒节点 平均%1 p50 %2；每次求解(ms) 平均%3 p50 %4 max %5，%6次为精确结果\n")
+                .arg(SelfPlay::mean(stats.endgameNodesPerSecond), 0, 'f', 0)
+                .arg(SelfPlay::percentile(stats.endgameNodesPerSecond, 50), 0, 'f', 0)
+                .arg(SelfPlay::mean(stats.endgameSolveMs), 0, 'f', 2)
+                .arg(SelfPlay::percentile(stats.endgameSolveMs, 50), 0, 'f', 2)
+                .arg(SelfPlay::percentile(stats.endgameSolveMs, 100), 0, 'f', 2)
+                .arg(stats.exactEndgames);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("GuanDanSelfPlay");
+    qInstallMessageHandler(messageHandler);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("掼蛋自对弈：两种AI策略进行整场比赛(从2打到过A)");
+    parser.addHelpOption();
+    QCommandLineOption matchesOption(QStringList() << "n" << "matches", "比赛场数(默认100)", "count", "100");
+    QCommandLineOption policyAOption(QStringList() << "a", "策略A：random、normal、hard[:ms]、expert[:ms](默认normal)", "policy", "normal");
+    QCommandLineOption policyBOption(QStringList() << "b", "策略B(默认normal)", "policy", "normal");
+    QCommandLineOption threadsOption(QStringList() << "j" << "threads", "并行的比赛数(默认CPU核数)", "count", "0");
+    QCommandLineOption searchThreadsOption("search-threads", "每次搜索的线程数(默认1)", "count", "1");
+    QCommandLineOption hashOption("hash", "搜索置换表大小(MB，默认64)", "mb", "64");
+    QCommandLineOption cardsOption("cards", "每人发牌张数(默认27)", "count", "27");
+    QCommandLineOption seedOption("seed", "总种子(默认随机，报告中给出，可用于重放)", "seed");
+    QCommandLineOption recordOption("record", "把完成的比赛追加记录到文件(格式见GameRecord)", "file");
+    QCommandLineOption verboseOption(QStringList() << "v" << "verbose", "输出规则引擎和AI的调试信息");
+    parser.addOptions({ matchesOption, policyAOption, policyBOption, threadsOption,
+        searchThreadsOption, hashOption, cardsOption, seedOption, recordOption, verboseOption });
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    g_verbose = parser.isSet(verboseOption);
+
+    SelfPlay::Config config;
+    QString error;
+    if (!SelfPlay::Policy::parse(parser.value(policyAOption), &config.policies[0], &error)
+        || !SelfPlay::Policy::parse(parser.value(policyBOption), &config.policies[1], &error)) {
+        err << error << '\n';
+        return 1;
+    }
+    config.matches = parser.value(matchesOption).toInt();
+    config.threads = parser.value(threadsOption).toInt();
+    config.searchThreads = qMax(1, parser.value(searchThreadsOption).toInt());
+    config.cardsPerPlayer = parser.value(cardsOption).toInt();
+    if (config.matches <= 0 || config.cardsPerPlayer <= 0 || config.cardsPerPlayer > 27) {
+        err << "比赛场数须为正数，每人发牌张数须在1~27之间\n";
+        return 1;
+    }
+    if (parser.isSet(seedOption)) {
+        bool ok = false;
+        config.seed = parser.value(seedOption).toULongLong(&ok, 0);
+        if (!ok) {
+            err << "种子须为整数\n";
+            return 1;
+        }
+    }
+    else {
+        config.seed = QRandomGenerator::global()->generate64();
+    }
+    QFile recordFile;
+    if (parser.isSet(recordOption)) {
+        recordFile.setFileName(parser.value(recordOption));
+        if (!recordFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            err << QString("无法打开记录文件%1：%2\n").arg(recordFile.fileName()).arg(recordFile.errorString());
+            return 1;
+        }
+        config.record = &recordFile;
+    }
+    TranspositionTable::configureShared(qMax(1, parser.value(hashOption).toInt()));
+
+    const SelfPlay::Report report = SelfPlay::run(config);
+
+    const int games = report.completedMatches;
+    out << QString("比赛       %1场完成，%2场异常放弃，%3个线程，用时%4秒\n")
+        .arg(games).arg(report.abortedMatches).arg(report.threads).arg(report.elapsedSeconds, 0, 'f', 2);
+    out << QString("吞吐量     %1场/秒，%2局/秒\n")
+        .arg(games / qMax(1e-9, report.elapsedSeconds), 0, 'f', 2)
+        .arg(report.rounds / qMax(1e-9, report.elapsedSeconds), 0, 'f', 1);
+    out << QString("种子       %1，对局摘要 %2\n").arg(config.seed).arg(report.digest, 16, 16, QChar('0'));
+    if (config.record) {
+        out << QString("记录       %1字节，每回合%2字节\n").arg(report.recordBytes)
+            .arg(report.turns > 0 ? double(report.recordBytes) / report.turns : 0.0, 0, 'f', 2);
+    }
+    if (games > 0) {
+        out << QString("平均       每场%1局，每场%2回合，每局%3回合\n")
+            .arg(double(report.rounds) / games, 0, 'f', 2)
+            .arg(double(report.turns) / games, 0, 'f', 1)
+            .arg(report.rounds > 0 ? double(report.turns) / report.rounds : 0.0, 0, 'f', 1);
+    }
+    if (report.table.probes > 0) {
+        out << QString("置换表     %1MB，查询%2次，命中%3次，命中率%4%，填充率%5%\n")
+            .arg(report.table.sizeMb).arg(report.table.probes).arg(report.table.hits)
+            .arg(100.0 * report.table.hitRate, 0, 'f', 1).arg(100.0 * report.table.fillRate, 0, 'f', 1);
+    }
+    printPolicy(out, "A", config.policies[0], report.policies[0], games);
+    printPolicy(out, "B", config.policies[1], report.policies[1], games);
+    return report.abortedMatches > 0 ? 2 : 0;
+}